@@ -30,6 +30,11 @@ BoXZYLBuffer_t BoXZYLBuffer;
 uint8_t BoXZYLBuffer_t::elts[BOXZY_LASER_MAX_L_ELTS];
 
 static bool is_laser_on_flag;
+static uint8_t laser_power;
+#if FEATURE_LIVE_OVERRIDES
+static uint8_t laser_multiply = 100;
+static uint16_t laser_scale = 128; // laser_multiply * 128 / 100
+#endif
 static bool is_fan_on_flag;
 
 static void shut_fan_off(void)
@@ -57,6 +62,7 @@ void manage_laser(void)
 
 void set_laser(uint8_t power)
 {
+    laser_power = power;
     is_laser_on_flag = (power > 0.0);
 
     if (is_laser_on_flag)
@@ -64,9 +70,39 @@ void set_laser(uint8_t power)
         turn_fan_on();
     }
 
+#if FEATURE_LIVE_OVERRIDES
+    uint16_t scaled = ((uint16_t)power * laser_scale) >> 7;
+    analogWrite(FAN_PIN, scaled > 255 ? 255 : scaled);
+#else
     analogWrite(FAN_PIN, power);
+#endif
 }
 
+uint8_t get_laser(void)
+{
+    return laser_power;
+}
+
+#if FEATURE_LIVE_OVERRIDES
+/** Sets the laser power multiplier in percent. A burning laser changes power immediately. */
+void set_laser_multiply(uint8_t pct)
+{
+    if(pct < 10) pct = 10;
+    if(pct > 200) pct = 200;
+    BEGIN_INTERRUPT_PROTECTED
+    laser_multiply = pct;
+    laser_scale = ((uint16_t)pct << 7) / 100;
+    if(is_laser_on_flag)
+        set_laser(laser_power);
+    END_INTERRUPT_PROTECTED
+}
+
+uint8_t get_laser_multiply(void)
+{
+    return laser_multiply;
+}
+#endif
+
 void disable_laser(void)
 {
     set_laser(0);
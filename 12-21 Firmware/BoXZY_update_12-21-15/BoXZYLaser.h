@@ -43,6 +43,11 @@ static inline uint8_t laser_pct_to_power(float pct)
 void manage_laser(void);
 
 void set_laser(uint8_t power);
+uint8_t get_laser(void);
+#if FEATURE_LIVE_OVERRIDES
+void set_laser_multiply(uint8_t pct);
+uint8_t get_laser_multiply(void);
+#endif
 
 void disable_laser(void);
 
@@ -87,19 +92,30 @@ class BoXZYLBuffer_t
             return (oldest_index == write_index);
         }
 
+        /// Number of power values that can still be committed
+        inline uint16_t free_elts(void)
+        {
+            uint16_t used = committed_index;
+            if (used < oldest_index)
+            {
+                used += COUNTOF(elts);
+            }
+            return COUNTOF(elts) - 1 - (used - oldest_index);
+        }
+
         void reset(void)
         {
             oldest_index = unclaimed_index = committed_index = write_index = 0;
         }
 
-        inline void append_pct(float pct)
+        inline void append_power(uint8_t power)
         {
             uint16_t p = write_index;
             inc(&p);
 
             if (p != oldest_index)
             {
-                elts[write_index] = laser_pct_to_power(pct);
+                elts[write_index] = power;
                 write_index = p;
             }
         }
@@ -46,9 +46,16 @@ Implemented Codes
 - G30 P<0..3> - Single z-probe at current position P = 1 first measurement, P = 2 Last measurement P = 0 or 3 first and last measurement
 - G31 - Write signal of probe sensor
 - G32 S<0..2> P<0..1> - Autolevel print bed. S = 1 measure zLength, S = 2 Measue and store new zLength
+- G33 S<0..2> - Measure bed height map with the z probe. S = 1 activate it, S = 2 activate and store it in EEPROM
+- G80 - Cancel drilling cycle
+- G81 X<x> Y<y> Z<bottom> R<retract plane> F<feedrate> - Drill cycle. Following blocks with only X/Y drill more holes
+- G82 X<x> Y<y> Z<bottom> R<retract plane> P<ms> F<feedrate> - Drill cycle with dwell at the bottom
+- G83 X<x> Y<y> Z<bottom> R<retract plane> Q<peck depth> F<feedrate> - Peck drill cycle, retracts to R after each peck
 - G90 - Use absolute coordinates
 - G91 - Use relative coordinates
 - G92 - Set current position to cordinates given
+- G98 - Drilling cycles retract to the start level (default)
+- G99 - Drilling cycles retract to the R plane
 - G131 - set extruder offset position to 0 - needed for calibration with G132
 - G132 - calibrate endstop positions. Call this, after calling G131 and after centering the extruder holder.
 
@@ -84,15 +91,25 @@ Custom M Codes
         or use S<seconds> to specify an inactivity timeout, after which the steppers will be disabled.  S0 to disable the timeout.
 - M85  - Set inactivity shutdown timer with parameter S<seconds>. To disable set zero (default)
 - M92  - Set axisStepsPerMM - same syntax as G92
-- M99 S<delayInSec> X0 Y0 Z0 - Disable motors for S seconds (default 10) for given axis.
+- M96 [P<name>] [S1] - List stored subprograms and free EEPROM space. P deletes a subprogram, S1 erases all.
+- M97 P<name> - Store the following commands as subprogram <name> in EEPROM until M99. Names may be numbers.
+- M98 P<name> L<count> X<offset> Y<offset> Z<offset> - Call a subprogram count times (default 1) with its origin
+        moved by the given offsets. Calls can be nested. M98PSTRTTIME.SUBL1 is accepted without blanks.
+- M99 S<delayInSec> X0 Y0 Z0 - Disable motors for S seconds (default 10) for given axis. Ends a M97 recording.
 - M104 S<temp> T<extruder> P1 F1 - Set temperature without wait. P1 = wait for moves to finish, F1 = beep when temp. reached first time
 - M105 X0 - Get temperatures. If X0 is added, the raw analog values are also written.
+- M111 S<bits> - Set debug level. 1 = echo, 2 = info, 4 = errors, 8 = dry run, 16 = communication only, 32 = no moves,
+        64 = estimate print time. Moves are planned at full speed without stepping, layer times are reported after each
+        positive z move and clearing bit 64 reports the total time and restores the position from before the estimation.
 - M112 - Emergency kill
 - M115- Capabilities string
 - M116 - Wait for all temperatures in a +/- 1 degree range
 - M117 <message> - Write message in status row on lcd
 - M119 - Report endstop status
 - M140 S<temp> F1 - Set bed target temp, F1 makes a beep when temperature is reached the first time
+- M155 S<ms> P<fields> - Print a status line every S ms (min. 100), S0 stops it. Without S it is printed once.
+        P selects the parts: 1 temperatures, 2 position, 4 feedrate/laser overrides, 8 queued moves/commands/laser powers,
+        16 head type. Default 31.
 - M190 - Wait for bed current temp to reach target temp.
 - M201 - Set max acceleration in units/s^2 for print moves (M201 X1000 Y1000)
 - M202 - Set max acceleration in units/s^2 for travel moves (M202 X1000 Y1000)
@@ -103,6 +120,7 @@ Custom M Codes
 - M207 X<XY jerk> Z<Z Jerk> E<ExtruderJerk> - Changes current jerk values, but do not store them in eeprom.
 - M220 S<Feedrate multiplier in percent> - Increase/decrease given feedrate
 - M221 S<Extrusion flow multiplier in percent> - Increase/decrease given flow rate
+- M222 S<Laser power multiplier in percent> - Scale laser power, 10-200%. Takes effect immediately.
 - M231 S<OPS_MODE> X<Min_Distance> Y<Retract> Z<Backlash> F<ReatrctMove> - Set OPS parameter
 - M232 - Read and reset max. advance values
 - M233 X<AdvanceK> Y<AdvanceL> - Set temporary advance K-value to X and linear term advanceL to Y
@@ -118,10 +136,29 @@ Custom M Codes
 - M400 - Wait until move buffers empty.
 - M401 - Store x, y and z position.
 - M402 - Go to stored position. If X, Y or Z is specified, only these coordinates are used. F changes feedrate fo rthat move.
+- M405 [S1] - Report motion statistics: stepper stalls on blocked moves, queue underruns, moves slowed to keep the queue filled,
+        average time between queued moves in ms and dropped planner passes. S1 resets the counters.
+- M406 [S1] - Report homing statistics per axis: last, smallest and largest deviation of the endstop position from
+        the expected home position in mm and the number of homings. S1 resets them.
+- M407 S<0/1> - Append free space to every ok: P planner moves, B commands, R serial bytes, L laser powers.
+        Without S the free space is reported once.
+- M408 [S1] - Report serial receive errors: UART overruns, frame errors and bytes dropped by a full receive buffer,
+        commands received, resends requested and output lines dropped because the send buffer was full.
+        S1 resets the counters. Send M408 S1 before and M408 after a job to measure the streaming rate.
+- M420 S<0/1> - Enable/disable bed height map. Without S the height map is reported.
+- M421 I<x index> J<y index> Z<height> - Set height map point in mm. Without parameter the height map is cleared. Store with M500.
 - M500 Store settings to EEPROM
 - M501 Load settings from EEPROM
 - M502 Reset settings to the one in configuration.h. Does not store values in EEPROM!
 - M908 P<address> S<value> : Set stepper current for digipot (RAMBO board)
+
+Real-time bytes (ASCII mode only, between lines, executed on receive and not queued):
+- !    - Feed hold. Decelerates and stops inside the current move.
+- ~    - Cycle start. Resumes after a feed hold.
+- 0x18 - Soft reset (Ctrl-X), same as M112.
+- ?    - Report state, queue fill and position.
+- 0x14/0x15/0x16 - Feedrate multiplier 100%, +10%, -10%. Also affects moves already in the queue.
+- 0x1C/0x1D/0x1E - Laser power multiplier 100%, +10%, -10%.
 */
 
 #include "Repetier.h"
@@ -24,6 +24,11 @@
 const int sensitive_pins[] PROGMEM = SENSITIVE_PINS; // Sensitive pin list for M42
 int Commands::lowestRAMValue = MAX_RAM;
 int Commands::lowestRAMValueSend = MAX_RAM;
+#if FEATURE_AUTO_REPORT
+uint16_t Commands::autoReportInterval = 0;
+uint8_t Commands::autoReportFields = AUTO_REPORT_ALL;
+millis_t Commands::lastAutoReport = 0;
+#endif
 
 void Commands::commandLoop()
 {
@@ -55,6 +60,11 @@ void Commands::commandLoop()
 #endif
             }
             else
+#endif
+#if FEATURE_SUBPROGRAMS
+            if(Subprograms::isRecording())
+                Subprograms::record(code);
+            else
 #endif
                 Commands::executeGCode(code);
             code->popCurrentCommand();
@@ -65,9 +75,45 @@ void Commands::commandLoop()
 
 void Commands::checkForPeriodicalActions()
 {
+#if FEATURE_STEP_SEGMENTS
+    PrintLine::compileSegments();
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    if(Printer::realtimeStatusRequested)
+    {
+        Printer::realtimeStatusRequested = 0;
+        Printer::reportRealtimeStatus();
+    }
+#if FEATURE_LIVE_OVERRIDES
+    if(Printer::realtimeFeedrateMultiply || Printer::realtimeLaserMultiply)
+    {
+        int16_t f;
+        uint8_t l;
+        BEGIN_INTERRUPT_PROTECTED
+        f = Printer::realtimeFeedrateMultiply;
+        l = Printer::realtimeLaserMultiply;
+        Printer::realtimeFeedrateMultiply = 0;
+        Printer::realtimeLaserMultiply = 0;
+        END_INTERRUPT_PROTECTED
+        if(f) changeFeedrateMultiply(f);
+        if(l) changeLaserMultiply(l);
+    }
+#endif
+#endif
+#if FEATURE_TIME_ESTIMATION
+    if(Printer::estimateLayerDone)
+        Printer::reportLayerEstimate();
+#endif
     if(!executePeriodical) return;
     executePeriodical=0;
     Extruder::manageTemperatures();
+#if FEATURE_AUTO_REPORT
+    if(autoReportInterval && HAL::timeInMilliseconds() - lastAutoReport >= autoReportInterval)
+    {
+        lastAutoReport = HAL::timeInMilliseconds();
+        autoReport();
+    }
+#endif
     if(--counter250ms==0)
     {
         if(manageMonitor<=1+NUM_EXTRUDER)
@@ -123,6 +169,11 @@ void Commands::waitUntilEndOfAllBuffers()
 #endif
             }
             else
+#endif
+#if FEATURE_SUBPROGRAMS
+            if(Subprograms::isRecording())
+                Subprograms::record(code);
+            else
 #endif
                 Commands::executeGCode(code);
             code->popCurrentCommand();
@@ -144,6 +195,70 @@ void Commands::printCurrentPosition()
     //Com::printF(PSTR("OffX:"),Printer::offsetX); // to debug offset handling
     //Com::printFLN(PSTR(" OffY:"),Printer::offsetY);
 }
+#if FEATURE_AUTO_REPORT
+/** \brief Prints the status line selected by autoReportFields.
+
+The line is dropped if the send buffer is full, the next one follows autoReportInterval later. */
+void Commands::autoReport()
+{
+    Com::setDroppable();
+    Com::printF(Com::tAutoReport);
+    if(autoReportFields & AUTO_REPORT_TEMPERATURES)
+    {
+        for(uint8_t i = 0; i < NUM_TEMPERATURE_LOOPS; i++)
+        {
+            TemperatureController *act = tempController[i];
+            if(i < NUM_EXTRUDER)
+            {
+                Com::printF(Com::tSpaceT,(int)i);
+                Com::printF(Com::tColon,act->currentTemperatureC);
+            }
+            else
+                Com::printF(Com::tSpaceBColon,act->currentTemperatureC);
+            Com::printF(Com::tSlash,act->targetTemperatureC,0);
+        }
+    }
+    if(autoReportFields & AUTO_REPORT_POSITION)
+    {
+        float pos[3];
+        Printer::realPosition(pos[X_AXIS],pos[Y_AXIS],pos[Z_AXIS]);
+        float scale = (Printer::unitIsInches ? 0.03937 : 1);
+        Com::printF(Com::tSpaceXColon,(pos[X_AXIS] + Printer::coordinateOffset[X_AXIS]) * scale);
+        Com::printF(Com::tSpaceYColon,(pos[Y_AXIS] + Printer::coordinateOffset[Y_AXIS]) * scale);
+        Com::printF(Com::tSpaceZColon,(pos[Z_AXIS] + Printer::coordinateOffset[Z_AXIS]) * scale);
+    }
+    if(autoReportFields & AUTO_REPORT_OVERRIDES)
+    {
+        int feed = Printer::feedrateMultiply;
+        int laser = get_laser_multiply();
+#if FEATURE_REALTIME_COMMANDS && FEATURE_LIVE_OVERRIDES
+        // Overrides requested with real-time bytes are in effect before checkForPeriodicalActions applies them
+        int16_t f;
+        uint8_t l;
+        BEGIN_INTERRUPT_PROTECTED
+        f = Printer::realtimeFeedrateMultiply;
+        l = Printer::realtimeLaserMultiply;
+        END_INTERRUPT_PROTECTED
+        if(f) feed = RMath::min(RMath::max((int)f,25),500);
+        if(l) laser = RMath::min(RMath::max((int)l,10),200);
+#endif
+        Com::printF(Com::tAutoFeedrate,feed);
+        Com::printF(Com::tAutoLaser,laser);
+    }
+    if(autoReportFields & AUTO_REPORT_QUEUES)
+    {
+        Com::printF(Com::tAutoMoves,(int)PrintLine::linesCount);
+        Com::printF(Com::tAutoCommands,(int)GCode::queuedCommands());
+        Com::printF(Com::tAutoPowers,(int)(BOXZY_LASER_MAX_L_ELTS - 1 - BoXZYLBuffer.free_elts()));
+    }
+    if(autoReportFields & AUTO_REPORT_HEAD)
+    {
+        Com::printF(Com::tAutoHead);
+        Com::print("UPML"[Printer::BoXZY_head]);
+    }
+    Com::println();
+}
+#endif
 void Commands::printTemperatures(bool showRaw)
 {
     float temp = Extruder::current->tempControl.currentTemperatureC;
@@ -190,8 +305,12 @@ void Commands::changeFeedrateMultiply(int factor)
 {
     if(factor<25) factor=25;
     if(factor>500) factor=500;
-    Printer::feedrate *= (float)factor/(float)Printer::feedrateMultiply;
+    float ratio = (float)factor/(float)Printer::feedrateMultiply;
+    Printer::feedrate *= ratio;
     Printer::feedrateMultiply = factor;
+#if FEATURE_LIVE_OVERRIDES
+    PrintLine::changeSpeedOverride(ratio);
+#endif
     Com::printFLN(Com::tSpeedMultiply,factor);
 }
 void Commands::changeFlowateMultiply(int factor)
@@ -201,6 +320,15 @@ void Commands::changeFlowateMultiply(int factor)
     Printer::extrudeMultiply = factor;
     Com::printFLN(Com::tFlowMultiply,factor);
 }
+#if FEATURE_LIVE_OVERRIDES
+void Commands::changeLaserMultiply(int factor)
+{
+    if(factor<10) factor=10;
+    if(factor>200) factor=200;
+    set_laser_multiply(factor);
+    Com::printFLN(Com::tLaserMultiply,factor);
+}
+#endif
 void Commands::setFanSpeed(int speed,bool wait)
 {
 #if FAN_PIN>=0
@@ -421,6 +549,107 @@ void microstepInit()
 #endif
 }
 
+/** Waits ms milliseconds after all moves are finished, communication and temperature control continue. */
+static void dwell(uint32_t ms)
+{
+    Commands::waitUntilEndOfAllMoves();
+#if FEATURE_TIME_ESTIMATION
+    if(Printer::debugEstimateTime()) // No moves left, so the interrupt does not touch the sums
+    {
+        Printer::estimatedTime += ms * 0.001f;
+        Printer::estimatedLayerTime += ms * 0.001f;
+        return;
+    }
+#endif
+    ms += HAL::timeInMilliseconds();  // keep track of when we started waiting
+    while((uint32_t)(ms-HAL::timeInMilliseconds())  < 2000000000 )
+    {
+        GCode::readFromSerial();
+        Commands::checkForPeriodicalActions();
+    }
+}
+
+#if FEATURE_CANNED_CYCLES
+static uint8_t cannedCycle = 0;       ///< Active drilling cycle 81..83, 0 = none (G80)
+static bool cannedRetractToR = false; ///< G99 retracts to the R plane, G98 to the start level
+static float cannedInitialZ;          ///< Z level when the cycle was started
+static float cannedZ;                 ///< Hole bottom
+static float cannedR;                 ///< Retract plane
+static float cannedQ;                 ///< Peck depth
+static uint32_t cannedDwell;          ///< Dwell at the bottom in ms
+
+/** Rapid or feed move in printer coordinates, keeps lastCmdPos in sync. */
+static void cannedMove(float x,float y,float z,float f)
+{
+    Printer::moveToReal(x,y,z,IGNORE_COORDINATE,f);
+    Printer::lastCmdPos[X_AXIS] = Printer::currentPosition[X_AXIS];
+    Printer::lastCmdPos[Y_AXIS] = Printer::currentPosition[Y_AXIS];
+    Printer::lastCmdPos[Z_AXIS] = Printer::currentPosition[Z_AXIS];
+}
+
+/**
+  Stores the parameter of a G81/G82/G83 block. Values not given are kept from the last cycle.
+  In relative mode R is measured from the start level and Z from the R plane.
+*/
+static void setCannedCycle(GCode *com)
+{
+    float feedrate = Printer::feedrate;
+    if(!cannedCycle) // Start level is kept until G80, also when switching between cycles
+        cannedInitialZ = Printer::lastCmdPos[Z_AXIS];
+    if(com->hasR())
+        cannedR = (Printer::relativeCoordinateMode ? cannedInitialZ + Printer::convertToMM(com->R) : Printer::convertToMM(com->R) - Printer::coordinateOffset[Z_AXIS]);
+    if(com->hasZ())
+        cannedZ = (Printer::relativeCoordinateMode ? cannedR + Printer::convertToMM(com->Z) : Printer::convertToMM(com->Z) - Printer::coordinateOffset[Z_AXIS]);
+    if(com->hasQ()) cannedQ = fabs(Printer::convertToMM(com->Q));
+    if(com->hasP()) cannedDwell = com->P;
+    if(com->hasF())
+    {
+        if(Printer::unitIsInches)
+            feedrate = com->F * 0.0042333f * (float)Printer::feedrateMultiply;
+        else
+            feedrate = com->F * (float)Printer::feedrateMultiply * 0.00016666666f;
+    }
+    Printer::feedrate = feedrate;
+    cannedCycle = com->G;
+}
+
+/** Drills one hole at the X/Y of com with the active cycle. */
+static void drillCannedHole(GCode *com)
+{
+    float x = Printer::lastCmdPos[X_AXIS],y = Printer::lastCmdPos[Y_AXIS];
+    if(com->hasX()) x = (Printer::relativeCoordinateMode ? x + Printer::convertToMM(com->X) : Printer::convertToMM(com->X) - Printer::coordinateOffset[X_AXIS]);
+    if(com->hasY()) y = (Printer::relativeCoordinateMode ? y + Printer::convertToMM(com->Y) : Printer::convertToMM(com->Y) - Printer::coordinateOffset[Y_AXIS]);
+    if(!Printer::isPositionAllowed(x,y,cannedZ)) return;
+    float rapidXY = RMath::min(Printer::maxFeedrate[X_AXIS],Printer::maxFeedrate[Y_AXIS]);
+    float rapidZ = Printer::maxFeedrate[Z_AXIS];
+    float feed = Printer::feedrate;
+    if(Printer::lastCmdPos[Z_AXIS] < cannedR)
+        cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,cannedR,rapidZ);
+    cannedMove(x,y,IGNORE_COORDINATE,rapidXY);
+    cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,cannedR,rapidZ);
+    if(cannedCycle == 83 && cannedQ > 0)
+    {
+        float depth = cannedR;
+        while(depth > cannedZ)
+        {
+            if(depth < cannedR) // Back into the hole to just above the last depth
+                cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,depth + CANNED_PECK_CLEARANCE,rapidZ);
+            depth = RMath::max(depth - cannedQ,cannedZ);
+            cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,depth,feed);
+            cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,cannedR,rapidZ); // Clear chips
+        }
+    }
+    else
+    {
+        cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,cannedZ,feed);
+        if(cannedCycle == 82 && cannedDwell)
+            dwell(cannedDwell);
+    }
+    cannedMove(IGNORE_COORDINATE,IGNORE_COORDINATE,(cannedRetractToR ? cannedR : RMath::max(cannedInitialZ,cannedR)),rapidZ);
+    Printer::feedrate = feed;
+}
+#endif // FEATURE_CANNED_CYCLES
+
 
 
 /**
@@ -438,6 +667,13 @@ void Commands::executeGCode(GCode *com)
             return;
         }
     }
+#endif
+#if FEATURE_BINARY_V3
+    if(com->isBatch())
+    {
+        GCode::executeBatch(com);
+        return;
+    }
 #endif
     if(com->hasG())
     {
@@ -448,11 +684,18 @@ void Commands::executeGCode(GCode *com)
             if(com->hasS())
                 Printer::setNoDestinationCheck(com->S!=0);
             if(Printer::setDestinationStepsFromGCode(com)) // For X Y Z E F L
+            {
 #if NONLINEAR_SYSTEM
                 PrintLine::queueDeltaMove(ALWAYS_CHECK_ENDSTOPS, true, true);
 #else
-                PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS,true);
+#if FEATURE_MESH_LEVELING
+                if(Printer::isMeshActive())
+                    PrintLine::queueMeshMove(ALWAYS_CHECK_ENDSTOPS,true);
+                else
+#endif
+                    PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS,true);
 #endif
+            }
             if (com->hasL())
             {
                 Printer::is_L_in_focus_mode = false;
@@ -582,16 +825,10 @@ void Commands::executeGCode(GCode *com)
         }
 #endif
         case 4: // G4 dwell
-            Commands::waitUntilEndOfAllMoves();
             codenum = 0;
             if(com->hasP()) codenum = com->P; // milliseconds to wait
             if(com->hasS()) codenum = com->S * 1000; // seconds to wait
-            codenum += HAL::timeInMilliseconds();  // keep track of when we started waiting
-            while((uint32_t)(codenum-HAL::timeInMilliseconds())  < 2000000000 )
-            {
-                GCode::readFromSerial();
-                Commands::checkForPeriodicalActions();
-            }
+            dwell(codenum);
             break;
         case 20: // Units to inches
             Printer::unitIsInches = 1;
@@ -738,6 +975,49 @@ void Commands::executeGCode(GCode *com)
         }
         break;
 #endif
+#if FEATURE_MESH_LEVELING
+        case 33: // G33 S<0..2> Measure height map, S1 activates it, S2 also stores it in EEPROM
+        {
+            bool oldMesh = Printer::isMeshActive();
+#if FEATURE_AUTOLEVEL
+            bool oldAutolevel = Printer::isAutolevelActive();
+#endif
+            float oldFeedrate = Printer::feedrate;
+            bool ok = Printer::probeMesh();
+#if FEATURE_AUTOLEVEL
+            Printer::setAutolevelActive(oldAutolevel);
+#endif
+            Printer::feedrate = oldFeedrate;
+            if(ok && com->hasS() && com->S > 0)
+            {
+                Printer::setMeshActive(true);
+                if(com->S == 2)
+                    EEPROM::storeDataIntoEEPROM();
+            }
+            else
+                Printer::setMeshActive(ok && oldMesh);
+            printCurrentPosition();
+        }
+        break;
+#endif
+#endif
+#if FEATURE_CANNED_CYCLES
+        case 80: // G80 Cancel drilling cycle
+            cannedCycle = 0;
+            break;
+        case 81: // G81 Drill
+        case 82: // G82 Drill with dwell
+        case 83: // G83 Peck drill
+            setCannedCycle(com);
+            if(com->hasX() || com->hasY())
+                drillCannedHole(com);
+            break;
+        case 98: // G98 Retract to start level
+            cannedRetractToR = false;
+            break;
+        case 99: // G99 Retract to R plane
+            cannedRetractToR = true;
+            break;
 #endif
         case 90: // G90
             Printer::relativeCoordinateMode = false;
@@ -967,6 +1247,16 @@ void Commands::executeGCode(GCode *com)
         case 105: // M105  get temperature. Always returns the current temperature, doesn't wait until move stopped
             printTemperatures(com->hasX());
             break;
+#if FEATURE_AUTO_REPORT
+        case 155: // M155 S<ms> P<fields> Print status line every S ms, S0 stops it
+            if(com->hasP())
+                autoReportFields = com->P & AUTO_REPORT_ALL;
+            if(com->hasS())
+                autoReportInterval = (com->S <= 0 ? 0 : (com->S < 100 ? 100 : (com->S > 60000 ? 60000 : com->S)));
+            else
+                autoReport();
+            break;
+#endif
         case 109: // M109 - Wait for extruder heater to reach target.
 #if NUM_EXTRUDER>0
         {
@@ -993,6 +1283,7 @@ void Commands::executeGCode(GCode *com)
                 currentTime = HAL::timeInMilliseconds();
                 if( (currentTime - printedTime) > 1000 )   //Print Temp Reading every 1 second while heating up.
                 {
+                    Com::setDroppable();
                     printTemperatures();
                     printedTime = currentTime;
                 }
@@ -1042,6 +1333,7 @@ void Commands::executeGCode(GCode *com)
             {
                 if( (HAL::timeInMilliseconds()-codenum) > 1000 )   //Print Temp Reading every 1 second while heating up.
                 {
+                    Com::setDroppable();
                     printTemperatures();
                     codenum = HAL::timeInMilliseconds();
                 }
@@ -1061,6 +1353,7 @@ void Commands::executeGCode(GCode *com)
                     allReached = true;
                     if( (HAL::timeInMilliseconds()-codenum) > 1000 )   //Print Temp Reading every 1 second while heating up.
                     {
+                        Com::setDroppable();
                         printTemperatures();
                         codenum = HAL::timeInMilliseconds();
                     }
@@ -1164,6 +1457,23 @@ void Commands::executeGCode(GCode *com)
                 Extruder::selectExtruderById(Extruder::current->id);
             }
             break;
+#if FEATURE_SUBPROGRAMS
+        case 96: // M96 [P<name>] [S1] - List subprograms, delete one or erase all
+            if(com->hasString())
+                Subprograms::erase(com->text);
+            else if(com->hasS() && com->S == 1)
+                Subprograms::erase(NULL);
+            Subprograms::list();
+            break;
+        case 97: // M97 P<name> - Record subprogram until M99
+            if(com->hasString())
+                Subprograms::startRecording(com->text);
+            break;
+        case 98: // M98 P<name> L<count> X<offset> Y<offset> Z<offset> - Call subprogram
+            if(com->hasString())
+                Subprograms::call(com);
+            break;
+#endif
         case 99: // M99 S<time>
             {
                 millis_t wait = 10000;
@@ -1191,6 +1501,16 @@ void Commands::executeGCode(GCode *com)
             }
             break;
         case 111:
+#if FEATURE_TIME_ESTIMATION
+            if(com->hasS() && ((com->S & 64) != 0) != Printer::debugEstimateTime())
+            {
+                Commands::waitUntilEndOfAllMoves(); // Queued moves finish in the old mode
+                if(Printer::debugEstimateTime())
+                    Printer::stopTimeEstimate();
+                else
+                    Printer::startTimeEstimate();
+            }
+#endif
             if(com->hasS()) Printer::debugLevel = com->S;
             if(Printer::debugDryrun())   // simulate movements without printing
             {
@@ -1324,6 +1644,11 @@ void Commands::executeGCode(GCode *com)
         case 221: // M221 S<Extrusion flow multiplier in percent>
             changeFlowateMultiply(com->getS(100));
             break;
+#if FEATURE_LIVE_OVERRIDES
+        case 222: // M222 S<Laser power multiplier in percent>
+            changeLaserMultiply(com->getS(100));
+            break;
+#endif
 #ifdef USE_ADVANCE
         case 223: // Extruder interrupt test
             if(com->hasS())
@@ -1370,6 +1695,70 @@ void Commands::executeGCode(GCode *com)
         case 402: // Go to stored position
             Printer::GoToMemoryPosition(com->hasX(),com->hasY(),com->hasZ(),com->hasE(),(com->hasF() ? com->F : Printer::feedrate));
             break;
+#endif
+        case 405: // Motion statistics
+        {
+            uint16_t stalls,retries;
+            BEGIN_INTERRUPT_PROTECTED
+            stalls = PrintLine::blockedStalls;
+            retries = PrintLine::plannerRetries;
+            if(com->hasS() && com->S == 1)
+            {
+                PrintLine::blockedStalls = 0;
+                PrintLine::plannerRetries = 0;
+            }
+            END_INTERRUPT_PROTECTED
+            Com::printF(Com::tBlockedStalls,(int32_t)stalls);
+#if FEATURE_QUEUE_CONTROL
+            Com::printF(Com::tQueueUnderruns,(int32_t)PrintLine::queueUnderruns);
+            Com::printF(Com::tThrottledMoves,(int32_t)PrintLine::throttledMoves);
+            Com::printF(Com::tMoveInterval,PrintLine::arrivalInterval * 0.0625f,1);
+            if(com->hasS() && com->S == 1)
+            {
+                PrintLine::queueUnderruns = 0;
+                PrintLine::throttledMoves = 0;
+            }
+#endif
+            Com::printFLN(Com::tPlannerRetries,(int32_t)retries);
+        }
+        break;
+#if FEATURE_FAST_HOMING
+        case 406: // Homing statistics
+            Printer::reportHomingStatistics();
+            if(com->hasS() && com->S == 1)
+                Printer::resetHomingStatistics();
+            break;
+#endif
+#if FEATURE_OK_BUFFER_SPACE
+        case 407: // M407 S<0/1> Report free buffer space with every ok, report it once without S
+            if(com->hasS())
+                GCode::reportBufferSpace = (com->S != 0);
+            else
+            {
+                Com::printF(Com::tOk);
+                GCode::printBufferSpace();
+                Com::println();
+            }
+            break;
+#endif
+#if FEATURE_SERIAL_ERRORS
+        case 408: // M408 [S1] Report serial receive errors, S1 resets the counters
+            HAL::reportSerialErrors(com->hasS() && com->S == 1);
+            break;
+#endif
+#if FEATURE_MESH_LEVELING
+        case 420: // M420 S<0/1> Enable/disable height map, report it without S
+            if(com->hasS())
+                Printer::setMeshActive(com->S != 0);
+            else
+                Printer::reportMesh();
+            break;
+        case 421: // M421 I<x index> J<y index> Z<height> Set height map point, without I/J/Z reset map
+            if(com->hasI() && com->hasJ() && com->hasZ())
+                Printer::setMeshHeight((int)com->I,(int)com->J,Printer::convertToMM(com->Z));
+            else if(!com->hasI() && !com->hasJ() && !com->hasZ())
+                Printer::resetMesh();
+            break;
 #endif
         case 908: // Control digital trimpot directly.
         {
@@ -1548,6 +1937,12 @@ void Commands::executeGCode(GCode *com)
         // data in the parsing stage and that data will be
         // consumed by the next G1/G3 executed.
     }
+#if FEATURE_CANNED_CYCLES
+    else if(cannedCycle && (com->hasX() || com->hasY()))
+    {
+        drillCannedHole(com); // X/Y only block repeats the drilling cycle
+    }
+#endif
     else
     {
         if(Printer::debugErrors())
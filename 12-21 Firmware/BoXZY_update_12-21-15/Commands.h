@@ -24,6 +24,13 @@
 #ifndef COMMANDS_H_INCLUDED
 #define COMMANDS_H_INCLUDED
 
+#define AUTO_REPORT_TEMPERATURES 1
+#define AUTO_REPORT_POSITION 2
+#define AUTO_REPORT_OVERRIDES 4
+#define AUTO_REPORT_QUEUES 8
+#define AUTO_REPORT_HEAD 16
+#define AUTO_REPORT_ALL 31
+
 class Commands
 {
 public:
@@ -37,13 +44,24 @@ public:
     static void setFanSpeed(int speed,bool wait); /// Set fan speed 0..255
     static void changeFeedrateMultiply(int factorInPercent);
     static void changeFlowateMultiply(int factorInPercent);
+#if FEATURE_LIVE_OVERRIDES
+    static void changeLaserMultiply(int factorInPercent);
+#endif
     static void reportPrinterUsage();
     static void emergencyStop();
     static void checkFreeMemory();
     static void writeLowestFreeRAM();
+#if FEATURE_AUTO_REPORT
+    static void autoReport();
+    static uint16_t autoReportInterval; ///< ms between status lines, 0 = off. Set with M155
+    static uint8_t autoReportFields; ///< AUTO_REPORT_* bits of the parts reported
+#endif
 private:
     static int lowestRAMValue;
     static int lowestRAMValueSend;
+#if FEATURE_AUTO_REPORT
+    static millis_t lastAutoReport;
+#endif
 };
 
 #endif // COMMANDS_H_INCLUDED
@@ -55,7 +55,33 @@ FSTRINGVALUE(Com::tP," P")
 FSTRINGVALUE(Com::tI," I")
 FSTRINGVALUE(Com::tJ," J")
 FSTRINGVALUE(Com::tR," R")
+#if FEATURE_CANNED_CYCLES
+FSTRINGVALUE(Com::tQ," Q")
+#endif
 FSTRINGVALUE(Com::tL," L")
+#if FEATURE_OK_BUFFER_SPACE
+FSTRINGVALUE(Com::tB," B")
+#endif
+#if FEATURE_AUTO_REPORT
+FSTRINGVALUE(Com::tAutoReport,"AR:")
+FSTRINGVALUE(Com::tAutoFeedrate," FR:")
+FSTRINGVALUE(Com::tAutoLaser," LR:")
+FSTRINGVALUE(Com::tAutoMoves," P:")
+FSTRINGVALUE(Com::tAutoCommands," C:")
+FSTRINGVALUE(Com::tAutoPowers," L:")
+FSTRINGVALUE(Com::tAutoHead," H:")
+#endif
+#if FEATURE_SERIAL_ERRORS
+FSTRINGVALUE(Com::tSerialErrors,"Serial baud:")
+FSTRINGVALUE(Com::tSerialOverrun," overrun:")
+FSTRINGVALUE(Com::tSerialFrame," frame:")
+FSTRINGVALUE(Com::tSerialDropped," dropped:")
+FSTRINGVALUE(Com::tSerialCommands," commands:")
+FSTRINGVALUE(Com::tSerialResends," resends:")
+#if FEATURE_OUTPUT_BUFFER
+FSTRINGVALUE(Com::tSerialLinesDropped," output lines dropped:")
+#endif
+#endif
 FSTRINGVALUE(Com::tSDReadError,"SD read error")
 FSTRINGVALUE(Com::tExpectedLine,"Error:expected line ")
 FSTRINGVALUE(Com::tGot," got ")
@@ -86,6 +112,38 @@ FSTRINGVALUE(Com::tSlash,"/")
 FSTRINGVALUE(Com::tSpaceSlash," /")
 FSTRINGVALUE(Com::tSpeedMultiply,"SpeedMultiply:")
 FSTRINGVALUE(Com::tFlowMultiply,"FlowMultiply:")
+#if FEATURE_LIVE_OVERRIDES
+FSTRINGVALUE(Com::tLaserMultiply,"LaserMultiply:")
+#endif
+FSTRINGVALUE(Com::tBlockedStalls,"Stalls:")
+FSTRINGVALUE(Com::tPlannerRetries," PlannerRetries:")
+#if FEATURE_QUEUE_CONTROL
+FSTRINGVALUE(Com::tQueueUnderruns," Underruns:")
+FSTRINGVALUE(Com::tThrottledMoves," Throttled:")
+FSTRINGVALUE(Com::tMoveInterval," MoveInterval:")
+#endif
+#if FEATURE_MESH_LEVELING
+FSTRINGVALUE(Com::tMeshEnabled,"Mesh leveling enabled")
+FSTRINGVALUE(Com::tMeshDisabled,"Mesh leveling disabled")
+FSTRINGVALUE(Com::tMeshRow,"Mesh Y")
+#endif
+#if FEATURE_FAST_HOMING
+FSTRINGVALUE(Com::tHomingAxis,"Homing ")
+FSTRINGVALUE(Com::tHomingCount," Count:")
+#endif
+#if FEATURE_TIME_ESTIMATION
+FSTRINGVALUE(Com::tEstimateLayer,"Estimate layer:")
+FSTRINGVALUE(Com::tEstimateTotal,"Estimated time:")
+FSTRINGVALUE(Com::tEstimateSeconds," s")
+#endif
+#if FEATURE_SUBPROGRAMS
+FSTRINGVALUE(Com::tSubprogram,"Subprogram ")
+FSTRINGVALUE(Com::tSubprogramUnknown,"Unknown subprogram ")
+FSTRINGVALUE(Com::tSubprogramFull,"Subprogram memory full")
+FSTRINGVALUE(Com::tSubprogramDepth,"Subprograms nested too deep")
+FSTRINGVALUE(Com::tSubprogramCorrupt,"Subprogram corrupt")
+FSTRINGVALUE(Com::tSubprogramFree,"Subprogram bytes free:")
+#endif
 FSTRINGVALUE(Com::tFanspeed,"Fanspeed:")
 FSTRINGVALUE(Com::tPrintedFilament,"Printed filament:")
 FSTRINGVALUE(Com::tPrintingTime,"Printing time:")
@@ -228,6 +286,14 @@ FSTRINGVALUE(Com::tZProbePrinterHeight,"Printer height:")
 #ifdef WAITING_IDENTIFIER
 FSTRINGVALUE(Com::tWait,WAITING_IDENTIFIER)
 #endif // WAITING_IDENTIFIER
+#if FEATURE_REALTIME_COMMANDS
+FSTRINGVALUE(Com::tRtStatus,"Status:")
+FSTRINGVALUE(Com::tRtIdle,"Idle")
+FSTRINGVALUE(Com::tRtRun,"Run")
+FSTRINGVALUE(Com::tRtHolding,"Holding")
+FSTRINGVALUE(Com::tRtHold,"Hold")
+FSTRINGVALUE(Com::tRtQueue," Q:")
+#endif
 #if EEPROM_MODE==0
 FSTRINGVALUE(Com::tNoEEPROMSupport,"No EEPROM support compiled.\r\n")
 #else
@@ -367,6 +433,40 @@ FSTRINGVALUE(Com::tCreationFailed,"Creation failed")
 FSTRINGVALUE(Com::tSDErrorCode,"SD errorCode:")
 #endif // SDSUPPORT
 
+#if FEATURE_OUTPUT_BUFFER
+char Com::outputLine[OUTPUT_LINE_SIZE];
+uint8_t Com::outputLength = 0;
+uint8_t Com::outputMode = 0;
+uint16_t Com::droppedLines = 0;
+
+/** \brief Sends the buffered output to the serial send ring.
+
+A droppable line is discarded including its remaining parts if the ring has no room for it. Once
+a part of a line was sent, the rest of it is sent as well. Other lines wait for room as before.
+Nothing is dropped if the free room is unknown. */
+void Com::commitLine()
+{
+    if(outputMode == OUTPUT_DROPPABLE)
+    {
+        int room = HAL::serialTxFree();
+        if(room >= 0 && room < outputLength)
+        {
+            outputMode = OUTPUT_DROPPING;
+            if(droppedLines != 65535) droppedLines++;
+        }
+    }
+    if(outputMode != OUTPUT_DROPPING)
+    {
+        for(uint8_t i = 0; i < outputLength; i++)
+            HAL::serialWriteByte(outputLine[i]);
+        outputMode = OUTPUT_CONTINUED;
+    }
+    if(outputLine[outputLength - 1] == '\n')
+        outputMode = 0;
+    outputLength = 0;
+}
+#endif
+
 void Com::printWarningF(FSTRINGPARAM(text)) {
     printF(tWarning);
     printF(text);
@@ -405,17 +505,19 @@ void Com::printFLN(FSTRINGPARAM(text),const char *msg) {
 void Com::printF(FSTRINGPARAM(ptr)) {
   char c;
   while ((c=HAL::readFlashByte(ptr++)) != 0)
-     HAL::serialWriteByte(c);
+     write(c);
 }
 void Com::printF(FSTRINGPARAM(text),const char *msg) {
     printF(text);
     print(msg);
 }
 
+#if __SIZEOF_INT__ == 2
 void Com::printF(FSTRINGPARAM(text),int value) {
     printF(text);
     print(value);
 }
+#endif
 void Com::printF(FSTRINGPARAM(text),int32_t value) {
     printF(text);
     print(value);
@@ -424,11 +526,13 @@ void Com::printF(FSTRINGPARAM(text),uint32_t value) {
     printF(text);
     printNumber(value);
 }
+#if __SIZEOF_INT__ == 2
 void Com::printFLN(FSTRINGPARAM(text),int value) {
     printF(text);
     print(value);
     println();
 }
+#endif
 void Com::printFLN(FSTRINGPARAM(text),int32_t value) {
     printF(text);
     print(value);
@@ -451,12 +555,12 @@ void Com::printF(FSTRINGPARAM(text),float value,uint8_t digits) {
 
 void Com::print(const char *text) {
   while(*text) {
-    HAL::serialWriteByte(*text++);
+    write(*text++);
   }
 }
 void Com::print(long value) {
     if(value<0) {
-        HAL::serialWriteByte('-');
+        write('-');
         value = -value;
     }
     printNumber(value);
@@ -480,7 +584,7 @@ void Com::printArrayFLN(FSTRINGPARAM(text),float *arr,uint8_t n,uint8_t digits)
         printF(Com::tSpace,arr[i],digits);
     println();
 }
-void Com::printArrayFLN(FSTRINGPARAM(text),int32_t *arr,uint8_t n) {
+void Com::printArrayFLN(FSTRINGPARAM(text),long *arr,uint8_t n) {
     printF(text);
     for(uint8_t i=0; i<n; i++)
         printF(Com::tSpace,arr[i]);
@@ -22,6 +22,10 @@
 #ifndef COMMUNICATION_H
 #define COMMUNICATION_H
 
+#define OUTPUT_DROPPABLE 1
+#define OUTPUT_DROPPING 2
+#define OUTPUT_CONTINUED 4
+
 class Com
 {
     public:
@@ -51,7 +55,33 @@ FSTRINGVAR(tP)
 FSTRINGVAR(tI)
 FSTRINGVAR(tJ)
 FSTRINGVAR(tR)
+#if FEATURE_CANNED_CYCLES
+FSTRINGVAR(tQ)
+#endif
 FSTRINGVAR(tL)
+#if FEATURE_OK_BUFFER_SPACE
+FSTRINGVAR(tB)
+#endif
+#if FEATURE_AUTO_REPORT
+FSTRINGVAR(tAutoReport)
+FSTRINGVAR(tAutoFeedrate)
+FSTRINGVAR(tAutoLaser)
+FSTRINGVAR(tAutoMoves)
+FSTRINGVAR(tAutoCommands)
+FSTRINGVAR(tAutoPowers)
+FSTRINGVAR(tAutoHead)
+#endif
+#if FEATURE_SERIAL_ERRORS
+FSTRINGVAR(tSerialErrors)
+FSTRINGVAR(tSerialOverrun)
+FSTRINGVAR(tSerialFrame)
+FSTRINGVAR(tSerialDropped)
+FSTRINGVAR(tSerialCommands)
+FSTRINGVAR(tSerialResends)
+#if FEATURE_OUTPUT_BUFFER
+FSTRINGVAR(tSerialLinesDropped)
+#endif
+#endif
 FSTRINGVAR(tSDReadError)
 FSTRINGVAR(tExpectedLine)
 FSTRINGVAR(tGot)
@@ -82,6 +112,38 @@ FSTRINGVAR(tSpaceBAtColon)
 FSTRINGVAR(tColon)
 FSTRINGVAR(tSpeedMultiply);
 FSTRINGVAR(tFlowMultiply);
+#if FEATURE_LIVE_OVERRIDES
+FSTRINGVAR(tLaserMultiply);
+#endif
+FSTRINGVAR(tBlockedStalls);
+FSTRINGVAR(tPlannerRetries);
+#if FEATURE_QUEUE_CONTROL
+FSTRINGVAR(tQueueUnderruns);
+FSTRINGVAR(tThrottledMoves);
+FSTRINGVAR(tMoveInterval);
+#endif
+#if FEATURE_MESH_LEVELING
+FSTRINGVAR(tMeshEnabled);
+FSTRINGVAR(tMeshDisabled);
+FSTRINGVAR(tMeshRow);
+#endif
+#if FEATURE_FAST_HOMING
+FSTRINGVAR(tHomingAxis);
+FSTRINGVAR(tHomingCount);
+#endif
+#if FEATURE_TIME_ESTIMATION
+FSTRINGVAR(tEstimateLayer);
+FSTRINGVAR(tEstimateTotal);
+FSTRINGVAR(tEstimateSeconds);
+#endif
+#if FEATURE_SUBPROGRAMS
+FSTRINGVAR(tSubprogram);
+FSTRINGVAR(tSubprogramUnknown);
+FSTRINGVAR(tSubprogramFull);
+FSTRINGVAR(tSubprogramDepth);
+FSTRINGVAR(tSubprogramCorrupt);
+FSTRINGVAR(tSubprogramFree);
+#endif
 FSTRINGVAR(tFanspeed);
 FSTRINGVAR(tPrintedFilament)
 FSTRINGVAR(tPrintingTime)
@@ -229,6 +291,14 @@ FSTRINGVAR(tZProbePrinterHeight)
 #ifdef WAITING_IDENTIFIER
 FSTRINGVAR(tWait)
 #endif // WAITING_IDENTIFIER
+#if FEATURE_REALTIME_COMMANDS
+FSTRINGVAR(tRtStatus)
+FSTRINGVAR(tRtIdle)
+FSTRINGVAR(tRtRun)
+FSTRINGVAR(tRtHolding)
+FSTRINGVAR(tRtHold)
+FSTRINGVAR(tRtQueue)
+#endif
 
 #if EEPROM_MODE==0
 FSTRINGVAR(tNoEEPROMSupport)
@@ -365,12 +435,20 @@ static void printInfoFLN(FSTRINGPARAM(text));
 static void printErrorFLN(FSTRINGPARAM(text));
 static void printFLN(FSTRINGPARAM(text));
 static void printF(FSTRINGPARAM(text));
+#if __SIZEOF_INT__ == 2 // on a 32 bit host int is int32_t and long needs its own overload
 static void printF(FSTRINGPARAM(text),int value);
+#else
+static inline void printF(FSTRINGPARAM(text),long value) {printF(text,(int32_t)value);}
+#endif
 static void printF(FSTRINGPARAM(text),const char *msg);
 static void printF(FSTRINGPARAM(text),int32_t value);
 static void printF(FSTRINGPARAM(text),uint32_t value);
 static void printF(FSTRINGPARAM(text),float value,uint8_t digits=2);
+#if __SIZEOF_INT__ == 2
 static void printFLN(FSTRINGPARAM(text),int value);
+#else
+static inline void printFLN(FSTRINGPARAM(text),long value) {printFLN(text,(int32_t)value);}
+#endif
 static void printFLN(FSTRINGPARAM(text),int32_t value);
 static void printFLN(FSTRINGPARAM(text),uint32_t value);
 static void printFLN(FSTRINGPARAM(text),const char *msg);
@@ -379,11 +457,30 @@ static void printArrayFLN(FSTRINGPARAM(text),float *arr,uint8_t n=4,uint8_t digi
 static void printArrayFLN(FSTRINGPARAM(text),long *arr,uint8_t n=4);
 static void print(long value);
 static inline void print(uint32_t value) {printNumber(value);}
-static inline void print(int value) {print((int32_t)value);}
+static inline void print(int value) {print((long)value);}
 static void print(const char *text);
-static inline void print(char c) {HAL::serialWriteByte(c);}
+static inline void print(char c) {write(c);}
 static void printFloat(float number, uint8_t digits);
-static inline void println() {HAL::serialWriteByte('\r');HAL::serialWriteByte('\n');}
+static inline void println() {write('\r');write('\n');}
+#if FEATURE_OUTPUT_BUFFER
+static char outputLine[OUTPUT_LINE_SIZE]; ///< Line being printed
+static uint8_t outputLength;
+static uint8_t outputMode; ///< OUTPUT_DROPPABLE, OUTPUT_DROPPING, OUTPUT_CONTINUED or 0 at the start of a line
+static uint16_t droppedLines;
+static void commitLine();
+/** \brief Adds a byte to the output line, which is sent when it is complete or the buffer is full. */
+static inline void write(char c)
+{
+    if(outputLength == OUTPUT_LINE_SIZE) commitLine(); // long lines are sent in parts
+    outputLine[outputLength++] = c;
+    if(c == '\n') commitLine();
+}
+/** \brief The line printed next is not needed by the host and is dropped if the send buffer has no room for it. */
+static inline void setDroppable() {if(outputLength == 0 && outputMode == 0) outputMode = OUTPUT_DROPPABLE;}
+#else
+static inline void write(char c) {HAL::serialWriteByte(c);}
+static inline void setDroppable() {}
+#endif
     protected:
     private:
 };
@@ -283,6 +283,14 @@
 #define HOMING_FEEDRATE_Y 25
 #define HOMING_FEEDRATE_Z 10
 #define HOMING_ORDER HOME_ORDER_XYZ
+/* Home in two stages. The seek move runs with travel acceleration as fast as the axis can stop within
+HOMING_SEEK_OVERTRAVEL mm after the endstop triggered, x and y seek together. Then each axis backs off by
+ENDSTOP_x_BACK_MOVE + HOMING_SEEK_OVERTRAVEL and touches the endstop slowly at
+HOMING_FEEDRATE/ENDSTOP_x_RETEST_REDUCTION_FACTOR. The slow touch position is compared with the expected
+position, M406 reports the deviation per axis. The endstop switches must allow the overtravel.
+Cartesian printers only. */
+#define FEATURE_FAST_HOMING 1
+#define HOMING_SEEK_OVERTRAVEL 2
 #define ENABLE_BACKLASH_COMPENSATION 0
 #define X_BACKLASH 0
 #define Y_BACKLASH 0
@@ -304,6 +312,25 @@
 #define MOVE_CACHE_SIZE 16
 #define MOVE_CACHE_LOW 10
 #define LOW_TICKS_PER_MOVE 250000
+/* Throttle short moves only if the queued moves would finish before the next move arrives at the
+measured arrival rate, instead of slowing every move while less than MOVE_CACHE_LOW moves are queued.
+LOW_TICKS_PER_MOVE stays the upper limit. A queue running empty while moves arrive faster than
+QUEUE_UNDERRUN_TIME ms apart counts as underrun, see M405. */
+#define FEATURE_QUEUE_CONTROL 1
+#define QUEUE_UNDERRUN_TIME 500
+/* Split moves into short step segments (interval + step count) in the main loop, so the
+stepper interrupt only replays them instead of computing the speed ramp itself. */
+#define FEATURE_STEP_SEGMENTS 1
+#define STEP_SEGMENTS_PER_SECOND 400 // Duration of a ramp segment is 1/STEP_SEGMENTS_PER_SECOND s
+#define STEP_SEGMENT_CACHE_SIZE 8 // Must be a power of 2
+#define STEP_SEGMENT_LINES_AHEAD 3 // Max. moves frozen for the segment compiler
+/* Speed ramps reuse the last step interval until the speed changed by more than 1/2^x.
+Saves most interval lookups at high step rates. 0 computes the interval every time. */
+#define RAMP_INTERVAL_SHIFT 8
+/* Feedrate changes (M220, speed multiplier in quick menu) also rescale the cached moves and the
+running move, so they show up immediately. Adds a laser power multiplier (M222) that scales the
+laser output. */
+#define FEATURE_LIVE_OVERRIDES 1
 #define FEATURE_TWO_XSTEPPER 0
 #define X2_STEP_PIN   ORIG_E1_STEP_PIN
 #define X2_DIR_PIN    ORIG_E1_DIR_PIN
@@ -321,15 +348,63 @@
 
 // ################# Misc. settings ##################
 
+/* 250000, 500000 and 1000000 baud have no rate error at 16 MHz. Other rates use the divisor with the smallest error. */
 #define BAUDRATE 115200
 #define ENABLE_POWER_ON_STARTUP
 #define POWER_INVERTING 0
 #define KILL_METHOD 1
-#define GCODE_BUFFER_SIZE 2
+/* Binary protocol V3 frames carry a batch of G0/G1 moves with varint encoded step deltas and laser powers
+under one checksum. See the Repetier-protocol page in gcode.cpp for the format. */
+#define FEATURE_BINARY_V3 1
+/* M407 S1 appends the free space to every ok: P planner moves, B queued commands, R serial receive bytes
+and L laser power values, e.g. "ok 12 P14 B5 R127 L980". Hosts can stream without waiting for each ok. */
+#define FEATURE_OK_BUFFER_SPACE 1
+/* Ascii lines arriving after a missing or corrupted line are kept in a window of RESEND_WINDOW lines and acknowledged,
+only the missing line is requested again without flushing the input. Lines with strings or laser powers, binary
+commands and gaps larger than the window fall back to the full resend. Each window line needs 68 byte RAM. */
+#define FEATURE_SELECTIVE_RESEND 1
+#define RESEND_WINDOW 3
+/* Received commands are queued in a ring of GCODE_QUEUE_BYTES (max. 255) storing only the parameters present.
+A typical G1 X Y F line needs 21 byte, so the queue holds 8-11 moves, limited to GCODE_BUFFER_SIZE commands. */
+#define GCODE_BUFFER_SIZE 16
+#define GCODE_QUEUE_BYTES 240
+/* Size of the interrupt driven serial receive and send rings, a power of 2 up to 256. Laser raster lines and echoes
+fill the default 128/64 byte rings at high baud rates and block the main loop. */
+#define SERIAL_BUFFER_SIZE 256
+#define SERIAL_TX_BUFFER_SIZE 128
+/* Count UART overrun and frame errors and bytes dropped by a full receive ring. M408 reports them together with
+the commands received over serial and resend requests, so hosts can measure their streaming rate on the machine.
+With EXTERNALSERIAL the arduino library hides the receive errors, only commands and resends are counted then. */
+#define FEATURE_SERIAL_ERRORS 1
+/* Output is collected in a line buffer of OUTPUT_LINE_SIZE byte and sent when the line is complete. Echoes, monitor
+and waiting temperatures are dropped when the send ring has no room for them, so they never stall command execution.
+M408 reports the number of dropped lines. */
+#define FEATURE_OUTPUT_BUFFER 1
+#define OUTPUT_LINE_SIZE 96
+/* M155 S<ms> P<fields> prints a status line every S ms, so hosts need not poll M105/M114 through the command queue:
+AR: T0:21.50/0 B:22.10/0 X:10.00 Y:5.00 Z:1.00 FR:100 LR:100 P:3 C:1 L:0 H:L
+P, C and L are the queued moves, commands and laser powers, H the head (U unknown, P printer, M mill, L laser). */
+#define FEATURE_AUTO_REPORT 1
 #define ACK_WITH_LINENUMBER
 #define WAITING_IDENTIFIER "wait"
 #define ECHO_ON_EXECUTE
 #define EEPROM_MODE 1
+/* Single byte real time commands. They are taken out of the serial stream in the receive
+interrupt, so they act immediately even if the command buffers are full. They are only
+recognized between ascii lines, never inside a line or while the host talks the binary protocol. */
+#define FEATURE_REALTIME_COMMANDS 1
+#define RT_CMD_FEED_HOLD '!'
+#define RT_CMD_CYCLE_START '~'
+#define RT_CMD_SOFT_RESET 0x18
+#define RT_CMD_STATUS '?'
+// Override bytes, only with FEATURE_LIVE_OVERRIDES. Plus/minus change by 10%. Control codes below 0x20,
+// they can not occur in G-code text or UTF-8 and do not collide with XON/XOFF or the binary packet marker.
+#define RT_CMD_FEED_RESET 0x14
+#define RT_CMD_FEED_PLUS 0x15
+#define RT_CMD_FEED_MINUS 0x16
+#define RT_CMD_LASER_RESET 0x1C
+#define RT_CMD_LASER_PLUS 0x1D
+#define RT_CMD_LASER_MINUS 0x1E
 
 /* ======== Servos =======
 Control the servos with
@@ -355,6 +430,8 @@ WARNING: Servos can draw a considerable amount of current. Make sure your system
 #define Z_PROBE_Y_OFFSET 0
 #define Z_PROBE_WAIT_BEFORE_TEST 0
 #define Z_PROBE_SPEED 2
+#define Z_PROBE_FAST_SPEED 6 // Speed for the first approach when measuring the height map (G33)
+#define MESH_PROBE_CLEARANCE 0.5 // Start height of G33 touches above the highest measured neighbour
 #define Z_PROBE_XY_SPEED 150
 #define Z_PROBE_SWITCHING_DISTANCE 1
 #define Z_PROBE_REPETITIONS 1
@@ -368,6 +445,21 @@ WARNING: Servos can draw a considerable amount of current. Make sure your system
 #define Z_PROBE_Y2 20
 #define Z_PROBE_X3 100
 #define Z_PROBE_Y3 160
+/* Bed height map with MESH_GRID_X x MESH_GRID_Y points from MESH_MIN to MESH_MAX (printer
+coordinates in mm). With M420 S1 moves are split at the grid lines and z follows the bilinear
+interpolated height. Heights are measured with G33 (relative to the first grid point) or set
+with M421 and stored with M500, range is +/-10 mm. */
+#define FEATURE_MESH_LEVELING 1
+/* Print time estimation. M111 S64 runs all moves through the path planner as fast as possible
+without moving the steppers and adds up the exact move times. Each layer time is reported
+after a positive z move, M111 S6 reports the total. */
+#define FEATURE_TIME_ESTIMATION 1
+#define MESH_GRID_X 5
+#define MESH_GRID_Y 5
+#define MESH_MIN_X 0
+#define MESH_MIN_Y 0
+#define MESH_MAX_X 165
+#define MESH_MAX_Y 165
 
 #ifndef SDSUPPORT  // Some boards have sd support on board. These define the values already in pins.h
 #define SDSUPPORT 0
@@ -376,6 +468,19 @@ WARNING: Servos can draw a considerable amount of current. Make sure your system
 #endif
 #define SD_EXTENDED_DIR 1 /** Show extended directory including file length. Don't use this with Pronterface! */
 #define ARC_SUPPORT 1
+/* Drilling cycles G81 (drill), G82 (drill with dwell P ms at the bottom) and G83 (peck drill with
+depth Q), cancelled by G80. R is the retract plane, G98/G99 retract to the start level/R plane.
+Blocks with only X/Y drill the next hole with the same parameters. Rapid moves use the max feedrates,
+peck drilling feeds from CANNED_PECK_CLEARANCE mm above the last depth. */
+#define FEATURE_CANNED_CYCLES 1
+#define CANNED_PECK_CLEARANCE 0.5
+/* Subprograms are stored in EEPROM behind the checksummed parameter area. M97 P<name> records the following
+commands until M99, M98 P<name> L<count> calls a program and M96 lists or erases them. Calls can be nested
+SUBPROGRAM_STACK_DEPTH levels deep, each level needs about 200 byte stack. */
+#define FEATURE_SUBPROGRAMS 1
+#define SUBPROGRAM_EEPROM_START 2048
+#define SUBPROGRAM_EEPROM_SIZE 2048
+#define SUBPROGRAM_STACK_DEPTH 3
 #define FEATURE_MEMORY_POSITION 1
 #define FEATURE_CHECKSUM_FORCED 0
 #define FEATURE_FAN_CONTROL 1
@@ -55,7 +55,6 @@ void EEPROM::update(GCode *com)
 void EEPROM::restoreEEPROMSettingsFromConfiguration()
 {
 #if EEPROM_MODE!=0
-    uint8_t version = EEPROM_PROTOCOL_VERSION;
     baudrate = BAUDRATE;
     maxInactiveTime = MAX_INACTIVE_TIME*1000L;
     stepperInactiveTime = STEPPER_INACTIVE_TIME*1000L;
@@ -287,6 +286,10 @@ void EEPROM::restoreEEPROMSettingsFromConfiguration()
 #if FEATURE_AUTOLEVEL && FEATURE_Z_PROBE
     Printer::setAutolevelActive(false);
     Printer::resetTransformationMatrix(true);
+#endif
+#if FEATURE_MESH_LEVELING
+    Printer::setMeshActive(false);
+    Printer::resetMesh();
 #endif
     initalizeUncached();
     Printer::updateDerivedParameter();
@@ -366,6 +369,12 @@ void EEPROM::storeDataIntoEEPROM(uint8_t corrupted)
     HAL::eprSetByte(EPR_AUTOLEVEL_ACTIVE,Printer::isAutolevelActive());
     for(uint8_t i=0; i<9; i++)
         HAL::eprSetFloat(EPR_AUTOLEVEL_MATRIX + (((int)i) << 2),Printer::autolevelTransformation[i]);
+#endif
+#if FEATURE_MESH_LEVELING
+    HAL::eprSetByte(EPR_MESH_ACTIVE,Printer::isMeshActive());
+    for(uint8_t y = 0; y < MESH_GRID_Y; y++)
+        for(uint8_t x = 0; x < MESH_GRID_X; x++)
+            HAL::eprSetInt16(EPR_MESH_HEIGHTS + ((y * MESH_GRID_X + x) << 1),Printer::meshHeight[y][x]);
 #endif
     // now the extruder
     for(uint8_t i=0; i<NUM_EXTRUDER; i++)
@@ -521,6 +530,15 @@ void EEPROM::readDataFromEEPROM()
         Printer::setAutolevelActive(HAL::eprGetByte(EPR_AUTOLEVEL_ACTIVE));
         Com::printArrayFLN(Com::tInfo,Printer::autolevelTransformation,9,6);
     }
+#endif
+#if FEATURE_MESH_LEVELING
+    if(version>7)
+    {
+        for(uint8_t y = 0; y < MESH_GRID_Y; y++)
+            for(uint8_t x = 0; x < MESH_GRID_X; x++)
+                Printer::meshHeight[y][x] = HAL::eprGetInt16(EPR_MESH_HEIGHTS + ((y * MESH_GRID_X + x) << 1));
+        Printer::setMeshActive(HAL::eprGetByte(EPR_MESH_ACTIVE));
+    }
 #endif
     // now the extruder
     for(uint8_t i=0; i<NUM_EXTRUDER; i++)
@@ -783,7 +801,6 @@ void EEPROM::writeSettings()
     for(uint8_t i=0; i<NUM_EXTRUDER; i++)
     {
         int o=i*EEPROM_EXTRUDER_LENGTH+EEPROM_EXTRUDER_OFFSET;
-        Extruder *e = &extruder[i];
         writeFloat(o+EPR_EXTRUDER_STEPS_PER_MM,Com::tEPRStepsPerMM);
         writeFloat(o+EPR_EXTRUDER_MAX_FEEDRATE,Com::tEPRMaxFeedrate);
         writeFloat(o+EPR_EXTRUDER_MAX_START_FEEDRATE,Com::tEPRStartFeedrate);
@@ -20,7 +20,7 @@
 #define _EEPROM_H
 
 // Id to distinguish version changes
-#define EEPROM_PROTOCOL_VERSION 7
+#define EEPROM_PROTOCOL_VERSION 8
 
 /** Where to start with our datablock in memory. Can be moved if you
 have problems with other modules using the eeprom */
@@ -106,6 +106,11 @@ have problems with other modules using the eeprom */
 #define EPR_DELTA_DIAGONAL_CORR_A 933
 #define EPR_DELTA_DIAGONAL_CORR_B 937
 #define EPR_DELTA_DIAGONAL_CORR_C 941
+#define EPR_MESH_ACTIVE           945
+#define EPR_MESH_HEIGHTS          946 // MESH_GRID_X*MESH_GRID_Y int16 heights in um, row by row
+#if FEATURE_MESH_LEVELING && EPR_MESH_HEIGHTS + 2 * MESH_GRID_X * MESH_GRID_Y > 2048
+#error Height map does not fit into the checked EEPROM area, reduce MESH_GRID_X or MESH_GRID_Y
+#endif
 
 #define EEPROM_EXTRUDER_OFFSET 200
 // bytes per extruder needed, leave some space for future development
@@ -152,6 +152,9 @@ void Extruder::manageTemperatures()
                         case BoXZY_CnC_head:
                             Com::printFLN(Com::tCnCHeadDetected);
                             break;
+
+                        default:
+                            break;
                     }
                 }
             }
@@ -1191,6 +1194,7 @@ void TemperatureController::autotunePID(float temp,uint8_t controllerId,bool sto
         if(time - temp_millis > 1000)
         {
             temp_millis = time;
+            Com::setDroppable();
             Commands::printTemperatures();
         }
         if(((time - t1) + (time - t2)) > (10L*60L*1000L*2L))   // 20 Minutes
@@ -1226,6 +1230,7 @@ disabled, the function is not called.
 */
 void writeMonitor()
 {
+    Com::setDroppable();
     Com::printF(Com::tMTEMPColon,(long)HAL::timeInMilliseconds());
     TemperatureController *act = tempController[manageMonitor];
     Com::printF(Com::tSpace,act->currentTemperatureC);
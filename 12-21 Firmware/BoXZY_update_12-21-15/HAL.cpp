@@ -955,6 +955,42 @@ ISR(EXTRUDER_TIMER_VECTOR)
 }
 #endif
 
+#if FEATURE_SERIAL_ERRORS
+/** \brief Prints the baud rate, the receive error counters, the commands received over serial,
+resend requests and the dropped output lines. reset clears the counters afterwards. The arduino
+serial library used with EXTERNALSERIAL hides the receive errors, so they are left out there. */
+void HAL::reportSerialErrors(bool reset)
+{
+    Com::printF(Com::tSerialErrors,(int32_t)baudrate);
+#ifndef EXTERNALSERIAL
+    uint16_t overrun,frame,dropped;
+    BEGIN_INTERRUPT_PROTECTED
+    overrun = serialErrors.overrun;
+    frame = serialErrors.frame;
+    dropped = serialErrors.dropped;
+    if(reset)
+        serialErrors.overrun = serialErrors.frame = serialErrors.dropped = 0;
+    END_INTERRUPT_PROTECTED
+    Com::printF(Com::tSerialOverrun,(int32_t)overrun);
+    Com::printF(Com::tSerialFrame,(int32_t)frame);
+    Com::printF(Com::tSerialDropped,(int32_t)dropped);
+#endif
+    Com::printF(Com::tSerialCommands,GCode::commandsReceived);
+    Com::printF(Com::tSerialResends,(int32_t)GCode::resendRequests);
+    if(reset)
+    {
+        GCode::commandsReceived = 0;
+        GCode::resendRequests = 0;
+    }
+#if FEATURE_OUTPUT_BUFFER
+    Com::printF(Com::tSerialLinesDropped,(int32_t)Com::droppedLines);
+    if(reset)
+        Com::droppedLines = 0;
+#endif
+    Com::println();
+}
+#endif
+
 #ifndef EXTERNALSERIAL
 // Implement serial communication for one stream only!
 /*
@@ -982,6 +1018,23 @@ ISR(EXTRUDER_TIMER_VECTOR)
 
 ring_buffer rx_buffer = { { 0 }, 0, 0};
 ring_buffer_tx tx_buffer = { { 0 }, 0, 0};
+#if FEATURE_REALTIME_COMMANDS
+volatile uint8_t rxLineState = RX_BETWEEN_LINES;
+
+/** \brief Called by the parser at the end of each ascii line. If nothing was received after it,
+the receive interrupt is between lines again, so a host that left the binary protocol gets
+its real time bytes back. */
+void HAL::serialAsciiLineDone()
+{
+    BEGIN_INTERRUPT_PROTECTED
+    if(rxLineState == RX_BINARY && rx_buffer.head == rx_buffer.tail)
+        rxLineState = RX_BETWEEN_LINES;
+    END_INTERRUPT_PROTECTED
+}
+#endif
+#if FEATURE_SERIAL_ERRORS
+serial_errors serialErrors = {0, 0, 0};
+#endif
 
 inline void rf_store_char(unsigned char c, ring_buffer *buffer)
 {
@@ -996,6 +1049,10 @@ inline void rf_store_char(unsigned char c, ring_buffer *buffer)
         buffer->buffer[buffer->head] = c;
         buffer->head = i;
     }
+#if FEATURE_SERIAL_ERRORS
+    else if(serialErrors.dropped != 65535)
+        serialErrors.dropped++;
+#endif
 }
 #if !defined(USART0_RX_vect) && defined(USART1_RX_vect)
 // do nothing - on the 32u4 the first USART is USART1
@@ -1019,12 +1076,41 @@ SIGNAL(SIG_UART_RECV)
 #endif
 #endif
 {
+#if FEATURE_SERIAL_ERRORS // error flags are only valid until the data register is read
+#if defined(UCSR0A)
+    uint8_t status = UCSR0A;
+    if((status & _BV(DOR0)) && serialErrors.overrun != 65535) serialErrors.overrun++;
+    if((status & _BV(FE0)) && serialErrors.frame != 65535) serialErrors.frame++;
+#elif defined(UCSRA)
+    uint8_t status = UCSRA;
+    if((status & _BV(DOR)) && serialErrors.overrun != 65535) serialErrors.overrun++;
+    if((status & _BV(FE)) && serialErrors.frame != 65535) serialErrors.frame++;
+#endif
+#endif
 #if defined(UDR0)
     unsigned char c  =  UDR0;
 #elif defined(UDR)
     unsigned char c  =  UDR;
 #else
 #error UDR not defined
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    // Real time bytes are only taken between ascii lines, so line text, comments
+    // and binary packets reach the parser unchanged.
+    if(rxLineState == RX_BETWEEN_LINES)
+    {
+        if(Printer::isRealtimeCommand(c))
+        {
+            Printer::handleRealtimeCommand(c);
+            return;
+        }
+        if(c & 128)
+            rxLineState = RX_BINARY; // first byte of a binary packet
+        else if(c != '\n' && c != '\r' && c != 0)
+            rxLineState = RX_IN_LINE;
+    }
+    else if(rxLineState == RX_IN_LINE && (c == '\n' || c == '\r' || c == 0))
+        rxLineState = RX_BETWEEN_LINES;
 #endif
     rf_store_char(c, &rx_buffer);
 }
@@ -1098,10 +1184,21 @@ RFHardwareSerial::RFHardwareSerial(ring_buffer *rx_buffer, ring_buffer_tx *tx_bu
 
 // Public Methods //////////////////////////////////////////////////////////////
 
+/** \brief Sets the baud rate and enables receiver, transmitter and receive interrupt.
+
+Double speed (U2X) and normal mode divisors are rounded to the nearest value and the mode with the
+smaller rate error is used. 250000, 500000 and 1000000 baud are exact at 16 MHz. */
 void RFHardwareSerial::begin(unsigned long baud)
 {
-    uint16_t baud_setting;
-    bool use_u2x = true;
+    // divisor + 1 rounded to nearest, clamped to the 12 bit UBRR range
+    unsigned long div2x = (F_CPU / 4 / baud + 1) / 2;
+    unsigned long div1x = (F_CPU / 8 / baud + 1) / 2;
+    if(div2x < 1) div2x = 1;
+    if(div1x < 1) div1x = 1;
+    if(div1x > 4096) div1x = 4096;
+    long err2x = (long)(F_CPU / 8 / div2x) - (long)baud;
+    long err1x = (long)(F_CPU / 16 / div1x) - (long)baud;
+    bool use_u2x = div2x <= 4096 && labs(err2x) <= labs(err1x);
 
 #if F_CPU == 16000000UL
     // hardcoded exception for compatibility with the bootloader shipped
@@ -1113,23 +1210,16 @@ void RFHardwareSerial::begin(unsigned long baud)
     }
 #endif
 
-try_again:
-
+    uint16_t baud_setting;
     if (use_u2x)
     {
         *_ucsra = 1 << _u2x;
-        baud_setting = (F_CPU / 4 / baud - 1) / 2;
+        baud_setting = div2x - 1;
     }
     else
     {
         *_ucsra = 0;
-        baud_setting = (F_CPU / 8 / baud - 1) / 2;
-    }
-
-    if ((baud_setting > 4095) && use_u2x)
-    {
-        use_u2x = false;
-        goto try_again;
+        baud_setting = div1x - 1;
     }
 
     // assign the baud_setting, a.k.a. ubbr (USART Baud Rate Register)
@@ -141,10 +141,20 @@ typedef uint8_t flag8_t;
   Modified to use only 1 queue with fixed length by Repetier
 */
 
+#ifndef SERIAL_BUFFER_SIZE
 #define SERIAL_BUFFER_SIZE 128
-#define SERIAL_BUFFER_MASK 127
+#endif
+#ifndef SERIAL_TX_BUFFER_SIZE
 #define SERIAL_TX_BUFFER_SIZE 64
-#define SERIAL_TX_BUFFER_MASK 63
+#endif
+#if SERIAL_BUFFER_SIZE > 256 || SERIAL_TX_BUFFER_SIZE > 256
+#error Serial ring buffers are limited to 256 byte
+#endif
+#if (SERIAL_BUFFER_SIZE & (SERIAL_BUFFER_SIZE - 1)) || (SERIAL_TX_BUFFER_SIZE & (SERIAL_TX_BUFFER_SIZE - 1))
+#error Serial ring buffer sizes must be a power of 2
+#endif
+#define SERIAL_BUFFER_MASK (SERIAL_BUFFER_SIZE - 1)
+#define SERIAL_TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1)
 
 struct ring_buffer
 {
@@ -158,6 +168,16 @@ struct ring_buffer_tx
     volatile uint8_t head;
     volatile uint8_t tail;
 };
+#define RX_BETWEEN_LINES 0 ///< Receive interrupt waits for the first byte of a line or packet
+#define RX_IN_LINE 1 ///< Receive interrupt is inside an ascii line
+#define RX_BINARY 2 ///< Host sends binary packets, real time bytes are not taken
+/** \brief Receive errors counted in the receive interrupt. Counters stop at 65535. */
+struct serial_errors
+{
+    volatile uint16_t overrun; ///< UART data overrun, a byte arrived before the last was read
+    volatile uint16_t frame; ///< Missing stop bit, mostly wrong baud rate or line noise
+    volatile uint16_t dropped; ///< Bytes lost because the receive ring was full
+};
 
 class RFHardwareSerial : public Print
 {
@@ -198,6 +218,9 @@ public:
 extern RFHardwareSerial RFSerial;
 #define RFSERIAL RFSerial
 //extern ring_buffer tx_buffer;
+#if FEATURE_SERIAL_ERRORS
+extern serial_errors serialErrors;
+#endif
 #define WAIT_OUT_EMPTY while(tx_buffer.head != tx_buffer.tail) {}
 #else
 #define RFSERIAL Serial
@@ -543,6 +566,36 @@ public:
     {
         RFSERIAL.flush();
     }
+    /** Free bytes in the serial receive buffer. */
+    static inline int serialRxFree()
+    {
+#ifndef EXTERNALSERIAL
+        return SERIAL_BUFFER_SIZE - 1 - RFSERIAL.available();
+#else
+        return 63 - RFSERIAL.available(); // arduino library input buffer
+#endif
+    }
+    /** Free bytes in the serial send buffer, -1 if the serial library does not report it. */
+    static inline int serialTxFree()
+    {
+#ifndef EXTERNALSERIAL
+        return RFSERIAL.outputUnused() - 1;
+#elif defined(ARDUINO) && ARDUINO >= 10606
+        return RFSERIAL.availableForWrite(); // arduino library output buffer
+#else
+        return -1;
+#endif
+    }
+#if FEATURE_SERIAL_ERRORS
+    static void reportSerialErrors(bool reset);
+#endif
+#if FEATURE_REALTIME_COMMANDS
+#ifndef EXTERNALSERIAL
+    static void serialAsciiLineDone();
+#else
+    static inline void serialAsciiLineDone() {}
+#endif
+#endif
     static void setupTimer();
     static void showStartReason();
     static int getFreeRam();
@@ -56,7 +56,15 @@ long Printer::destinationSteps[4];
 float Printer::coordinateOffset[3] = {0,0,0};
 uint8_t Printer::flag0 = 0;
 uint8_t Printer::flag1 = 0;
-uint8_t Printer::debugLevel = 6; ///< Bitfield defining debug output. 1 = echo, 2 = info, 4 = error, 8 = dry run., 16 = Only communication, 32 = No moves
+uint8_t Printer::debugLevel = 6; ///< Bitfield defining debug output. 1 = echo, 2 = info, 4 = error, 8 = dry run., 16 = Only communication, 32 = No moves, 64 = Estimate time
+#if FEATURE_TIME_ESTIMATION
+float Printer::estimatedTime = 0;
+float Printer::estimatedLayerTime = 0;
+float Printer::estimatedLastLayerTime = 0;
+uint16_t Printer::estimatedLayers = 0;
+volatile uint8_t Printer::estimateLayerDone = 0;
+long Printer::estimateStartSteps[4];
+#endif
 uint8_t Printer::stepsPerTimerCall = 1;
 uint8_t Printer::menuMode = 0;
 
@@ -68,6 +76,13 @@ bool Printer::is_L_in_focus_mode;
 #if FEATURE_AUTOLEVEL
 float Printer::autolevelTransformation[9]; ///< Transformation matrix
 #endif
+#if FEATURE_MESH_LEVELING
+int16_t Printer::meshHeight[MESH_GRID_Y][MESH_GRID_X]; ///< Bed height map in um
+int32_t Printer::meshMinSteps[2];
+int32_t Printer::meshSpacingSteps[2];
+uint32_t Printer::meshCellFactor[2];
+int32_t Printer::meshStepsPerUm;
+#endif
 unsigned long Printer::interval;           ///< Last step duration in ticks.
 unsigned long Printer::timer;              ///< used for acceleration/deceleration timing
 unsigned long Printer::stepNumber;         ///< Step number in current move.
@@ -128,7 +143,9 @@ float Printer::maxZJerk;                   ///< Maximum allowed jerk in z direct
 #endif
 float Printer::offsetX;                     ///< X-offset for different extruder positions.
 float Printer::offsetY;                     ///< Y-offset for different extruder positions.
-unsigned int Printer::vMaxReached;         ///< Maximumu reached speed
+speed_t Printer::vMaxReached;         ///< Maximumu reached speed
+speed_t Printer::rampDivisor = 0;
+unsigned long Printer::rampTicks = 0;
 unsigned long Printer::msecondsPrinting;            ///< Milliseconds of printing time (means time with heated extruder)
 float Printer::filamentPrinted;            ///< mm of filament printed since counting started
 uint8_t Printer::wasLastHalfstepping;         ///< Indicates if last move had halfstepping enabled
@@ -137,6 +154,9 @@ float Printer::backlashX;
 float Printer::backlashY;
 float Printer::backlashZ;
 uint8_t Printer::backlashDir;
+uint16_t Printer::backlashSteps[3];
+ticks_t Printer::backlashInterval[3];
+uint16_t Printer::backlashMissing[3] = {0,0,0};
 #endif
 #ifdef DEBUG_STEPCOUNT
 long Printer::totalStepsRemaining;
@@ -159,6 +179,24 @@ int8_t Printer::motorY;
     float Printer::maxRealJerk = 0;
 #endif
 BoXZY_head_t Printer::BoXZY_head;
+#if FEATURE_REALTIME_COMMANDS
+volatile uint8_t Printer::feedHoldState = FEED_HOLD_NONE;
+speed_t Printer::feedHoldVEnd = 0;
+uint8_t Printer::feedHoldLaserPower = 0;
+volatile uint8_t Printer::realtimeStatusRequested = 0;
+#if FEATURE_LIVE_OVERRIDES
+volatile int16_t Printer::realtimeFeedrateMultiply = 0;
+volatile uint8_t Printer::realtimeLaserMultiply = 0;
+#endif
+#endif
+#if FEATURE_FAST_HOMING
+volatile uint8_t Printer::homingState = HOMING_NONE;
+long Printer::homingStepsLeft = 0;
+int32_t Printer::homingDeviation[3];
+int32_t Printer::homingDeviationMin[3];
+int32_t Printer::homingDeviationMax[3];
+uint16_t Printer::homingCount[3] = {0,0,0};
+#endif
 #ifdef DEBUG_PRINT
 int debugWaitLoop = 0;
 #endif
@@ -274,6 +312,11 @@ void Printer::updateDerivedParameter()
     if(backlashX!=0) backlashDir |= 8;
     if(backlashY!=0) backlashDir |= 16;
     if(backlashZ!=0) backlashDir |= 32;
+    backlashSteps[X_AXIS] = fabs(backlashX) * axisStepsPerMM[X_AXIS] + 0.5f;
+    backlashSteps[Y_AXIS] = fabs(backlashY) * axisStepsPerMM[Y_AXIS] + 0.5f;
+    backlashSteps[Z_AXIS] = fabs(backlashZ) * axisStepsPerMM[Z_AXIS] + 0.5f;
+    for(uint8_t i = 0; i < 3; i++) // takeup never runs faster than the axis may move
+        backlashInterval[i] = (float)F_CPU / (maxFeedrate[i] * axisStepsPerMM[i]);
 #endif
 #endif
     for(uint8_t i=0; i<4; i++)
@@ -290,6 +333,15 @@ void Printer::updateDerivedParameter()
     minimumSpeed = accel*sqrt(2.0f/(axisStepsPerMM[X_AXIS]*accel));
     accel = RMath::max(maxAccelerationMMPerSquareSecond[Z_AXIS],maxTravelAccelerationMMPerSquareSecond[Z_AXIS]);
     minimumZSpeed = accel*sqrt(2.0f/(axisStepsPerMM[Z_AXIS]*accel));
+#if FEATURE_MESH_LEVELING
+    meshMinSteps[X_AXIS] = MESH_MIN_X * axisStepsPerMM[X_AXIS];
+    meshMinSteps[Y_AXIS] = MESH_MIN_Y * axisStepsPerMM[Y_AXIS];
+    meshSpacingSteps[X_AXIS] = (MESH_MAX_X - MESH_MIN_X) * axisStepsPerMM[X_AXIS] / (MESH_GRID_X - 1);
+    meshSpacingSteps[Y_AXIS] = (MESH_MAX_Y - MESH_MIN_Y) * axisStepsPerMM[Y_AXIS] / (MESH_GRID_Y - 1);
+    meshCellFactor[X_AXIS] = 16777216UL / meshSpacingSteps[X_AXIS];
+    meshCellFactor[Y_AXIS] = 16777216UL / meshSpacingSteps[Y_AXIS];
+    meshStepsPerUm = axisStepsPerMM[Z_AXIS] * 65.536f;
+#endif
     Printer::updateAdvanceFlags();
 }
 /**
@@ -394,7 +446,12 @@ void Printer::moveToReal(float x,float y,float z,float e,float f)
 #if NONLINEAR_SYSTEM
     PrintLine::queueDeltaMove(ALWAYS_CHECK_ENDSTOPS, true, true);
 #else
-    PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS,true);
+#if FEATURE_MESH_LEVELING
+    if(isMeshActive())
+        PrintLine::queueMeshMove(ALWAYS_CHECK_ENDSTOPS,true);
+    else
+#endif
+        PrintLine::queueCartesianMove(ALWAYS_CHECK_ENDSTOPS,true);
 #endif
 }
 
@@ -410,6 +467,10 @@ void Printer::updateCurrentPosition(bool copyLastCmd)
     currentPosition[X_AXIS] = (float)(currentPositionSteps[X_AXIS])*invAxisStepsPerMM[X_AXIS];
     currentPosition[Y_AXIS] = (float)(currentPositionSteps[Y_AXIS])*invAxisStepsPerMM[Y_AXIS];
     currentPosition[Z_AXIS] = (float)(currentPositionSteps[Z_AXIS])*invAxisStepsPerMM[Z_AXIS];
+#if FEATURE_MESH_LEVELING
+    if(isMeshActive())
+        currentPosition[Z_AXIS] -= (float)meshCorrectionSteps(currentPositionSteps[X_AXIS],currentPositionSteps[Y_AXIS])*invAxisStepsPerMM[Z_AXIS];
+#endif
 #if FEATURE_AUTOLEVEL && FEATURE_Z_PROBE
     if(isAutolevelActive())
         transformFromPrinter(currentPosition[X_AXIS],currentPosition[Y_AXIS],currentPosition[Z_AXIS],currentPosition[X_AXIS],currentPosition[Y_AXIS],currentPosition[Z_AXIS]);
@@ -1033,9 +1094,128 @@ void Printer::homeYAxis()
     // Dummy function x and y homing must occur together
 }
 #else // cartesian printer
+#if FEATURE_FAST_HOMING
+static const int8_t homeDir[3] = {X_HOME_DIR,Y_HOME_DIR,Z_HOME_DIR};
+static long homingStart[3];   ///< Position before homing in steps
+static float homingMoved[3];  ///< Steps moved by the homing moves
+static bool homingStartKnown; ///< Position before homing was valid
+
+static bool homingEndstopHit(uint8_t axis)
+{
+    switch(axis)
+    {
+    case X_AXIS:
+        return (X_HOME_DIR < 0 ? Printer::isXMinEndstopHit() : Printer::isXMaxEndstopHit());
+    case Y_AXIS:
+        return (Y_HOME_DIR < 0 ? Printer::isYMinEndstopHit() : Printer::isYMaxEndstopHit());
+    default:
+        return (Z_HOME_DIR < 0 ? Printer::isZMinEndstopHit() : Printer::isZMaxEndstopHit());
+    }
+}
+
+/** Fastest speed in mm/s that stops within HOMING_SEEK_OVERTRAVEL with travel acceleration. */
+static float homingSeekFeedrate(uint8_t axis)
+{
+    return RMath::min(Printer::maxFeedrate[axis],(float)sqrt(2.0f * Printer::maxTravelAccelerationMMPerSquareSecond[axis] * HOMING_SEEK_OVERTRAVEL));
+}
+
+/** Runs one homing move and adds the steps done until the endstop triggered to homingMoved. */
+static void homingMove(long x,long y,long z,float feedrate,uint8_t state)
+{
+    Printer::homingState = state;
+    Printer::homingStepsLeft = 0;
+    PrintLine::moveRelativeDistanceInSteps(x,y,z,0,feedrate,true,state != HOMING_NONE);
+    Printer::homingState = HOMING_NONE;
+    float primary = RMath::max(labs(x),RMath::max(labs(y),labs(z)));
+    if(primary == 0) return;
+    float done = 1.0f - (float)Printer::homingStepsLeft / primary;
+    homingMoved[X_AXIS] += x * done;
+    homingMoved[Y_AXIS] += y * done;
+    homingMoved[Z_AXIS] += z * done;
+}
+
+/**
+  Moves all axes of the mask (1 = x, 2 = y, 4 = z) together to their endstops at seek speed. The move
+  decelerates at the first endstop, axes not at their endstop then continue.
+*/
+static void homingSeek(uint8_t axes)
+{
+    for(uint8_t tries = 0; tries < 3; tries++)
+    {
+        long d[3] = {0,0,0};
+        float len = 0,feedrate = 0;
+        for(uint8_t a = 0; a < 3; a++)
+        {
+            if(!(axes & (1 << a)) || homingEndstopHit(a)) continue;
+            long travel = (a == X_AXIS ? Printer::xMaxSteps - Printer::xMinSteps : (a == Y_AXIS ? Printer::yMaxSteps - Printer::yMinSteps : Printer::zMaxSteps - Printer::zMinSteps));
+            d[a] = 2 * travel * homeDir[a];
+            Printer::currentPositionSteps[a] = -d[a] / 2; // Keep destination inside the software endstops
+            float mm = 2 * travel * Printer::invAxisStepsPerMM[a];
+            len += mm * mm;
+        }
+        if(len == 0) return;
+        len = sqrt(len);
+        for(uint8_t a = 0; a < 3; a++) // Path speed that keeps every axis at its seek speed
+        {
+            if(d[a] == 0) continue;
+            float f = homingSeekFeedrate(a) * len / (labs(d[a]) * Printer::invAxisStepsPerMM[a]);
+            if(feedrate == 0 || f < feedrate) feedrate = f;
+        }
+        homingMove(d[X_AXIS],d[Y_AXIS],d[Z_AXIS],feedrate,HOMING_SEEK);
+    }
+}
+
+/**
+  Homes one axis after the seek: backs off, touches the endstop slowly and sets the position to home.
+  The slow touch position is compared with the position expected from the last homing.
+*/
+static void homeAxisFast(uint8_t axis,long home)
+{
+    static const float backMove[3] = {ENDSTOP_X_BACK_MOVE,ENDSTOP_Y_BACK_MOVE,ENDSTOP_Z_BACK_MOVE};
+    static const float backOnHome[3] = {ENDSTOP_X_BACK_ON_HOME,ENDSTOP_Y_BACK_ON_HOME,ENDSTOP_Z_BACK_ON_HOME};
+    static const uint8_t retestFactor[3] = {ENDSTOP_X_RETEST_REDUCTION_FACTOR,ENDSTOP_Y_RETEST_REDUCTION_FACTOR,ENDSTOP_Z_RETEST_REDUCTION_FACTOR};
+    long d[3] = {0,0,0};
+    homingSeek(1 << axis);
+    Printer::currentPositionSteps[axis] = home;
+    d[axis] = (long)(Printer::axisStepsPerMM[axis] * (backMove[axis] + HOMING_SEEK_OVERTRAVEL)) * -homeDir[axis];
+    homingMove(d[X_AXIS],d[Y_AXIS],d[Z_AXIS],Printer::homingFeedrate[axis],HOMING_NONE);
+    homingMove(-2 * d[X_AXIS],-2 * d[Y_AXIS],-2 * d[Z_AXIS],Printer::homingFeedrate[axis] / retestFactor[axis],HOMING_TOUCH);
+    Printer::currentPositionSteps[axis] = home;
+    if(!homingStartKnown) return;
+    // Last homing set home after backing off from the endstop
+    int32_t dev = (int32_t)floor(homingStart[axis] + homingMoved[axis] + 0.5f) - home - (long)(Printer::axisStepsPerMM[axis] * backOnHome[axis]) * homeDir[axis];
+    if(Printer::homingCount[axis] == 0 || dev < Printer::homingDeviationMin[axis]) Printer::homingDeviationMin[axis] = dev;
+    if(Printer::homingCount[axis] == 0 || dev > Printer::homingDeviationMax[axis]) Printer::homingDeviationMax[axis] = dev;
+    Printer::homingDeviation[axis] = dev;
+    Printer::homingCount[axis]++;
+}
+
+void Printer::resetHomingStatistics()
+{
+    for(uint8_t a = 0; a < 3; a++)
+        homingCount[a] = 0;
+}
+
+/** Reports last, smallest and largest endstop deviation in mm and the number of homings per axis. */
+void Printer::reportHomingStatistics()
+{
+    for(uint8_t a = 0; a < 3; a++)
+    {
+        Com::printF(Com::tHomingAxis);
+        Com::print("XYZ"[a]);
+        Com::printF(Com::tColon);
+        if(homingCount[a])
+        {
+            Com::printF(Com::tSpace,homingDeviation[a] * invAxisStepsPerMM[a],3);
+            Com::printF(Com::tSpace,homingDeviationMin[a] * invAxisStepsPerMM[a],3);
+            Com::printF(Com::tSpace,homingDeviationMax[a] * invAxisStepsPerMM[a],3);
+        }
+        Com::printFLN(Com::tHomingCount,(int)homingCount[a]);
+    }
+}
+#endif // FEATURE_FAST_HOMING
 void Printer::homeXAxis()
 {
-    long steps;
     if ((MIN_HARDWARE_ENDSTOP_X && X_MIN_PIN > -1 && X_HOME_DIR==-1) || (MAX_HARDWARE_ENDSTOP_X && X_MAX_PIN > -1 && X_HOME_DIR==1))
     {
         long offX = 0;
@@ -1049,12 +1229,16 @@ void Printer::homeXAxis()
         // Reposition extruder that way, that all extruders can be selected at home pos.
 #endif
         UI_STATUS_UPD(UI_TEXT_HOME_X);
-        steps = (Printer::xMaxSteps-Printer::xMinSteps) * X_HOME_DIR;
+#if FEATURE_FAST_HOMING
+        homeAxisFast(X_AXIS,(X_HOME_DIR == -1) ? xMinSteps-offX : xMaxSteps + offX);
+#else
+        long steps = (Printer::xMaxSteps-Printer::xMinSteps) * X_HOME_DIR;
         currentPositionSteps[X_AXIS] = -steps;
         PrintLine::moveRelativeDistanceInSteps(2*steps,0,0,0,homingFeedrate[X_AXIS],true,true);
         currentPositionSteps[X_AXIS] = (X_HOME_DIR == -1) ? xMinSteps-offX : xMaxSteps + offX;
         PrintLine::moveRelativeDistanceInSteps(axisStepsPerMM[X_AXIS] * -ENDSTOP_X_BACK_MOVE * X_HOME_DIR,0,0,0,homingFeedrate[X_AXIS] / ENDSTOP_X_RETEST_REDUCTION_FACTOR,true,false);
         PrintLine::moveRelativeDistanceInSteps(axisStepsPerMM[X_AXIS] * 2 * ENDSTOP_X_BACK_MOVE * X_HOME_DIR,0,0,0,homingFeedrate[X_AXIS] / ENDSTOP_X_RETEST_REDUCTION_FACTOR,true,true);
+#endif
 #if defined(ENDSTOP_X_BACK_ON_HOME)
         if(ENDSTOP_X_BACK_ON_HOME > 0)
             PrintLine::moveRelativeDistanceInSteps(axisStepsPerMM[X_AXIS] * -ENDSTOP_X_BACK_ON_HOME * X_HOME_DIR,0,0,0,homingFeedrate[X_AXIS],true,false);
@@ -1068,7 +1252,6 @@ void Printer::homeXAxis()
 }
 void Printer::homeYAxis()
 {
-    long steps;
     if ((MIN_HARDWARE_ENDSTOP_Y && Y_MIN_PIN > -1 && Y_HOME_DIR==-1) || (MAX_HARDWARE_ENDSTOP_Y && Y_MAX_PIN > -1 && Y_HOME_DIR==1))
     {
         long offY = 0;
@@ -1082,12 +1265,16 @@ void Printer::homeYAxis()
         // Reposition extruder that way, that all extruders can be selected at home pos.
 #endif
         UI_STATUS_UPD(UI_TEXT_HOME_Y);
-        steps = (yMaxSteps-Printer::yMinSteps) * Y_HOME_DIR;
+#if FEATURE_FAST_HOMING
+        homeAxisFast(Y_AXIS,(Y_HOME_DIR == -1) ? yMinSteps-offY : yMaxSteps+offY);
+#else
+        long steps = (yMaxSteps-Printer::yMinSteps) * Y_HOME_DIR;
         currentPositionSteps[1] = -steps;
         PrintLine::moveRelativeDistanceInSteps(0,2*steps,0,0,homingFeedrate[1],true,true);
         currentPositionSteps[1] = (Y_HOME_DIR == -1) ? yMinSteps-offY : yMaxSteps+offY;
         PrintLine::moveRelativeDistanceInSteps(0,axisStepsPerMM[Y_AXIS]*-ENDSTOP_Y_BACK_MOVE * Y_HOME_DIR,0,0,homingFeedrate[Y_AXIS]/ENDSTOP_X_RETEST_REDUCTION_FACTOR,true,false);
         PrintLine::moveRelativeDistanceInSteps(0,axisStepsPerMM[Y_AXIS]*2*ENDSTOP_Y_BACK_MOVE * Y_HOME_DIR,0,0,homingFeedrate[Y_AXIS]/ENDSTOP_X_RETEST_REDUCTION_FACTOR,true,true);
+#endif
 #if defined(ENDSTOP_Y_BACK_ON_HOME)
         if(ENDSTOP_Y_BACK_ON_HOME > 0)
             PrintLine::moveRelativeDistanceInSteps(0,axisStepsPerMM[Y_AXIS]*-ENDSTOP_Y_BACK_ON_HOME * Y_HOME_DIR,0,0,homingFeedrate[Y_AXIS],true,false);
@@ -1103,16 +1290,19 @@ void Printer::homeYAxis()
 
 void Printer::homeZAxis()
 {
-    long steps;
     if ((MIN_HARDWARE_ENDSTOP_Z && Z_MIN_PIN > -1 && Z_HOME_DIR==-1) || (MAX_HARDWARE_ENDSTOP_Z && Z_MAX_PIN > -1 && Z_HOME_DIR==1))
     {
         UI_STATUS_UPD(UI_TEXT_HOME_Z);
-        steps = (zMaxSteps - zMinSteps) * Z_HOME_DIR;
+#if FEATURE_FAST_HOMING
+        homeAxisFast(Z_AXIS,(Z_HOME_DIR == -1) ? zMinSteps : zMaxSteps);
+#else
+        long steps = (zMaxSteps - zMinSteps) * Z_HOME_DIR;
         currentPositionSteps[2] = -steps;
         PrintLine::moveRelativeDistanceInSteps(0,0,2*steps,0,homingFeedrate[2],true,true);
         currentPositionSteps[2] = (Z_HOME_DIR == -1) ? zMinSteps : zMaxSteps;
         PrintLine::moveRelativeDistanceInSteps(0,0,axisStepsPerMM[Z_AXIS]*-ENDSTOP_Z_BACK_MOVE * Z_HOME_DIR,0,homingFeedrate[Z_AXIS]/ENDSTOP_Z_RETEST_REDUCTION_FACTOR,true,false);
         PrintLine::moveRelativeDistanceInSteps(0,0,axisStepsPerMM[Z_AXIS]*2*ENDSTOP_Z_BACK_MOVE * Z_HOME_DIR,0,homingFeedrate[Z_AXIS]/ENDSTOP_Z_RETEST_REDUCTION_FACTOR,true,true);
+#endif
 #if defined(ENDSTOP_Z_BACK_ON_HOME)
         if(ENDSTOP_Z_BACK_ON_HOME > 0)
             PrintLine::moveRelativeDistanceInSteps(0,0,axisStepsPerMM[Z_AXIS]*-ENDSTOP_Z_BACK_ON_HOME * Z_HOME_DIR,0,homingFeedrate[Z_AXIS],true,false);
@@ -1129,11 +1319,30 @@ void Printer::homeAxis(bool xaxis,bool yaxis,bool zaxis) // home non-delta print
 {
     float startX,startY,startZ;
     realPosition(startX,startY,startZ);
+#if FEATURE_FAST_HOMING
+    Commands::waitUntilEndOfAllMoves(); // Homing state must not apply to queued moves
+    homingStartKnown = isHomed() && !areAllSteppersDisabled();
+    for(uint8_t a = 0; a < 3; a++)
+    {
+        homingStart[a] = currentPositionSteps[a];
+        homingMoved[a] = 0;
+    }
+#endif
     setHomed(true);
 #if !defined(HOMING_ORDER)
 #define HOMING_ORDER HOME_ORDER_XYZ
 #endif
-#if HOMING_ORDER==HOME_ORDER_XYZ
+#if FEATURE_FAST_HOMING && (HOMING_ORDER==HOME_ORDER_XYZ || HOMING_ORDER==HOME_ORDER_YXZ)
+    if(xaxis && yaxis) homingSeek(3); // x and y seek together, the axes find the seek done
+    if(xaxis) homeXAxis();
+    if(yaxis) homeYAxis();
+    if(zaxis) homeZAxis();
+#elif FEATURE_FAST_HOMING && (HOMING_ORDER==HOME_ORDER_ZXY || HOMING_ORDER==HOME_ORDER_ZYX)
+    if(zaxis) homeZAxis();
+    if(xaxis && yaxis) homingSeek(3);
+    if(xaxis) homeXAxis();
+    if(yaxis) homeYAxis();
+#elif HOMING_ORDER==HOME_ORDER_XYZ
     if(xaxis) homeXAxis();
     if(yaxis) homeYAxis();
     if(zaxis) homeZAxis();
@@ -1180,48 +1389,131 @@ void Printer::homeAxis(bool xaxis,bool yaxis,bool zaxis) // home non-delta print
 }
 #endif  // Not delta printer
 
-void Printer::zBabystep() {
+/**
+  Executes a Z babystep while no move is running. If a direction pin has to change, only the
+  direction is set and the step follows with the next timer call, so no busy waiting is needed.
+  During moves the stepper interrupt executes babysteps inside the step loop.
+*/
+void Printer::zBabystep()
+{
     bool dir = zBabystepsMissing > 0;
-    if(dir) zBabystepsMissing--; else zBabystepsMissing++;
-#if DRIVE_SYSTEM == 3
-        Printer::enableXStepper();
-        Printer::enableYStepper();
-#endif
-        Printer::enableZStepper();
-        Printer::unsetAllSteppersDisabled();
 #if DRIVE_SYSTEM == 3
-        bool xDir = Printer::getXDirection();
-        bool yDir = Printer::getYDirection();
+    Printer::enableXStepper();
+    Printer::enableYStepper();
 #endif
-        bool zDir = Printer::getZDirection();
+    Printer::enableZStepper();
+    Printer::unsetAllSteppersDisabled();
 #if DRIVE_SYSTEM == 3
+    if(Printer::getXDirection() != dir || Printer::getYDirection() != dir || Printer::getZDirection() != dir)
+    {
         Printer::setXDirection(dir);
         Printer::setYDirection(dir);
-#endif
         Printer::setZDirection(dir);
+        return;
+    }
+#else
+    if(Printer::getZDirection() != dir)
+    {
+        Printer::setZDirection(dir);
+        return;
+    }
+#endif
+    if(dir) zBabystepsMissing--;
+    else zBabystepsMissing++;
 #if DRIVE_SYSTEM == 3
-        WRITE(X_STEP_PIN,HIGH);
+    WRITE(X_STEP_PIN,HIGH);
 #if FEATURE_TWO_XSTEPPER
-        WRITE(X2_STEP_PIN,HIGH);
+    WRITE(X2_STEP_PIN,HIGH);
 #endif
-        WRITE(Y_STEP_PIN,HIGH);
+    WRITE(Y_STEP_PIN,HIGH);
 #if FEATURE_TWO_YSTEPPER
-        WRITE(Y2_STEP_PIN,HIGH);
+    WRITE(Y2_STEP_PIN,HIGH);
 #endif
 #endif
-        WRITE(Z_STEP_PIN,HIGH);
+    WRITE(Z_STEP_PIN,HIGH);
 #if FEATURE_TWO_ZSTEPPER
-        WRITE(Z2_STEP_PIN,HIGH);
+    WRITE(Z2_STEP_PIN,HIGH);
 #endif
-        HAL::delayMicroseconds(STEPPER_HIGH_DELAY + 2);
-        Printer::endXYZSteps();
-#if DRIVE_SYSTEM == 3
-        Printer::setXDirection(xDir);
-        Printer::setYDirection(yDir);
+    Printer::insertStepperHighDelay();
+    Printer::endXYZSteps();
+}
+
+#if FEATURE_REALTIME_COMMANDS
+/**
+  Called from the serial receive interrupt for real time command bytes. Only changes
+  states, the stepper interrupt and main loop do the work.
+*/
+void Printer::handleRealtimeCommand(uint8_t c)
+{
+    switch(c)
+    {
+    case RT_CMD_FEED_HOLD:
+        if(feedHoldState <= FEED_HOLD_RESUMED)
+            feedHoldState = FEED_HOLD_REQUESTED;
+        else if(feedHoldState == FEED_HOLD_RESUME)
+            feedHoldState = FEED_HOLD_STOPPED;
+        break;
+    case RT_CMD_CYCLE_START:
+        if(feedHoldState == FEED_HOLD_STOPPED)
+            feedHoldState = FEED_HOLD_RESUME;
+        else if(feedHoldState == FEED_HOLD_REQUESTED) // Not started yet
+            feedHoldState = FEED_HOLD_RESUMED;
+        break;
+    case RT_CMD_SOFT_RESET:
+        Commands::emergencyStop();
+        break;
+    case RT_CMD_STATUS:
+        realtimeStatusRequested = 1;
+        break;
+#if FEATURE_LIVE_OVERRIDES
+    case RT_CMD_FEED_RESET:
+        realtimeFeedrateMultiply = 100;
+        break;
+    case RT_CMD_FEED_PLUS:
+    case RT_CMD_FEED_MINUS:
+    {
+        int16_t f = (realtimeFeedrateMultiply ? realtimeFeedrateMultiply : feedrateMultiply);
+        f += (c == RT_CMD_FEED_PLUS ? 10 : -10);
+        if(f < 25) f = 25;
+        if(f > 500) f = 500;
+        realtimeFeedrateMultiply = f;
+    }
+    break;
+    case RT_CMD_LASER_RESET:
+        realtimeLaserMultiply = 100;
+        break;
+    case RT_CMD_LASER_PLUS:
+    case RT_CMD_LASER_MINUS:
+    {
+        int16_t l = (realtimeLaserMultiply ? realtimeLaserMultiply : get_laser_multiply());
+        l += (c == RT_CMD_LASER_PLUS ? 10 : -10);
+        if(l < 10) l = 10;
+        if(l > 200) l = 200;
+        realtimeLaserMultiply = l;
+    }
+    break;
 #endif
-        Printer::setZDirection(zDir);
-        //HAL::delayMicroseconds(STEPPER_HIGH_DELAY + 1);
+    }
+}
+
+/** Answer to the status real time command, called from main loop. */
+void Printer::reportRealtimeStatus()
+{
+    uint8_t state = feedHoldState;
+    Com::printF(Com::tRtStatus);
+    if(state == FEED_HOLD_STOPPED)
+        Com::printF(Com::tRtHold);
+    else if(state >= FEED_HOLD_REQUESTED && state != FEED_HOLD_RESUME)
+        Com::printF(Com::tRtHolding);
+    else if(PrintLine::hasLines())
+        Com::printF(Com::tRtRun);
+    else
+        Com::printF(Com::tRtIdle);
+    Com::printF(Com::tRtQueue,(int)PrintLine::linesCount);
+    Com::print(' ');
+    Commands::printCurrentPosition();
 }
+#endif // FEATURE_REALTIME_COMMANDS
 
 
 void Printer::setAutolevelActive(bool on)
@@ -1376,6 +1668,108 @@ void Printer::waitForZProbeStart()
     UI_CLEAR_STATUS;
 #endif
 }
+
+#if FEATURE_MESH_LEVELING
+/** Moves z down until the probe triggers and sets the z position to the trigger point.
+A probe already triggered at the start is retracted by the full bed distance first. */
+static bool probeTouch(float speed)
+{
+    Commands::waitUntilEndOfAllMoves();
+    if(Printer::isZProbeHit())
+    {
+        PrintLine::moveRelativeDistanceInSteps(0,0,EEPROM::zProbeBedDistance() * Printer::axisStepsPerMM[Z_AXIS],0,EEPROM::zProbeSpeed(),true,false);
+        if(Printer::isZProbeHit())
+        {
+            Com::printErrorFLN(Com::tZProbeFailed);
+            return false;
+        }
+    }
+    Printer::stepsRemainingAtZHit = -1;
+    Printer::setZProbingActive(true);
+    PrintLine::moveRelativeDistanceInSteps(0,0,-2 * (Printer::zMaxSteps - Printer::zMinSteps),0,speed,true,true);
+    Printer::setZProbingActive(false);
+    if(Printer::stepsRemainingAtZHit < 0)
+    {
+        Com::printErrorFLN(Com::tZProbeFailed);
+        return false;
+    }
+    Printer::currentPositionSteps[Z_AXIS] += Printer::stepsRemainingAtZHit;
+    return true;
+}
+
+/**
+  Measures the height map. Only the first point is found with a fast approach and a slow confirm.
+  The grid is measured row by row in alternating direction, each further point with a single slow
+  touch started just above the highest already measured neighbour. Travel between points moves xy
+  and z together. Heights are relative to the first point, every row is reported when done.
+  Returns false if the probe did not trigger.
+*/
+bool Printer::probeMesh()
+{
+    Printer::setMeshActive(false);
+#if FEATURE_AUTOLEVEL
+    Printer::setAutolevelActive(false);
+#endif
+    GCode::executeFString(Com::tZProbeStartScript);
+    float oldOffX = Printer::offsetX;
+    float oldOffY = Printer::offsetY;
+    Printer::offsetX = -EEPROM::zProbeXOffset();
+    Printer::offsetY = -EEPROM::zProbeYOffset();
+    float spacingX = (float)(MESH_MAX_X - MESH_MIN_X) / (MESH_GRID_X - 1);
+    float spacingY = (float)(MESH_MAX_Y - MESH_MIN_Y) / (MESH_GRID_Y - 1);
+    int32_t untrigger = (float)Z_PROBE_SWITCHING_DISTANCE * axisStepsPerMM[Z_AXIS];
+    float base = 0; // trigger height of the first point
+    int16_t top = 0; // highest measured height
+    bool ok = true;
+    for(uint8_t y = 0; ok && y < MESH_GRID_Y; y++)
+    {
+        for(uint8_t i = 0; i < MESH_GRID_X; i++)
+        {
+            uint8_t x = (y & 1 ? MESH_GRID_X - 1 - i : i);
+            int8_t ahead = (y & 1 ? -1 : 1);
+            float px = MESH_MIN_X + x * spacingX;
+            float py = MESH_MIN_Y + y * spacingY;
+            if(y == 0 && i == 0)
+            {
+                moveTo(px,py,IGNORE_COORDINATE,IGNORE_COORDINATE,EEPROM::zProbeXYSpeed());
+                waitForZProbeStart();
+                if(!(ok = probeTouch(Z_PROBE_FAST_SPEED))) break;
+                PrintLine::moveRelativeDistanceInSteps(0,0,untrigger,0,EEPROM::zProbeSpeed(),true,false);
+                if(!(ok = probeTouch(EEPROM::zProbeSpeed()))) break;
+                base = currentPositionSteps[Z_AXIS] * invAxisStepsPerMM[Z_AXIS];
+                setMeshHeight(0,0,0);
+                continue;
+            }
+            // Expected height is the highest neighbour: previous point, point in the last row and the one after it
+            int16_t expected = (i > 0 ? meshHeight[y][x - ahead] : meshHeight[y - 1][x]);
+            if(y > 0)
+            {
+                expected = RMath::max(expected,meshHeight[y - 1][x]);
+                if(i + 1 < MESH_GRID_X)
+                    expected = RMath::max(expected,meshHeight[y - 1][x + ahead]);
+            }
+            PrintLine::moveRelativeDistanceInSteps(0,0,untrigger,0,EEPROM::zProbeSpeed(),true,false);
+            moveTo(px,py,base + expected * 0.001f + MESH_PROBE_CLEARANCE,IGNORE_COORDINATE,EEPROM::zProbeXYSpeed());
+            if(!(ok = probeTouch(EEPROM::zProbeSpeed()))) break;
+            setMeshHeight(x,y,currentPositionSteps[Z_AXIS] * invAxisStepsPerMM[Z_AXIS] - base);
+            top = RMath::max(top,meshHeight[y][x]);
+        }
+        if(ok)
+            reportMeshRow(y);
+    }
+    // Leave probe area above the highest point
+    Commands::waitUntilEndOfAllMoves();
+    PrintLine::moveRelativeDistanceInSteps(0,0,(base + top * 0.001f + EEPROM::zProbeBedDistance()) * axisStepsPerMM[Z_AXIS] - currentPositionSteps[Z_AXIS],
+                                           0,EEPROM::zProbeSpeed(),true,false);
+    GCode::executeFString(Com::tZProbeEndScript);
+    PrintLine::moveRelativeDistanceInSteps((oldOffX - Printer::offsetX) * axisStepsPerMM[X_AXIS],
+                                           (oldOffY - Printer::offsetY) * axisStepsPerMM[Y_AXIS],0,0,EEPROM::zProbeXYSpeed(),true,ALWAYS_CHECK_ENDSTOPS);
+    Printer::offsetX = oldOffX;
+    Printer::offsetY = oldOffY;
+    updateCurrentPosition(true);
+    return ok;
+}
+#endif
 #if FEATURE_AUTOLEVEL
 void Printer::transformToPrinter(float x,float y,float z,float &transX,float &transY,float &transZ)
 {
@@ -1435,3 +1829,111 @@ void Printer::buildTransformationMatrix(float h1,float h2,float h3)
 #endif
 
 #endif
+
+#if FEATURE_MESH_LEVELING
+void Printer::setMeshActive(bool on)
+{
+    if(on == isMeshActive()) return;
+    flag1 = (on ? flag1 | PRINTER_FLAG1_MESH_ACTIVE : flag1 & ~PRINTER_FLAG1_MESH_ACTIVE);
+    if(on)
+        Com::printInfoFLN(Com::tMeshEnabled);
+    else
+        Com::printInfoFLN(Com::tMeshDisabled);
+    updateCurrentPosition(false);
+}
+
+void Printer::resetMesh()
+{
+    for(uint8_t y = 0; y < MESH_GRID_Y; y++)
+        for(uint8_t x = 0; x < MESH_GRID_X; x++)
+            meshHeight[y][x] = 0;
+    updateCurrentPosition(false);
+}
+
+/** Sets the height of grid point x,y in mm. Heights are limited to +/-MESH_MAX_HEIGHT um. */
+void Printer::setMeshHeight(int x,int y,float height)
+{
+    if(x < 0 || x >= MESH_GRID_X || y < 0 || y >= MESH_GRID_Y) return;
+    long um = floor(height * 1000.0f + 0.5f);
+    meshHeight[y][x] = RMath::max(RMath::min(um,(long)MESH_MAX_HEIGHT),(long)-MESH_MAX_HEIGHT);
+    updateCurrentPosition(false);
+}
+
+void Printer::reportMeshRow(uint8_t y)
+{
+    Com::printF(Com::tMeshRow,(int)y);
+    Com::printF(Com::tColon);
+    for(uint8_t x = 0; x < MESH_GRID_X; x++)
+        Com::printF(Com::tSpace,meshHeight[y][x] * 0.001f,3);
+    Com::println();
+}
+
+void Printer::reportMesh()
+{
+    for(uint8_t y = 0; y < MESH_GRID_Y; y++)
+        reportMeshRow(y);
+}
+
+/**
+  Returns the z correction in steps for printer position x,y (steps) by bilinear interpolation
+  of the height map. Only integer math is used, weights have 8 bit fractions.
+*/
+int32_t Printer::meshCorrectionSteps(int32_t x,int32_t y)
+{
+    uint16_t fx,fy;
+    uint8_t ix = meshCell(x - meshMinSteps[X_AXIS],X_AXIS,fx);
+    uint8_t iy = meshCell(y - meshMinSteps[Y_AXIS],Y_AXIS,fy);
+    int32_t h0 = (int32_t)meshHeight[iy][ix] * (256 - fx) + (int32_t)meshHeight[iy][ix + 1] * fx;
+    int32_t h1 = (int32_t)meshHeight[iy + 1][ix] * (256 - fx) + (int32_t)meshHeight[iy + 1][ix + 1] * fx;
+    int32_t um = (h0 * (256 - fy) + h1 * fy + 32768) >> 16;
+    return (um * meshStepsPerUm + 32768) >> 16;
+}
+#endif
+
+#if FEATURE_TIME_ESTIMATION
+/** Clears the estimation and remembers the position, as simulated moves change it without moving. */
+void Printer::startTimeEstimate()
+{
+    for(uint8_t i = 0; i < 4; i++)
+        estimateStartSteps[i] = currentPositionSteps[i];
+    BEGIN_INTERRUPT_PROTECTED
+    estimatedTime = 0;
+    estimatedLayerTime = 0;
+    estimatedLastLayerTime = 0;
+    estimatedLayers = 0;
+    estimateLayerDone = 0;
+    END_INTERRUPT_PROTECTED
+}
+
+void Printer::reportLayerEstimate()
+{
+    float t;
+    uint16_t layer;
+    BEGIN_INTERRUPT_PROTECTED
+    t = estimatedLastLayerTime;
+    layer = estimatedLayers;
+    estimateLayerDone = 0;
+    END_INTERRUPT_PROTECTED
+    Com::printF(Com::tEstimateLayer,(int32_t)layer);
+    Com::printF(Com::tSpace,t,1);
+    Com::printFLN(Com::tEstimateSeconds);
+}
+
+/** Reports the time of all moves simulated since the estimation was started. Call only after all moves are finished. */
+void Printer::reportTimeEstimate()
+{
+    if(estimateLayerDone)
+        reportLayerEstimate();
+    Com::printF(Com::tEstimateTotal,estimatedTime,1);
+    Com::printFLN(Com::tEstimateSeconds);
+}
+
+/** Reports the estimation and moves the position back to where the estimation started. Call only after all moves are finished. */
+void Printer::stopTimeEstimate()
+{
+    reportTimeEstimate();
+    for(uint8_t i = 0; i < 4; i++)
+        currentPositionSteps[i] = estimateStartSteps[i];
+    updateCurrentPosition(true);
+}
+#endif
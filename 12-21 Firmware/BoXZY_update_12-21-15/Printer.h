@@ -49,6 +49,20 @@ typedef enum {
 #define PRINTER_FLAG1_ALLKILLED             8
 #define PRINTER_FLAG1_UI_ERROR_MESSAGE      16
 #define PRINTER_FLAG1_NO_DESTINATION_CHECK  32
+#define PRINTER_FLAG1_MESH_ACTIVE           64
+
+// States of feed hold handled by the stepper interrupt
+#define FEED_HOLD_NONE          0
+#define FEED_HOLD_RESUMED       1 ///< Running, but current move was held before
+#define FEED_HOLD_REQUESTED     2
+#define FEED_HOLD_DECELERATING  3
+#define FEED_HOLD_STOPPED       4
+#define FEED_HOLD_RESUME        5
+
+#define HOMING_NONE             0
+#define HOMING_SEEK             1 ///< Fast move to the endstops, decelerates when one triggers
+#define HOMING_STOPPING         2 ///< Seek move decelerates through the triggered endstop
+#define HOMING_TOUCH            3 ///< Slow move, stops at the endstop
 
 class Printer
 {
@@ -78,6 +92,14 @@ public:
     static uint8_t unitIsInches;
 
     static uint8_t debugLevel;
+#if FEATURE_TIME_ESTIMATION
+    static float estimatedTime;            ///< Seconds of all simulated moves
+    static float estimatedLayerTime;       ///< Seconds of the current layer
+    static float estimatedLastLayerTime;   ///< Seconds of the last finished layer
+    static uint16_t estimatedLayers;       ///< Finished layers
+    static volatile uint8_t estimateLayerDone; ///< Set by the stepper interrupt when a layer needs to be reported
+    static long estimateStartSteps[4];     ///< Position when the estimation started, restored when it ends
+#endif
     static uint8_t flag0,flag1; // 1 = stepper disabled, 2 = use external extruder interrupt, 4 = temp Sensor defect, 8 = homed
     static uint8_t stepsPerTimerCall;
     static unsigned long interval;    ///< Last step duration in ticks.
@@ -123,6 +145,13 @@ public:
 #endif
 #if FEATURE_AUTOLEVEL
     static float autolevelTransformation[9]; ///< Transformation matrix
+#endif
+#if FEATURE_MESH_LEVELING
+    static int16_t meshHeight[MESH_GRID_Y][MESH_GRID_X]; ///< Bed height map in um
+    static int32_t meshMinSteps[2];          ///< Position of the first grid point in x and y steps
+    static int32_t meshSpacingSteps[2];      ///< Distance of grid points in x and y steps
+    static uint32_t meshCellFactor[2];       ///< 2^24/meshSpacingSteps, converts steps into cells with 8 bit fraction
+    static int32_t meshStepsPerUm;           ///< Z steps per um with 16 bit fraction
 #endif
     static signed char zBabystepsMissing;
     static float minimumSpeed;               ///< lowest allowed speed to keep integration error small
@@ -149,6 +178,8 @@ public:
     static float offsetX;                     ///< X-offset for different extruder positions.
     static float offsetY;                     ///< Y-offset for different extruder positions.
     static speed_t vMaxReached;         ///< Maximumu reached speed
+    static speed_t rampDivisor;         ///< Speed the last ramp interval was computed for
+    static unsigned long rampTicks;     ///< Last ramp interval
     static unsigned long msecondsPrinting;            ///< Milliseconds of printing time (means time with heated extruder)
     static float filamentPrinted;            ///< mm of filament printed since counting started
     static uint8_t wasLastHalfstepping;         ///< Indicates if last move had halfstepping enabled
@@ -157,6 +188,9 @@ public:
     static float backlashY;
     static float backlashZ;
     static uint8_t backlashDir;
+    static uint16_t backlashSteps[3];       ///< Backlash in steps for x, y and z
+    static ticks_t backlashInterval[3];     ///< Shortest timer interval a takeup step is allowed in
+    static uint16_t backlashMissing[3];     ///< Takeup steps still to do before the move starts, modified by the stepper interrupt
 #endif
 #ifdef DEBUG_STEPCOUNT
     static long totalStepsRemaining;
@@ -179,6 +213,24 @@ public:
     static float maxRealJerk;
 #endif
     static BoXZY_head_t BoXZY_head;
+#if FEATURE_FAST_HOMING
+    static volatile uint8_t homingState;     ///< HOMING_xxx state of the running homing move
+    static long homingStepsLeft;             ///< Primary axis steps of the homing move not done after the endstop triggered
+    static int32_t homingDeviation[3];       ///< Last endstop position relative to the expected home position in steps
+    static int32_t homingDeviationMin[3];
+    static int32_t homingDeviationMax[3];
+    static uint16_t homingCount[3];          ///< Homings with known start position
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    static volatile uint8_t feedHoldState;   ///< FEED_HOLD_xxx state
+    static speed_t feedHoldVEnd;             ///< Planned end speed of the held move, 0 = none
+    static uint8_t feedHoldLaserPower;       ///< Laser power to restore on resume
+    static volatile uint8_t realtimeStatusRequested;
+#if FEATURE_LIVE_OVERRIDES
+    static volatile int16_t realtimeFeedrateMultiply; ///< Requested feedrate multiplier, 0 = none
+    static volatile uint8_t realtimeLaserMultiply;    ///< Requested laser power multiplier, 0 = none
+#endif
+#endif
     
     static inline void setMenuMode(uint8_t mode,bool on) {
         if(on)
@@ -212,6 +264,15 @@ public:
     static inline bool debugNoMoves() {
         return ((debugLevel & 32)!=0);
     }
+#if FEATURE_TIME_ESTIMATION
+    static inline bool debugEstimateTime() {
+        return ((debugLevel & 64)!=0);
+    }
+    static void startTimeEstimate();
+    static void stopTimeEstimate();
+    static void reportTimeEstimate();
+    static void reportLayerEstimate();
+#endif
 
     /** \brief Disable stepper motor for x direction. */
     static inline void disableXStepper()
@@ -544,6 +605,19 @@ public:
         }
 #endif
     }
+#if ENABLE_BACKLASH_COMPENSATION
+    /** Starts the backlash takeup for the axes in mask (1 = X, 2 = Y, 4 = Z). The takeup of a move
+    always finishes before the move steps, so nothing is left over from earlier moves. */
+    static inline void startBacklashTakeup(uint8_t axes)
+    {
+        for(uint8_t i = 0; i < 3; i++)
+            backlashMissing[i] = (axes & (1 << i) ? backlashSteps[i] : 0);
+    }
+    static inline bool isBacklashTakeupRunning()
+    {
+        return backlashMissing[X_AXIS] || backlashMissing[Y_AXIS] || backlashMissing[Z_AXIS];
+    }
+#endif
     static inline void endXYZSteps()
     {
         WRITE(X_STEP_PIN,LOW);
@@ -590,6 +664,19 @@ public:
         }
         return vbase;
     }
+    /** Interval for the next step of a speed ramp, v as returned by updateStepsPerTimerCall.
+    The division is only repeated if v changed by more than 1/2^RAMP_INTERVAL_SHIFT since the
+    last one. At high step rates v changes only a few steps/s per call, so most are skipped. */
+    static inline unsigned long rampInterval(speed_t v)
+    {
+#if RAMP_INTERVAL_SHIFT
+        speed_t diff = (v > rampDivisor ? v - rampDivisor : rampDivisor - v);
+        if(diff <= (rampDivisor >> RAMP_INTERVAL_SHIFT))
+            return rampTicks;
+#endif
+        rampDivisor = v;
+        return rampTicks = HAL::CPUDivU2(v);
+    }
     static inline void disableAllowedStepper()
     {
 #ifdef XY_GANTRY
@@ -640,6 +727,10 @@ public:
     static void moveTo(float x,float y,float z,float e,float f);
     static void moveToReal(float x,float y,float z,float e,float f);
     static void homeAxis(bool xaxis,bool yaxis,bool zaxis); /// Home axis
+#if FEATURE_FAST_HOMING
+    static void reportHomingStatistics();
+    static void resetHomingStatistics();
+#endif
     static void setOrigin(float xOff,float yOff,float zOff);
     static bool isPositionAllowed(float x,float y,float z);
     static inline int getFanSpeed() {
@@ -667,11 +758,62 @@ public:
     static void buildTransformationMatrix(float h1,float h2,float h3);
 #endif
 #endif
+#if FEATURE_MESH_LEVELING
+    static inline bool isMeshActive()
+    {
+        return (flag1 & PRINTER_FLAG1_MESH_ACTIVE)!=0;
+    }
+    static void setMeshActive(bool on);
+    static void resetMesh();
+    static void setMeshHeight(int x,int y,float height);
+    static void reportMesh();
+    static void reportMeshRow(uint8_t y);
+#if FEATURE_Z_PROBE
+    static bool probeMesh();
+#endif
+    static int32_t meshCorrectionSteps(int32_t x,int32_t y);
+    /** Returns the grid cell containing distance d (steps from the first grid point) and
+    the position inside the cell in 1/256. Outside of the grid the border cells are extended. */
+    static inline uint8_t meshCell(int32_t d,uint8_t axis,uint16_t &fraction)
+    {
+        uint8_t lastCell = (axis == X_AXIS ? MESH_GRID_X : MESH_GRID_Y) - 2;
+        if(d <= 0)
+        {
+            fraction = 0;
+            return 0;
+        }
+        uint32_t pos = ((uint32_t)d * meshCellFactor[axis]) >> 16;
+        if((pos >> 8) > lastCell)
+        {
+            fraction = 256;
+            return lastCell;
+        }
+        fraction = pos & 255;
+        return pos >> 8;
+    }
+#endif
 #if FEATURE_MEMORY_POSITION
     static void MemoryPosition();
     static void GoToMemoryPosition(bool x,bool y,bool z,bool e,float feed);
 #endif
     static void zBabystep();
+#if FEATURE_REALTIME_COMMANDS
+    static inline bool isRealtimeCommand(uint8_t c)
+    {
+        return c == RT_CMD_FEED_HOLD || c == RT_CMD_CYCLE_START || c == RT_CMD_SOFT_RESET || c == RT_CMD_STATUS
+#if FEATURE_LIVE_OVERRIDES
+               || c == RT_CMD_FEED_RESET || c == RT_CMD_FEED_PLUS || c == RT_CMD_FEED_MINUS
+               || c == RT_CMD_LASER_RESET || c == RT_CMD_LASER_PLUS || c == RT_CMD_LASER_MINUS
+#endif
+               ;
+    }
+    static void handleRealtimeCommand(uint8_t c);
+    static void reportRealtimeStatus();
+    static inline bool isFeedHold()
+    {
+        return feedHoldState >= FEED_HOLD_REQUESTED;
+    }
+#endif
 private:
     static void homeXAxis();
     static void homeYAxis();
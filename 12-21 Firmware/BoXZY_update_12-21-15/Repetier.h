@@ -143,6 +143,138 @@ usage or for seraching for memory induced errors. Switch it off for production,
 #define NONLINEAR_SYSTEM false
 #endif
 
+#ifndef FEATURE_REALTIME_COMMANDS
+#define FEATURE_REALTIME_COMMANDS 0
+#endif
+#ifndef RAMP_INTERVAL_SHIFT
+#define RAMP_INTERVAL_SHIFT 0
+#endif
+#ifndef FEATURE_LIVE_OVERRIDES
+#define FEATURE_LIVE_OVERRIDES 0
+#endif
+#if FEATURE_LIVE_OVERRIDES && NONLINEAR_SYSTEM
+#undef FEATURE_LIVE_OVERRIDES
+#define FEATURE_LIVE_OVERRIDES 0 // Split delta moves can not be rescaled
+#endif
+#ifndef FEATURE_STEP_SEGMENTS
+#define FEATURE_STEP_SEGMENTS 0
+#endif
+#if FEATURE_STEP_SEGMENTS && (NONLINEAR_SYSTEM || defined(USE_ADVANCE))
+#undef FEATURE_STEP_SEGMENTS
+#define FEATURE_STEP_SEGMENTS 0 // Segments are only implemented for cartesian printer without advance
+#endif
+#ifndef STEP_SEGMENTS_PER_SECOND
+#define STEP_SEGMENTS_PER_SECOND 400
+#endif
+#ifndef STEP_SEGMENT_CACHE_SIZE
+#define STEP_SEGMENT_CACHE_SIZE 8
+#endif
+#ifndef STEP_SEGMENT_LINES_AHEAD
+#define STEP_SEGMENT_LINES_AHEAD 3
+#endif
+#ifndef FEATURE_MESH_LEVELING
+#define FEATURE_MESH_LEVELING 0
+#endif
+#if FEATURE_MESH_LEVELING && NONLINEAR_SYSTEM
+#undef FEATURE_MESH_LEVELING
+#define FEATURE_MESH_LEVELING 0 // Height map is only applied to cartesian moves
+#endif
+#ifndef FEATURE_QUEUE_CONTROL
+#define FEATURE_QUEUE_CONTROL 0
+#endif
+#ifndef QUEUE_UNDERRUN_TIME
+#define QUEUE_UNDERRUN_TIME 500
+#endif
+#ifndef FEATURE_FAST_HOMING
+#define FEATURE_FAST_HOMING 0
+#endif
+#if FEATURE_FAST_HOMING && DRIVE_SYSTEM != 0
+#undef FEATURE_FAST_HOMING
+#define FEATURE_FAST_HOMING 0 // Seek moves need independent x and y motors
+#endif
+#ifndef HOMING_SEEK_OVERTRAVEL
+#define HOMING_SEEK_OVERTRAVEL 2
+#endif
+#ifndef ENDSTOP_X_BACK_ON_HOME
+#define ENDSTOP_X_BACK_ON_HOME 0
+#endif
+#ifndef ENDSTOP_Y_BACK_ON_HOME
+#define ENDSTOP_Y_BACK_ON_HOME 0
+#endif
+#ifndef ENDSTOP_Z_BACK_ON_HOME
+#define ENDSTOP_Z_BACK_ON_HOME 0
+#endif
+#ifndef FEATURE_CANNED_CYCLES
+#define FEATURE_CANNED_CYCLES 0
+#endif
+#ifndef CANNED_PECK_CLEARANCE
+#define CANNED_PECK_CLEARANCE 0.5
+#endif
+#ifndef FEATURE_BINARY_V3
+#define FEATURE_BINARY_V3 0
+#endif
+#ifndef FEATURE_OK_BUFFER_SPACE
+#define FEATURE_OK_BUFFER_SPACE 0
+#endif
+#ifndef FEATURE_SELECTIVE_RESEND
+#define FEATURE_SELECTIVE_RESEND 0
+#endif
+#ifndef RESEND_WINDOW
+#define RESEND_WINDOW 3
+#endif
+#if RESEND_WINDOW > 8
+#undef RESEND_WINDOW
+#define RESEND_WINDOW 8 // slots are tracked in one byte
+#endif
+#ifndef GCODE_QUEUE_BYTES
+#define GCODE_QUEUE_BYTES 240
+#endif
+#ifndef FEATURE_SERIAL_ERRORS
+#define FEATURE_SERIAL_ERRORS 0
+#endif
+#ifndef FEATURE_OUTPUT_BUFFER
+#define FEATURE_OUTPUT_BUFFER 0
+#endif
+#ifndef FEATURE_AUTO_REPORT
+#define FEATURE_AUTO_REPORT 0
+#endif
+#ifndef OUTPUT_LINE_SIZE
+#define OUTPUT_LINE_SIZE 96
+#endif
+#if OUTPUT_LINE_SIZE > 255
+#undef OUTPUT_LINE_SIZE
+#define OUTPUT_LINE_SIZE 255 // length is tracked in one byte
+#endif
+#ifndef FEATURE_SUBPROGRAMS
+#define FEATURE_SUBPROGRAMS 0
+#endif
+#ifndef SUBPROGRAM_EEPROM_START
+#define SUBPROGRAM_EEPROM_START 2048
+#endif
+#ifndef SUBPROGRAM_EEPROM_SIZE
+#define SUBPROGRAM_EEPROM_SIZE 2048
+#endif
+#ifndef SUBPROGRAM_STACK_DEPTH
+#define SUBPROGRAM_STACK_DEPTH 3
+#endif
+#ifndef FEATURE_TIME_ESTIMATION
+#define FEATURE_TIME_ESTIMATION 0
+#endif
+#if FEATURE_TIME_ESTIMATION && NONLINEAR_SYSTEM
+#undef FEATURE_TIME_ESTIMATION
+#define FEATURE_TIME_ESTIMATION 0 // Only the cartesian stepper interrupt integrates move times
+#endif
+#ifndef Z_PROBE_FAST_SPEED
+#define Z_PROBE_FAST_SPEED Z_PROBE_SPEED
+#endif
+#ifndef MESH_PROBE_CLEARANCE
+#define MESH_PROBE_CLEARANCE 1
+#endif
+#if FEATURE_MESH_LEVELING && (MESH_GRID_X < 2 || MESH_GRID_Y < 2)
+#error The height map needs at least 2 points per axis
+#endif
+#define MESH_MAX_HEIGHT 10000 // Largest height map value in um, keeps the fixed point math in 32 bit
+
 #ifdef FEATURE_Z_PROBE
 #define MANUAL_CONTROL true
 #endif
@@ -287,7 +419,7 @@ usage or for seraching for memory induced errors. Switch it off for production,
 #include "SdFat.h"
 #endif
 
-#if ENABLE_BACKLASH_COMPENSATION && DRIVE_SYSTEM!=0
+#if ENABLE_BACKLASH_COMPENSATION && DRIVE_SYSTEM==3
 #undef ENABLE_BACKLASH_COMPENSATION
 #define ENABLE_BACKLASH_COMPENSATION false
 #endif
@@ -460,6 +592,36 @@ private:
 extern SDCard sd;
 #endif
 
+#if FEATURE_SUBPROGRAMS
+/** Subprograms are stored in EEPROM as a list of records made of a name length byte,
+the name, a 16 bit body length and the binary encoded commands. A name length of 0 or 255
+ends the list, bit 7 marks a deleted record. */
+#define SUBPROGRAM_NAME_LENGTH 16
+class Subprograms
+{
+public:
+    static void list();
+    static void erase(char *name);
+    static void startRecording(char *name);
+    static void record(GCode *com);
+    static void call(GCode *com);
+    static inline bool isRecording()
+    {
+        return recordStart != 0;
+    }
+private:
+    static unsigned int find(char *name);
+    static unsigned int endOfList();
+    static uint8_t encode(GCode *com,uint8_t *buf);
+    static void finishRecording();
+
+    static unsigned int recordStart; ///< Position of the record being written, 0 if not recording
+    static unsigned int recordPos; ///< Next free byte of the record being written
+    static uint8_t depth; ///< Number of active nested calls
+    static char recordName[SUBPROGRAM_NAME_LENGTH+1];
+};
+#endif
+
 extern volatile int waitRelax; // Delay filament relax at the end of print, could be a simple timeout
 extern void updateStepsParameter(PrintLine *p/*,uint8_t caller*/);
 
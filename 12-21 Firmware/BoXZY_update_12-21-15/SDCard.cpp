@@ -170,6 +170,16 @@ void SDCard::writeCommand(GCode *code)
     file.writeError = false;
     int params = 128 | (code->params & ~1);
     *(int*)buf = params;
+#if FEATURE_BINARY_V3
+    if(code->isBatch())   // V3 frame is stored as received, without line number
+    {
+        *(int*)&buf[p] = 0;
+        p+=2;
+        for(uint8_t i = 0; i <= (uint8_t)code->text[0]; i++)
+            buf[p++] = code->text[i];
+    }
+    else
+#endif
     if(code->isV2())   // Read G,M as 16 bit value
     {
         *(int*)&buf[p] = code->params2;
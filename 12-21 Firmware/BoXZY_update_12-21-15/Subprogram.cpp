@@ -0,0 +1,353 @@
+/*
+    This file is part of BoXZY's version of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Functions in this file record, list and call the subprograms stored in EEPROM.
+*/
+
+#include "Repetier.h"
+
+#if FEATURE_SUBPROGRAMS
+
+#define SUBPROGRAM_END (SUBPROGRAM_EEPROM_START+SUBPROGRAM_EEPROM_SIZE)
+#define SUBPROGRAM_DELETED 128
+#define SUBPROGRAM_MAX_COMMAND 140 // Largest binary command including a 80 char string
+
+#if defined(E2END) && SUBPROGRAM_END > E2END + 1
+#error Subprogram area exceeds the EEPROM size
+#endif
+#if SUBPROGRAM_EEPROM_START < 2048
+#error Subprogram area overlaps the checksummed EEPROM parameters
+#endif
+
+unsigned int Subprograms::recordStart = 0;
+unsigned int Subprograms::recordPos;
+uint8_t Subprograms::depth = 0;
+char Subprograms::recordName[SUBPROGRAM_NAME_LENGTH+1];
+
+/** \brief Returns the start of the first not deleted record with the given name or 0 if it is not stored. */
+unsigned int Subprograms::find(char *name)
+{
+    uint8_t len = strlen(name);
+    unsigned int pos = SUBPROGRAM_EEPROM_START;
+    while(pos < SUBPROGRAM_END)
+    {
+        uint8_t nameLen = HAL::eprGetByte(pos);
+        if(nameLen == 0 || nameLen == 255) break;
+        if(nameLen == len)
+        {
+            uint8_t i = 0;
+            while(i < len && HAL::eprGetByte(pos + 1 + i) == (uint8_t)name[i]) i++;
+            if(i == len) return pos;
+        }
+        pos += 3 + (nameLen & ~SUBPROGRAM_DELETED) + (uint16_t)HAL::eprGetInt16(pos + 1 + (nameLen & ~SUBPROGRAM_DELETED));
+    }
+    return 0;
+}
+
+/** \brief Returns the position of the end marker of the record list. */
+unsigned int Subprograms::endOfList()
+{
+    unsigned int pos = SUBPROGRAM_EEPROM_START;
+    while(pos < SUBPROGRAM_END)
+    {
+        uint8_t nameLen = HAL::eprGetByte(pos);
+        if(nameLen == 0 || nameLen == 255) break;
+        nameLen &= ~SUBPROGRAM_DELETED;
+        pos += 3 + nameLen + (uint16_t)HAL::eprGetInt16(pos + 1 + nameLen);
+    }
+    return pos;
+}
+
+/** \brief Prints all stored subprograms with their size and the free space. */
+void Subprograms::list()
+{
+    unsigned int pos = SUBPROGRAM_EEPROM_START;
+    while(pos < SUBPROGRAM_END)
+    {
+        uint8_t nameLen = HAL::eprGetByte(pos);
+        if(nameLen == 0 || nameLen == 255) break;
+        uint16_t bodyLen = HAL::eprGetInt16(pos + 1 + (nameLen & ~SUBPROGRAM_DELETED));
+        if((nameLen & SUBPROGRAM_DELETED) == 0)
+        {
+            Com::printF(Com::tSubprogram);
+            for(uint8_t i = 0; i < nameLen; i++)
+                Com::print((char)HAL::eprGetByte(pos + 1 + i));
+            Com::printFLN(Com::tSpace,(int)bodyLen);
+        }
+        pos += 3 + (nameLen & ~SUBPROGRAM_DELETED) + bodyLen;
+    }
+    Com::printFLN(Com::tSubprogramFree,(int)(pos < SUBPROGRAM_END ? SUBPROGRAM_END - pos - 1 : 0));
+}
+
+/** \brief Marks a subprogram as deleted or erases all subprograms if name is NULL.
+
+Deleted records keep their space until all subprograms are erased. */
+void Subprograms::erase(char *name)
+{
+    if(name == NULL)
+    {
+        HAL::eprSetByte(SUBPROGRAM_EEPROM_START,0);
+        return;
+    }
+    unsigned int pos;
+    while((pos = find(name)) != 0)
+        HAL::eprSetByte(pos,HAL::eprGetByte(pos) | SUBPROGRAM_DELETED);
+}
+
+/** \brief Starts storing the following commands as subprogram name until M99 is received.
+
+The record header is written with a name length of 0, so an interrupted recording leaves
+a valid end marker behind. */
+void Subprograms::startRecording(char *name)
+{
+    uint8_t len = strlen(name);
+    if(len == 0 || len > SUBPROGRAM_NAME_LENGTH)
+    {
+        Com::printErrorFLN(Com::tFormatError);
+        return;
+    }
+    unsigned int start = endOfList();
+    if(start + 4 + len > SUBPROGRAM_END)
+    {
+        Com::printErrorFLN(Com::tSubprogramFull);
+        return;
+    }
+    strcpy(recordName,name);
+    HAL::eprSetByte(start,0);
+    for(uint8_t i = 0; i < len; i++)
+        HAL::eprSetByte(start + 1 + i,name[i]);
+    recordStart = start;
+    recordPos = start + 3 + len;
+}
+
+/** \brief Stores a command of the subprogram being recorded. M99 ends the recording. */
+void Subprograms::record(GCode *com)
+{
+    if(com->hasL()) // Laser scan lines are not stored, their power values must not stay in the ring
+        BoXZYLBuffer.free_recently_committed(com->L_index,com->L_end_index);
+    if(com->hasM() && com->M == 99)
+    {
+        finishRecording();
+        return;
+    }
+    if((com->hasM() && (com->M == 96 || com->M == 97))
+#if FEATURE_BINARY_V3
+            || com->isBatch()
+#endif
+      )
+    {
+        Com::printErrorFLN(Com::tUnknownCommand);
+        return;
+    }
+    uint8_t buf[SUBPROGRAM_MAX_COMMAND];
+    uint8_t len = encode(com,buf);
+    if(recordPos + len >= SUBPROGRAM_END) // keep one byte for the end marker
+    {
+        Com::printErrorFLN(Com::tSubprogramFull);
+        HAL::eprSetByte(recordStart,0);
+        recordStart = 0;
+        return;
+    }
+    for(uint8_t i = 0; i < len; i++)
+        HAL::eprSetByte(recordPos++,buf[i]);
+#ifdef ECHO_ON_EXECUTE
+    com->echoCommand();
+#endif
+}
+
+/** \brief Writes body length and end marker, replaces an older program with the same name
+and finally makes the record valid by writing its name length. */
+void Subprograms::finishRecording()
+{
+    uint8_t len = strlen(recordName);
+    HAL::eprSetInt16(recordStart + 1 + len,recordPos - recordStart - 3 - len);
+    if(recordPos < SUBPROGRAM_END)
+        HAL::eprSetByte(recordPos,0);
+    erase(recordName);
+    HAL::eprSetByte(recordStart,len);
+    Com::printF(Com::tSubprogram);
+    Com::print(recordName);
+    Com::printFLN(Com::tSpace,(int)(recordPos - recordStart - 3 - len));
+    recordStart = 0;
+}
+
+/** \brief Encodes a command in the binary protocol version 2 including the fletcher-16 checksum.
+
+Line numbers and laser scan lines are not stored. */
+uint8_t Subprograms::encode(GCode *com,uint8_t *buf)
+{
+    unsigned int params = 4096 | 128 | (com->params & ~1);
+    unsigned int params2 = com->params2 & ~(8192 | 32768);
+    uint8_t textlen = 0;
+    uint8_t p = 4;
+    *(unsigned int*)buf = params;
+    *(unsigned int*)&buf[2] = params2;
+    if(com->hasString())
+    {
+        textlen = RMath::min((int)strlen(com->text),79);
+        buf[p++] = textlen;
+    }
+    if(com->hasM())
+    {
+        *(uint16_t*)&buf[p] = com->M;
+        p+=2;
+    }
+    if(com->hasG())
+    {
+        *(uint16_t*)&buf[p] = com->G;
+        p+=2;
+    }
+    if(com->hasX())
+    {
+        *(float*)&buf[p] = com->X;
+        p+=4;
+    }
+    if(com->hasY())
+    {
+        *(float*)&buf[p] = com->Y;
+        p+=4;
+    }
+    if(com->hasZ())
+    {
+        *(float*)&buf[p] = com->Z;
+        p+=4;
+    }
+    if(com->hasE())
+    {
+        *(float*)&buf[p] = com->E;
+        p+=4;
+    }
+    if(com->hasF())
+    {
+        *(float*)&buf[p] = com->F;
+        p+=4;
+    }
+    if(com->hasT())
+    {
+        buf[p++] = com->T;
+    }
+    if(com->hasS())
+    {
+        *(int32_t*)&buf[p] = com->S;
+        p+=4;
+    }
+    if(com->hasP())
+    {
+        *(int32_t*)&buf[p] = com->P;
+        p+=4;
+    }
+    if(com->hasI())
+    {
+        *(float*)&buf[p] = com->I;
+        p+=4;
+    }
+    if(com->hasJ())
+    {
+        *(float*)&buf[p] = com->J;
+        p+=4;
+    }
+    if(com->hasR())
+    {
+        *(float*)&buf[p] = com->R;
+        p+=4;
+    }
+    if(params2 & 8)
+    {
+#if FEATURE_CANNED_CYCLES
+        *(float*)&buf[p] = com->Q;
+#endif
+        p+=4;
+    }
+    for(uint8_t i = 0; i < textlen; i++)
+        buf[p++] = com->text[i];
+    unsigned int sum1=0,sum2=0; // for fletcher-16 checksum
+    for(uint8_t i = 0; i < p; i++)
+    {
+        sum1 += buf[i];
+        if(sum1>=255) sum1-=255;
+        sum2 += sum1;
+        if(sum2>=255) sum2-=255;
+    }
+    buf[p++] = sum1;
+    buf[p++] = sum2;
+    return p;
+}
+
+/** \brief Executes subprogram com->text com->S times (L in ascii).
+
+X, Y and Z move the origin of the subprogram relative to the current coordinate system for
+the duration of the call. Commands are decoded and executed the same way executeFString does. */
+void Subprograms::call(GCode *com)
+{
+    unsigned int pos = find(com->text);
+    if(pos == 0)
+    {
+        Com::printErrorF(Com::tSubprogramUnknown);
+        Com::print(com->text);
+        Com::println();
+        return;
+    }
+    if(depth >= SUBPROGRAM_STACK_DEPTH)
+    {
+        Com::printErrorFLN(Com::tSubprogramDepth);
+        return;
+    }
+    uint8_t nameLen = HAL::eprGetByte(pos);
+    unsigned int body = pos + 3 + nameLen;
+    unsigned int bodyEnd = body + (uint16_t)HAL::eprGetInt16(pos + 1 + nameLen);
+    float shift[3];
+    shift[X_AXIS] = (com->hasX() ? Printer::convertToMM(com->X) : 0);
+    shift[Y_AXIS] = (com->hasY() ? Printer::convertToMM(com->Y) : 0);
+    shift[Z_AXIS] = (com->hasZ() ? Printer::convertToMM(com->Z) : 0);
+    for(uint8_t i = 0; i < 3; i++)
+        Printer::coordinateOffset[i] -= shift[i];
+    depth++;
+    GCode code;
+    uint8_t buf[SUBPROGRAM_MAX_COMMAND];
+    for(long repeat = com->getS(1); repeat > 0; repeat--)
+    {
+        for(pos = body; pos < bodyEnd;)
+        {
+            for(uint8_t i = 0; i < 5; i++)
+                buf[i] = HAL::eprGetByte(pos + i);
+            uint8_t len = GCode::computeBinarySize((char*)buf);
+            bool ok = len <= SUBPROGRAM_MAX_COMMAND && pos + len <= bodyEnd;
+            if(ok)
+            {
+                for(uint8_t i = 5; i < len; i++)
+                    buf[i] = HAL::eprGetByte(pos + i);
+                uint8_t receiving = GCode::binaryCommandSize; // a binary command may be received right now
+                GCode::binaryCommandSize = len;
+                ok = code.parseBinary(buf,false);
+                GCode::binaryCommandSize = receiving;
+            }
+            if(!ok)
+            {
+                Com::printErrorFLN(Com::tSubprogramCorrupt);
+                repeat = 0;
+                break;
+            }
+            pos += len;
+            Commands::executeGCode(&code);
+            Printer::defaultLoopActions();
+        }
+    }
+    depth--;
+    for(uint8_t i = 0; i < 3; i++)
+        Printer::coordinateOffset[i] += shift[i];
+}
+
+#endif
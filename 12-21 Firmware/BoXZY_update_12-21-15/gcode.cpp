@@ -29,9 +29,25 @@
 #define FEATURE_CHECKSUM_FORCED false
 #endif
 
-GCode    GCode::commandsBuffered[GCODE_BUFFER_SIZE]; ///< Buffer for received commands.
-uint8_t  GCode::bufferReadIndex=0; ///< Read position in gcode_buffer.
-uint8_t  GCode::bufferWriteIndex=0; ///< Write position in gcode_buffer.
+/** Largest packed command: size, bitfields, N, M, G, X, Y, Z, E, F, T, S, P, I, J, R, Q, L indices and text pointer. */
+#define GCODE_MAX_PACKED ((int)(11 + 5*4 + 1 + 2*4 + 4*4 + 2*4 + sizeof(char*)))
+
+#if GCODE_QUEUE_BYTES > 255
+#error GCODE_QUEUE_BYTES must not exceed 255
+#endif
+
+uint8_t  GCode::commandQueue[GCODE_QUEUE_BYTES]; ///< Ring of packed commands, each starting with its size. Size 0 marks a wrap.
+GCode    GCode::parsedCommand; ///< Command being parsed before it is packed into the queue.
+GCode    GCode::currentCommand; ///< Unpacked first command of the queue.
+bool     GCode::currentUnpacked=false; ///< currentCommand holds the command at bufferReadIndex.
+uint8_t  GCode::bufferReadIndex=0; ///< Read position in commandQueue.
+uint8_t  GCode::bufferWriteIndex=0; ///< Write position in commandQueue.
+#if FEATURE_SELECTIVE_RESEND
+static uint8_t heldCommand[RESEND_WINDOW][GCODE_MAX_PACKED]; ///< Packed lines received ahead of a missing line
+static uint16_t heldLine[RESEND_WINDOW]; ///< Line numbers of heldCommand
+static uint8_t heldSlots = 0; ///< Bit i is set if heldCommand[i] is used
+static bool resendPending = false; ///< Missing line was requested and did not arrive yet
+#endif
 uint8_t  GCode::commandReceiving[MAX_CMD_SIZE]; ///< Current received command.
 uint8_t  GCode::commandsReceivingWritePosition=0; ///< Writing position in gcode_transbuffer.
 uint8_t  GCode::sendAsBinary; ///< Flags the command as binary input.
@@ -45,6 +61,13 @@ int8_t   GCode::waitingForResend=-1; ///< Waiting for line to be resend. -1 = no
 volatile uint8_t GCode::bufferLength=0; ///< Number of commands stored in gcode_buffer
 millis_t GCode::timeOfLastDataPacket=0; ///< Time, when we got the last data packet. Used to detect missing uint8_ts.
 uint8_t  GCode::formatErrors=0;
+#if FEATURE_CANNED_CYCLES
+bool     GCode::cannedCycleParsed = false;
+#endif
+#if FEATURE_SERIAL_ERRORS
+uint32_t GCode::commandsReceived = 0;
+uint16_t GCode::resendRequests = 0;
+#endif
 
 /** \page Repetier-protocol
 
@@ -66,6 +89,20 @@ all implemented features.
 - The new protocol send data in binary format. This reduces the data size to less then 50% and
   it speeds up decoding the command. No slow conversion from string to floats are needed.
 
+\subsection V3 Version 3 frames
+
+A frame with bit 14 (16384) set in the first bitfield carries several G0/G1 moves:
+
+- 2 byte bitfield (16384 | 128, bit 0 marks a valid line number), 2 byte line number,
+  1 byte payload length (max. 89), payload, 2 byte fletcher-16 checksum over everything before.
+- Each move starts with a flag byte: bit 0-3 X, Y, Z, E present, bit 4 F present,
+  bit 5 G1 instead of G0, bit 6 laser powers present, bit 7 positions are absolute.
+- Positions are zigzag encoded LEB128 varints in steps of the axis, relative to the previous
+  V3 target unless bit 7 is set. Targets are absolute in the current coordinate system.
+- F is an unsigned varint in mm/min. Laser powers are a count byte followed by the 0..255 powers.
+
+A frame is acknowledged and resent as one line. SD files written from the host store frames unchanged.
+
 */
 
 /** \brief Computes size of binary data from bitfield.
@@ -101,6 +138,10 @@ uint8_t GCode::computeBinarySize(char *ptr)  // unsigned int bitfield) {
 {
     uint8_t s = 4; // include checksum and bitfield
     uint16_t bitfield = *(uint16_t*)ptr;
+#if FEATURE_BINARY_V3
+    if(bitfield & 16384)   // V3: bitfield, N, payload length, payload, checksum
+        return ((uint8_t)ptr[4] > MAX_CMD_SIZE - 7 ? 0 : 7 + (uint8_t)ptr[4]); // 0 if the frame can not fit into the buffer
+#endif
     if(bitfield & 1) s+=2;
     if(bitfield & 8) s+=4;
     if(bitfield & 16) s+=4;
@@ -119,7 +160,8 @@ uint8_t GCode::computeBinarySize(char *ptr)  // unsigned int bitfield) {
         if(bitfield2 & 1) s+= 4;
         if(bitfield2 & 2) s+= 4;
         if(bitfield2 & 4) s+= 4;
-        if(bitfield2 & 8096) s+= 8; // L
+        if(bitfield2 & 8) s+= 4; // Q
+        if(bitfield2 & 8192) s+= 8; // L, not used by V2 hosts, laser powers are sent with V3
         if(bitfield & 32768) s+=RMath::min(80,(uint8_t)ptr[4]+1);
     }
     else
@@ -133,8 +175,15 @@ uint8_t GCode::computeBinarySize(char *ptr)  // unsigned int bitfield) {
 
 void GCode::requestResend()
 {
+#if FEATURE_SELECTIVE_RESEND
+    heldSlots = 0; // the host sends these lines again
+    resendPending = false;
+#endif
     HAL::serialFlush();
     commandsReceivingWritePosition=0;
+#if FEATURE_SERIAL_ERRORS
+    if(resendRequests != 65535) resendRequests++;
+#endif
     if(sendAsBinary)
         waitingForResend = 30;
     else
@@ -143,6 +192,87 @@ void GCode::requestResend()
     Com::printFLN(Com::tResend,lastLineNumber+1);
     Com::printFLN(Com::tOk);
 }
+#if FEATURE_SELECTIVE_RESEND
+/** \brief Requests only the missing line. Ascii lines synchronize at the line end, so the
+input is not flushed and following lines are kept by holdCommand. */
+void GCode::requestLineResend()
+{
+    commandsReceivingWritePosition = 0;
+    resendPending = true;
+#if FEATURE_SERIAL_ERRORS
+    if(resendRequests != 65535) resendRequests++;
+#endif
+    Com::printFLN(Com::tResend,lastLineNumber+1);
+    Com::printFLN(Com::tOk);
+}
+
+/** \brief Keeps a line received ahead of a missing one. Returns false if the line can not be
+kept and a full resend is needed. */
+bool GCode::holdCommand()
+{
+    if(sendAsBinary || hasString() || hasL()) return false;
+    uint16_t ahead = (actLineNumber - lastLineNumber - 1) & 0xffff; // missing lines in front
+    if(ahead == 0 || ahead > RESEND_WINDOW) return false;
+    uint8_t slot = RESEND_WINDOW;
+    for(uint8_t i = 0; i < RESEND_WINDOW; i++)
+    {
+        if(heldSlots & (1 << i))
+        {
+            if(heldLine[i] == (actLineNumber & 0xffff)) return true; // already kept, resent by the host
+        }
+        else if(slot == RESEND_WINDOW)
+            slot = i;
+    }
+    if(slot == RESEND_WINDOW) return false;
+    heldLine[slot] = actLineNumber & 0xffff;
+    pack(heldCommand[slot]);
+    heldSlots |= 1 << slot;
+    if(!resendPending)
+        requestLineResend();
+    return true;
+}
+
+/** \brief Queues a kept line if it is the next one. Its ok was sent when it was kept. */
+bool GCode::releaseHeldCommand()
+{
+    for(uint8_t i = 0; i < RESEND_WINDOW; i++)
+    {
+        if((heldSlots & (1 << i)) == 0) continue;
+        if(static_cast<uint16_t>(lastLineNumber - heldLine[i]) < 0x8000)   // host has sent the line again
+        {
+            heldSlots &= ~(1 << i);
+            continue;
+        }
+        if(heldLine[i] == ((lastLineNumber+1) & 0xffff))
+        {
+            heldSlots &= ~(1 << i);
+            lastLineNumber++;
+            parsedCommand.unpack(heldCommand[i]);
+            pushCommand();
+#if FEATURE_SERIAL_ERRORS
+            commandsReceived++;
+#endif
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+/** \brief Sends the ok for the last received command. */
+void GCode::printOk()
+{
+#ifdef ACK_WITH_LINENUMBER
+    Com::printF(Com::tOkSpace,actLineNumber);
+#else
+    Com::printF(Com::tOk);
+#endif
+#if FEATURE_OK_BUFFER_SPACE
+    if(reportBufferSpace)
+        printBufferSpace();
+#endif
+    Com::println();
+}
 /**
   Check if result is plausible. If it is, an ok is send and the command is stored in queue.
   If not, a resend and ok is send.
@@ -156,6 +286,10 @@ void GCode::checkAndPushCommand()
             lastLineNumber = actLineNumber;
             Com::printFLN(Com::tOk);
             waitingForResend = -1;
+#if FEATURE_SELECTIVE_RESEND
+            heldSlots = 0;
+            resendPending = false;
+#endif
             return;
         }
         if(M==112)   // Emergency kill - freeze printer
@@ -180,6 +314,13 @@ void GCode::checkAndPushCommand()
                 Com::printFLN(Com::tSkip,actLineNumber);
                 Com::printFLN(Com::tOk);
             }
+#if FEATURE_SELECTIVE_RESEND
+            else if(waitingForResend<0 && holdCommand())
+            {
+                commandsReceivingWritePosition = 0;
+                printOk();
+            }
+#endif
             else
             if(waitingForResend<0)   // after a resend, we have to skip the garbage in buffers, no message for this
             {
@@ -200,19 +341,21 @@ void GCode::checkAndPushCommand()
             return;
         }
         lastLineNumber = actLineNumber;
+#if FEATURE_SELECTIVE_RESEND
+        resendPending = false;
+#endif
     }
     pushCommand();
-#ifdef ACK_WITH_LINENUMBER
-    Com::printFLN(Com::tOkSpace,actLineNumber);
-#else
-    Com::printFLN(Com::tOk);
+#if FEATURE_SERIAL_ERRORS
+    commandsReceived++;
 #endif
+    printOk();
     wasLastCommandReceivedAsBinary = sendAsBinary;
     waitingForResend = -1; // everything is ok.
 }
 void GCode::pushCommand()
 {
-    GCode *cmd = &commandsBuffered[bufferWriteIndex];
+    GCode *cmd = &parsedCommand;
     bool has_l = cmd->hasL();
 
     if (has_l)
@@ -274,11 +417,251 @@ void GCode::pushCommand()
     }
 
 #ifndef ECHO_ON_EXECUTE
-    commandsBuffered[bufferWriteIndex].echoCommand();
+    cmd->echoCommand();
 #endif
-    bufferWriteIndex = (bufferWriteIndex+1) % GCODE_BUFFER_SIZE;
+    if(GCODE_QUEUE_BYTES - bufferWriteIndex < GCODE_MAX_PACKED)   // no room at the end, continue at the start
+    {
+        if(bufferWriteIndex < GCODE_QUEUE_BYTES)
+            commandQueue[bufferWriteIndex] = 0;
+        bufferWriteIndex = 0;
+    }
+    bufferWriteIndex += cmd->pack(&commandQueue[bufferWriteIndex]);
     bufferLength++;
 }
+/** \brief Checks if the queue can take another command of maximum packed size.
+
+The free space must be contiguous, so the end of the ring is skipped if it is too small. */
+bool GCode::hasQueueSpace()
+{
+    if(bufferLength == 0) return true;
+    if(bufferLength >= GCODE_BUFFER_SIZE) return false;
+    if(bufferWriteIndex > bufferReadIndex)
+        return GCODE_QUEUE_BYTES - bufferWriteIndex >= GCODE_MAX_PACKED || bufferReadIndex >= GCODE_MAX_PACKED;
+    return bufferReadIndex - bufferWriteIndex >= GCODE_MAX_PACKED;
+}
+#if FEATURE_OK_BUFFER_SPACE
+bool GCode::reportBufferSpace = false;
+
+/** \brief Number of commands that fit into the queue for sure, assuming the largest packed size.
+
+A command never wraps, so the free space at the end and at the start of the ring count separately. */
+uint8_t GCode::freeQueueSlots()
+{
+    if(bufferLength >= GCODE_BUFFER_SIZE) return 0;
+    int slots;
+    if(bufferLength == 0)
+        slots = GCODE_QUEUE_BYTES / GCODE_MAX_PACKED;
+    else if(bufferWriteIndex > bufferReadIndex)
+        slots = (GCODE_QUEUE_BYTES - bufferWriteIndex) / GCODE_MAX_PACKED + bufferReadIndex / GCODE_MAX_PACKED;
+    else
+        slots = (bufferReadIndex - bufferWriteIndex) / GCODE_MAX_PACKED;
+    return RMath::min(slots,GCODE_BUFFER_SIZE - (int)bufferLength);
+}
+
+/** \brief Prints the free planner, command queue, receive buffer and laser power space without line end. */
+void GCode::printBufferSpace()
+{
+    Com::printF(Com::tP,(int)(MOVE_CACHE_SIZE - PrintLine::linesCount));
+    Com::printF(Com::tB,(int)freeQueueSlots());
+    Com::printF(Com::tR,HAL::serialRxFree());
+    Com::printF(Com::tL,(int)BoXZYLBuffer.free_elts());
+}
+#endif
+/** \brief Stores the parameters that are present. The first byte is the packed size. */
+uint8_t GCode::pack(uint8_t *p)
+{
+    uint8_t *start = p++;
+    *(uint16_t *)p = params;
+    p+=2;
+    *(uint16_t *)p = params2;
+    p+=2;
+    if(hasN())
+    {
+        *(uint16_t *)p = N;
+        p+=2;
+    }
+    if(hasM())
+    {
+        *(uint16_t *)p = M;
+        p+=2;
+    }
+    if(hasG())
+    {
+        *(uint16_t *)p = G;
+        p+=2;
+    }
+    if(hasX())
+    {
+        *(float *)p = X;
+        p+=4;
+    }
+    if(hasY())
+    {
+        *(float *)p = Y;
+        p+=4;
+    }
+    if(hasZ())
+    {
+        *(float *)p = Z;
+        p+=4;
+    }
+    if(hasE())
+    {
+        *(float *)p = E;
+        p+=4;
+    }
+    if(hasF())
+    {
+        *(float *)p = F;
+        p+=4;
+    }
+    if(hasT())
+    {
+        *p++ = T;
+    }
+    if(hasS())
+    {
+        *(int32_t *)p = S;
+        p+=4;
+    }
+    if(hasP())
+    {
+        *(int32_t *)p = P;
+        p+=4;
+    }
+    if(hasI())
+    {
+        *(float *)p = I;
+        p+=4;
+    }
+    if(hasJ())
+    {
+        *(float *)p = J;
+        p+=4;
+    }
+    if(hasR())
+    {
+        *(float *)p = R;
+        p+=4;
+    }
+#if FEATURE_CANNED_CYCLES
+    if(hasQ())
+    {
+        *(float *)p = Q;
+        p+=4;
+    }
+#endif
+    if(hasL())
+    {
+        *(uint32_t *)p = L_index;
+        p+=4;
+        *(uint32_t *)p = L_end_index;
+        p+=4;
+    }
+    if(params & (32768 | 16384))   // string or V3 frame stays in commandReceiving, see waitUntilAllCommandsAreParsed
+    {
+        *(char **)p = text;
+        p+=sizeof(char *);
+    }
+    *start = p-start;
+    return *start;
+}
+/** \brief Restores a command stored with pack. */
+void GCode::unpack(uint8_t *p)
+{
+    p++;
+    params = *(uint16_t *)p;
+    p+=2;
+    params2 = *(uint16_t *)p;
+    p+=2;
+    if(hasN())
+    {
+        N = *(uint16_t *)p;
+        p+=2;
+    }
+    if(hasM())
+    {
+        M = *(uint16_t *)p;
+        p+=2;
+    }
+    if(hasG())
+    {
+        G = *(uint16_t *)p;
+        p+=2;
+    }
+    if(hasX())
+    {
+        X = *(float *)p;
+        p+=4;
+    }
+    if(hasY())
+    {
+        Y = *(float *)p;
+        p+=4;
+    }
+    if(hasZ())
+    {
+        Z = *(float *)p;
+        p+=4;
+    }
+    if(hasE())
+    {
+        E = *(float *)p;
+        p+=4;
+    }
+    if(hasF())
+    {
+        F = *(float *)p;
+        p+=4;
+    }
+    if(hasT())
+    {
+        T = *p++;
+    }
+    if(hasS())
+    {
+        S = *(int32_t *)p;
+        p+=4;
+    }
+    if(hasP())
+    {
+        P = *(int32_t *)p;
+        p+=4;
+    }
+    if(hasI())
+    {
+        I = *(float *)p;
+        p+=4;
+    }
+    if(hasJ())
+    {
+        J = *(float *)p;
+        p+=4;
+    }
+    if(hasR())
+    {
+        R = *(float *)p;
+        p+=4;
+    }
+#if FEATURE_CANNED_CYCLES
+    if(hasQ())
+    {
+        Q = *(float *)p;
+        p+=4;
+    }
+#endif
+    if(hasL())
+    {
+        L_index = *(uint32_t *)p;
+        p+=4;
+        L_end_index = *(uint32_t *)p;
+        p+=4;
+    }
+    if(params & (32768 | 16384))
+    {
+        text = *(char **)p;
+    }
+}
 /**
   Get the next buffered command. Returns 0 if no more commands are buffered. For each
   returned command, the gcode_command_finished() function must be called.
@@ -286,7 +669,12 @@ void GCode::pushCommand()
 GCode *GCode::peekCurrentCommand()
 {
     if(bufferLength==0) return NULL; // No more data
-    return &commandsBuffered[bufferReadIndex];
+    if(!currentUnpacked)
+    {
+        currentCommand.unpack(&commandQueue[bufferReadIndex]);
+        currentUnpacked = true;
+    }
+    return &currentCommand;
 }
 /** \brief Removes the last returned command from cache. */
 void GCode::popCurrentCommand()
@@ -295,14 +683,22 @@ void GCode::popCurrentCommand()
 #ifdef ECHO_ON_EXECUTE
     echoCommand();
 #endif
-    if(++bufferReadIndex == GCODE_BUFFER_SIZE) bufferReadIndex = 0;
-    bufferLength--;
+    currentUnpacked = false;
+    if(--bufferLength == 0)
+        bufferReadIndex = bufferWriteIndex = 0;
+    else
+    {
+        bufferReadIndex += commandQueue[bufferReadIndex];
+        if(bufferReadIndex >= GCODE_QUEUE_BYTES || commandQueue[bufferReadIndex] == 0)
+            bufferReadIndex = 0;
+    }
 }
 
 void GCode::echoCommand()
 {
     if(Printer::debugEcho())
     {
+        Com::setDroppable();
         Com::printF(Com::tEcho);
         printCommand();
     }
@@ -361,6 +757,116 @@ void GCode::executeFString(FSTRINGPARAM(cmd))
     }
     while(c);
 }
+#if FEATURE_BINARY_V3
+int32_t GCode::batchPosition[4] = {0,0,0,0};
+
+/** \brief Reads an unsigned LEB128 varint and advances the pointer.
+@returns false if the varint does not end before end. */
+static bool readBatchVarint(uint8_t **p,uint8_t *end,uint32_t &v)
+{
+    v = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    do
+    {
+        if(*p >= end) return false;
+        b = *(*p)++;
+        v |= (uint32_t)(b & 127) << shift;
+        shift += 7;
+    }
+    while((b & 128) && shift < 35);
+    return true;
+}
+
+/** \brief Executes the moves of a V3 frame.
+
+The moves are absolute targets in the current coordinate system, so G90, M82 and G21 are in effect
+while the frame is executed. Laser powers are claimed the same way pushCommand does for ascii L values. */
+void GCode::executeBatch(GCode *com)
+{
+    uint8_t *p = (uint8_t *)com->text;
+    uint8_t *end = p + 1 + *p;
+    p++;
+    uint8_t relative = Printer::relativeCoordinateMode;
+    uint8_t relativeE = Printer::relativeExtruderCoordinateMode;
+    uint8_t inches = Printer::unitIsInches;
+    Printer::relativeCoordinateMode = Printer::relativeExtruderCoordinateMode = Printer::unitIsInches = 0;
+    GCode code;
+    int32_t target[4];
+    uint32_t value,feedrate = 0;
+    while(p < end)
+    {
+        // A move that does not end inside the frame is a host error, it and the rest are dropped.
+        uint8_t flags = *p++;
+        code.params = 4;
+        code.params2 = 0;
+        code.G = ((flags & 32) ? 1 : 0);
+        uint8_t axis;
+        for(axis = 0; axis < 4; axis++)
+        {
+            target[axis] = batchPosition[axis];
+            if((flags & (1 << axis)) == 0) continue;
+            if(!readBatchVarint(&p,end,value)) break;
+            int32_t v = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+            target[axis] = ((flags & 128) ? v : batchPosition[axis] + v);
+            code.params |= 8 << axis;
+        }
+        if(axis < 4 || ((flags & 16) && !readBatchVarint(&p,end,feedrate)) || ((flags & 64) && (p >= end || *p > end - p - 1)))
+        {
+            Com::printErrorFLN(Com::tFormatError);
+            break;
+        }
+        for(axis = 0; axis < 4; axis++)
+            batchPosition[axis] = target[axis];
+        if(code.hasX()) code.X = batchPosition[X_AXIS] * Printer::invAxisStepsPerMM[X_AXIS];
+        if(code.hasY()) code.Y = batchPosition[Y_AXIS] * Printer::invAxisStepsPerMM[Y_AXIS];
+        if(code.hasZ()) code.Z = batchPosition[Z_AXIS] * Printer::invAxisStepsPerMM[Z_AXIS];
+        if(code.hasE()) code.E = batchPosition[E_AXIS] * Printer::invAxisStepsPerMM[E_AXIS];
+        if(flags & 16)
+        {
+            code.F = feedrate;
+            code.params |= 256;
+        }
+        bool laser = (Printer::BoXZY_head == BoXZY_Laser_head);
+        if(flags & 64)   // laser powers 0..255
+        {
+            uint8_t n = *p++;
+            if(laser)
+            {
+                BoXZYLBuffer.write_index = BoXZYLBuffer.committed_index;
+                for(uint8_t i = 0; i < n; i++)
+                {
+                    while (BoXZYLBuffer.is_full())
+                    {
+                        // Wait for IRQs to make some room
+                    }
+                    BoXZYLBuffer.append_power(p[i]);
+                }
+                BoXZYLBuffer.committed_index = BoXZYLBuffer.write_index;
+                if (Printer::is_L_in_focus_mode)
+                {
+                    Printer::is_L_in_focus_mode = false;
+                    set_laser(0);
+                }
+            }
+            p += n;
+        }
+        if(laser && BoXZYLBuffer.unclaimed_index != BoXZYLBuffer.committed_index && (code.G == 1 || (flags & 64)))
+        {
+            code.params2 |= 8192; // Set hasL()
+            code.L_index = BoXZYLBuffer.unclaimed_index;
+            code.L_end_index = BoXZYLBuffer.committed_index;
+            BoXZYLBuffer.unclaimed_index = BoXZYLBuffer.committed_index;
+        }
+        Commands::executeGCode(&code);
+        Printer::defaultLoopActions();
+    }
+    Printer::relativeCoordinateMode = relative;
+    Printer::relativeExtruderCoordinateMode = relativeE;
+    Printer::unitIsInches = inches;
+}
+#endif
+
 /** \brief Read from serial console or sdcard.
 
 This function is the main function to read the commands from serial console or from sdcard.
@@ -368,9 +874,12 @@ It must be called frequently to empty the incoming buffer.
 */
 void GCode::readFromSerial()
 {
-    if(bufferLength>=GCODE_BUFFER_SIZE) return; // all buffers full
+    if(!hasQueueSpace()) return; // all buffers full
     if(waitUntilAllCommandsAreParsed && bufferLength) return;
     waitUntilAllCommandsAreParsed=false;
+#if FEATURE_SELECTIVE_RESEND
+    if(heldSlots && releaseHeldCommand()) return;
+#endif
     millis_t time = HAL::timeInMilliseconds();
     if(!HAL::serialByteAvailable())
     {
@@ -379,6 +888,13 @@ void GCode::readFromSerial()
             requestResend(); // Something is wrong, a started line was not continued in the last second
             timeOfLastDataPacket = time;
         }
+#if FEATURE_SELECTIVE_RESEND
+        else if(resendPending && time-timeOfLastDataPacket>200)   // missing line did not arrive, ask again
+        {
+            requestLineResend();
+            timeOfLastDataPacket = time;
+        }
+#endif
 #ifdef WAITING_IDENTIFIER
         else if(bufferLength == 0 && time-timeOfLastDataPacket>1000)   // Don't do it if buffer is not empty. It may be a slow executing command.
         {
@@ -415,9 +931,14 @@ void GCode::readFromSerial()
             if(commandsReceivingWritePosition < 2 ) continue;
             if(commandsReceivingWritePosition == 5 || commandsReceivingWritePosition == 4)
                 binaryCommandSize = computeBinarySize((char*)commandReceiving);
+            if(binaryCommandSize == 0 && commandsReceivingWritePosition == 5)   // V3 frame longer than the buffer
+            {
+                requestResend();
+                return;
+            }
             if(commandsReceivingWritePosition == binaryCommandSize)
             {
-                GCode *act = &commandsBuffered[bufferWriteIndex];
+                GCode *act = &parsedCommand;
                 if(act->parseBinary(commandReceiving,true))   // Success
                     act->checkAndPushCommand();
                 else
@@ -434,15 +955,23 @@ void GCode::readFromSerial()
                 //Com::printF(PSTR("Parse ascii"));Com::print((char*)commandReceiving);Com::println();
                 commandReceiving[commandsReceivingWritePosition-1]=0;
                 commentDetected = false;
+#if FEATURE_REALTIME_COMMANDS
+                HAL::serialAsciiLineDone();
+#endif
                 if(commandsReceivingWritePosition==1)   // empty line ignore
                 {
                     commandsReceivingWritePosition = 0;
                     continue;
                 }
-                GCode *act = &commandsBuffered[bufferWriteIndex];
+                GCode *act = &parsedCommand;
                 if(act->parseAscii((char *)commandReceiving,true))   // Success
                     act->checkAndPushCommand();
                 else
+#if FEATURE_SELECTIVE_RESEND
+                if(waitingForResend<0)
+                    requestLineResend();
+                else
+#endif
                     requestResend();
                 commandsReceivingWritePosition = 0;
                 return;
@@ -497,7 +1026,7 @@ void GCode::readFromSerial()
                 binaryCommandSize = computeBinarySize((char*)commandReceiving);
             if(commandsReceivingWritePosition==binaryCommandSize)
             {
-                GCode *act = &commandsBuffered[bufferWriteIndex];
+                GCode *act = &parsedCommand;
                 if(act->parseBinary(commandReceiving,false))   // Success, silently ignore illegal commands
                     pushCommand();
                 commandsReceivingWritePosition = 0;
@@ -520,7 +1049,7 @@ void GCode::readFromSerial()
                     commandsReceivingWritePosition = 0;
                     continue;
                 }
-                GCode *act = &commandsBuffered[bufferWriteIndex];
+                GCode *act = &parsedCommand;
                 if(act->parseAscii((char *)commandReceiving,false))   // Success
                     pushCommand();
                 commandsReceivingWritePosition = 0;
@@ -576,12 +1105,25 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
         return false;
     }
     p = buffer;
-    params = *(unsigned int *)p;
+    params = *(uint16_t *)p;
     p+=2;
+#if FEATURE_BINARY_V3
+    if(params & 16384)   // V3 frame, the moves are decoded by executeBatch
+    {
+        params &= 16384 | 1;
+        params2 = 0;
+        if(params & 1)
+            actLineNumber = N = *(uint16_t *)p;
+        text = (char *)p + 2;
+        waitUntilAllCommandsAreParsed = true; // moves are read from the receive buffer
+        formatErrors = 0;
+        return true;
+    }
+#endif
     uint8_t textlen=16;
     if(isV2())
     {
-        params2 = *(unsigned int *)p;
+        params2 = *(uint16_t *)p;
         p+=2;
         if(hasString())
             textlen = *p++;
@@ -671,7 +1213,18 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
         R=*(float *)p;
         p+=4;
     }
-    // TODO: L binary parsing, if/when there's a PC program that can send it.
+    if(params2 & 8)
+    {
+#if FEATURE_CANNED_CYCLES
+        Q=*(float *)p;
+#endif
+        p+=4;
+    }
+    if(params2 & 8192)   // L indices have no meaning for the host, laser powers are sent with V3
+    {
+        params2 &= ~8192;
+        p+=8;
+    }
     if(hasString())   // set text pointer to string
     {
         text = (char*)p;
@@ -682,115 +1235,265 @@ bool GCode::parseBinary(uint8_t *buffer,bool fromSerial)
     return true;
 }
 
+/** Divisors for the decimals counted by parseDecimal. */
+static const float decimalDivisor[7] = {1.0f,10.0f,100.0f,1000.0f,10000.0f,100000.0f,1000000.0f};
+
+/** \brief Reads an optionally signed decimal number into an integer and its number of decimals.
+
+At most 9 digits and 6 decimals are kept, the first dropped decimal rounds the last kept one.
+Returns the position behind the number or s if it contains no digit or is too large. */
+char *GCode::parseDecimal(char *s,int32_t *value,uint8_t *decimals)
+{
+    char *p = s;
+    while(*p == ' ') p++;
+    bool negative = (*p == '-');
+    if(*p == '-' || *p == '+') p++;
+    uint32_t v = 0;
+    uint8_t d = 0;
+    bool point = false, digits = false, dropped = false;
+    for(;; p++)
+    {
+        uint8_t c = *p - '0';
+        if(c <= 9)
+        {
+            digits = true;
+            if(dropped) continue;
+            if(point && (d == 6 || v >= 100000000UL))   // precision reached
+            {
+                if(c >= 5) v++;
+                dropped = true;
+            }
+            else if(v >= 100000000UL) return s; // more than 9 integer digits
+            else
+            {
+                v = v * 10 + c;
+                if(point) d++;
+            }
+        }
+        else if(*p == '.' && !point) point = true;
+        else break;
+    }
+    if(!digits) return s;
+    *value = (negative ? -(int32_t)v : (int32_t)v);
+    *decimals = d;
+    return p;
+}
+
+/** \brief Converts a decimal number with one float division. */
+float GCode::parseFloatValue(char **s)
+{
+    int32_t v;
+    uint8_t d;
+    char *endPtr = parseDecimal(*s,&v,&d);
+    if(endPtr == *s)
+    {
+        setFormatError();
+        return 0;
+    }
+    *s = endPtr;
+    return (d ? (float)v / decimalDivisor[d] : (float)v);
+}
+
+long GCode::parseLongValue(char **s)
+{
+    char *p = *s;
+    while(*p == ' ') p++;
+    bool negative = (*p == '-');
+    if(*p == '-' || *p == '+') p++;
+    if(*p < '0' || *p > '9')
+    {
+        setFormatError();
+        return 0;
+    }
+    long l = 0;
+    while(*p >= '0' && *p <= '9')
+        l = l * 10 + (*p++ - '0');
+    *s = p;
+    return (negative ? -l : l);
+}
+
+/** \brief Converts a laser power in percent to 0..255 without float math.
+
+The percentage is truncated to two decimals, power = pct * 2.55 truncated as in laser_pct_to_power. */
+uint8_t GCode::parseLaserPower(char **s)
+{
+    int32_t v;
+    uint8_t d;
+    char *endPtr = parseDecimal(*s,&v,&d);
+    if(endPtr == *s)
+    {
+        setFormatError();
+        return 0;
+    }
+    *s = endPtr;
+    for(; d > 2; d--) v /= 10;
+    for(; d < 2; d++)
+    {
+        if(v >= 10000) return 255;
+        v *= 10;
+    }
+    if(v <= 0) return 0;
+    if(v >= 10000) return 255;
+    return v * 51 / 2000; // pct*100 * 255/10000
+}
+
 /**
   Converts a ascii GCode line into a GCode structure.
+
+  The line is scanned once from left to right. Each parameter letter converts its value and
+  continues behind it, characters in parentheses are comments and everything in front of
+  the * is folded into the checksum on the way.
 */
 bool GCode::parseAscii(char *line,bool fromSerial)
 {
     bool has_checksum = false;
-    char *pos;
+    uint8_t checksum = 0;
+    uint8_t checksum_given = 0;
+    char *pos = line;
+    char *checked = line; // characters in front of checked are part of checksum
+    char *textEnd = NULL; // strings are terminated after the checksum is known
     params = 0;
     params2 = 0;
 
     BoXZYLBuffer.write_index = BoXZYLBuffer.committed_index;
 
-    if((pos = strchr(line,'N'))!=0)   // Line number detected
-    {
-        actLineNumber = parseLongValue(++pos);
-        params |=1;
-        N = actLineNumber & 0xffff;
-    }
-    if((pos = strchr(line,'M'))!=0)   // M command
-    {
-        M = parseLongValue(++pos) & 0xffff;
-        params |= 2;
-        if(M>255) params |= 4096;
-    }
-    if(hasM() && (M == 23 || M == 28 || M == 29 || M == 30 || M == 32 || M == 117))
+    while(true)
     {
-        // after M command we got a filename for sd card management
-        char *sp = line;
-        while(*sp!='M') sp++; // Search M command
-        while(*sp!=' ') sp++; // search next whitespace
-        while(*sp==' ') sp++; // skip leading whitespaces
-        text = sp;
-        while(*sp)
+        while(checked < pos) checksum ^= *checked++;
+        char c = *pos;
+        if(c == 0 || c == ';') break;
+        if(c == '*')   // checksum
         {
-            if((M != 117 && *sp==' ') || *sp=='*') break; // end of filename reached
-            sp++;
+            checksum_given = parseLongValue(pos+1);
+            has_checksum = true;
+            break;
         }
-        *sp = 0; // Removes checksum, but we don't care. Could also be part of the string.
-        waitUntilAllCommandsAreParsed = true; // don't risk string be deleted
-        params |= 32768;
-    }
-    else
-    {
-        if((pos = strchr(line,'G'))!=0)   // G command
+        pos++;
+        switch(c)
         {
-            G = parseLongValue(++pos) & 0xffff;
+        case '(':   // comment, may be nested
+        {
+            uint8_t level = 1;
+            while(*pos && level)
+            {
+                if(*pos == '(') level++;
+                else if(*pos == ')') level--;
+                pos++;
+            }
+            break;
+        }
+        case 'N':   // Line number detected
+            actLineNumber = parseLongValue(&pos);
+            params |=1;
+            N = actLineNumber & 0xffff;
+            break;
+        case 'M':
+            M = parseLongValue(&pos) & 0xffff;
+            params |= 2;
+            if(M>255) params |= 4096;
+            if(M == 23 || M == 28 || M == 29 || M == 30 || M == 32 || M == 117)
+            {
+                // after M command we got a filename for sd card management
+                while(*pos==' ') pos++; // skip leading whitespaces
+                text = pos;
+                while(*pos && *pos!='*' && (M == 117 || *pos!=' ')) pos++; // end of filename reached
+                textEnd = pos;
+                while(*pos && *pos!='*') pos++; // nothing else is parsed
+                waitUntilAllCommandsAreParsed = true; // don't risk string be deleted
+                params |= 32768;
+            }
+            break;
+        case 'G':
+            G = parseLongValue(&pos) & 0xffff;
             params |= 4;
             if(G>255) params |= 4096;
-        }
-        if((pos = strchr(line,'X'))!=0)
-        {
-            X = parseFloatValue(++pos);
+            break;
+        case 'X':
+            X = parseFloatValue(&pos);
             params |= 8;
-        }
-        if((pos = strchr(line,'Y'))!=0)
-        {
-            Y = parseFloatValue(++pos);
+            break;
+        case 'Y':
+            Y = parseFloatValue(&pos);
             params |= 16;
-        }
-        if((pos = strchr(line,'Z'))!=0)
-        {
-            Z = parseFloatValue(++pos);
+            break;
+        case 'Z':
+            Z = parseFloatValue(&pos);
             params |= 32;
-        }
-        if((pos = strchr(line,'E'))!=0)
-        {
-            E = parseFloatValue(++pos);
+            break;
+        case 'E':
+            E = parseFloatValue(&pos);
             params |= 64;
-        }
-        if((pos = strchr(line,'F'))!=0)
-        {
-            F = parseFloatValue(++pos);
+            break;
+        case 'F':
+            F = parseFloatValue(&pos);
             params |= 256;
-        }
-        if((pos = strchr(line,'T'))!=0)   // M command
-        {
-            T = parseLongValue(++pos) & 0xff;
+            break;
+        case 'T':
+            T = parseLongValue(&pos) & 0xff;
             params |= 512;
-        }
-        if((pos = strchr(line,'S'))!=0)   // M command
-        {
-            S = parseLongValue(++pos);
+            break;
+        case 'S':
+            S = parseLongValue(&pos);
             params |= 1024;
-        }
-        if((pos = strchr(line,'P'))!=0)   // M command
-        {
-            P = parseLongValue(++pos);
+            break;
+        case 'P':
+#if FEATURE_SUBPROGRAMS
+            if(hasM() && M >= 96 && M <= 98)
+            {
+                // P<name> selects a subprogram, names may contain parameter letters
+                text = pos;
+                while(*pos && *pos!=' ' && *pos!='*') pos++;
+                textEnd = pos;
+                if(M == 98 && strchr(pos,'L')==0)   // M98PSTRTTIME.SUBL1 has the repeat count appended to the name
+                {
+                    char *lp = pos;
+                    while(lp>text+1 && lp[-1]>='0' && lp[-1]<='9') lp--;
+                    if(lp<pos && lp>text+1 && lp[-1]=='L')
+                    {
+                        S = parseLongValue(lp);
+                        params |= 1024;
+                        textEnd = lp-1;
+                    }
+                }
+                waitUntilAllCommandsAreParsed = true; // don't risk string be deleted
+                params |= 32768;
+                break;
+            }
+#endif
+            P = parseLongValue(&pos);
             params |= 2048;
-        }
-        if((pos = strchr(line,'I'))!=0)
-        {
-            I = parseFloatValue(++pos);
+            break;
+        case 'I':
+            I = parseFloatValue(&pos);
             params2 |= 1;
             params |= 4096; // Needs V2 for saving
-        }
-        if((pos = strchr(line,'J'))!=0)
-        {
-            J = parseFloatValue(++pos);
+            break;
+        case 'J':
+            J = parseFloatValue(&pos);
             params2 |= 2;
             params |= 4096; // Needs V2 for saving
-        }
-        if((pos = strchr(line,'R'))!=0)
-        {
-            R = parseFloatValue(++pos);
+            break;
+        case 'R':
+            R = parseFloatValue(&pos);
             params2 |= 4;
             params |= 4096; // Needs V2 for saving
-        }
-        if((pos = strchr(line,'L'))!=0)
-        {
+            break;
+#if FEATURE_CANNED_CYCLES
+        case 'Q':
+            Q = parseFloatValue(&pos);
+            params2 |= 8;
+            params |= 4096; // Needs V2 for saving
+            break;
+#endif
+        case 'L':
+#if FEATURE_SUBPROGRAMS
+            if(hasM() && M == 98)   // repeat count of a subprogram call
+            {
+                S = parseLongValue(&pos);
+                params |= 1024;
+                break;
+            }
+#endif
             if (Printer::BoXZY_head == BoXZY_Laser_head)
             {
                 // Setting this also tells executeGCode() to ignore it unless it's a G
@@ -798,41 +1501,33 @@ bool GCode::parseAscii(char *line,bool fromSerial)
                 params2 |= 8192; // Set hasL()
                 params |= 4096; // Needs V2 for saving (TODO: implement saving scanline)
 
-                do {
-                    ++pos;
-
-                    while (BoXZYLBuffer.is_full())
-                    {
-                        // Wait for IRQs to make some room
-                    }
-
-                    float pct = parseFloatValue(&pos);
-                    long count = 1;
+                while (BoXZYLBuffer.is_full())
+                {
+                    // Wait for IRQs to make some room
+                }
 
-                    if (*pos == '^')
-                    {
-                        ++pos;
-                        count = parseLongValue(&pos);
-                    }
+                uint8_t power = parseLaserPower(&pos);
+                long count = 1;
 
-                    while (count > 0)
-                    {
-                        BoXZYLBuffer.append_pct(pct);
-                        --count;
-                    }
-
-                    if (!hasFormatError())
-                        pos = strchr(pos,'L');
+                if (*pos == '^')
+                {
+                    ++pos;
+                    count = parseLongValue(&pos);
+                }
 
-                } while (!hasFormatError() && (pos != 0));
+                while (count > 0)
+                {
+                    BoXZYLBuffer.append_power(power);
+                    --count;
+                }
             }
+            break;
         }
     }
-    if((pos = strchr(line,'*'))!=0)   // checksum
+    if(textEnd)
+        *textEnd = 0; // Removes checksum, but it is already computed.
+    if(has_checksum)
     {
-        uint8_t checksum_given = parseLongValue(pos+1);
-        uint8_t checksum = 0;
-        while(line!=pos) checksum ^= *line++;
 #if FEATURE_CHECKSUM_FORCED
         Printer::flag0 |= PRINTER_FLAG0_FORCE_CHECKSUM;
 #endif
@@ -857,7 +1552,14 @@ bool GCode::parseAscii(char *line,bool fromSerial)
         return false;
     }
 #endif
+#if FEATURE_CANNED_CYCLES
+    // Commands are parsed before the ones in the queue are executed, so the cycle state is tracked here
+    if(hasG() && G >= 80 && G <= 83)
+        cannedCycleParsed = (G != 80);
+    if(hasFormatError() || (((params & (cannedCycleParsed ? 542 : 518))==0) && !hasL()))   // Must contain G, M, L or T, X or Y only while a canned cycle is active, and parameter need to have variables!
+#else
     if(hasFormatError() || (((params & 518)==0) && !hasL()))   // Must contain G, M, L or T command and parameter need to have variables!
+#endif
     {
         formatErrors++;
         if(Printer::debugErrors())
@@ -929,6 +1631,12 @@ void GCode::printCommand()
     {
         Com::printF(Com::tR,R);
     }
+#if FEATURE_CANNED_CYCLES
+    if(hasQ())
+    {
+        Com::printF(Com::tQ,Q);
+    }
+#endif
     if(hasL())
     {
         uint16_t i = L_index;
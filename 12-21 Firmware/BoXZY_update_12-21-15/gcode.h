@@ -41,6 +41,9 @@ public:
     float I;
     float J;
     float R;
+#if FEATURE_CANNED_CYCLES
+    float Q;
+#endif
     uint32_t L_index; // Next BoXZYLBuffer index to use
     uint32_t L_end_index; // BoXZYLBuffer index after last index to use
     char *text; //text[17];
@@ -113,6 +116,19 @@ public:
     {
         return ((params2 & 4)!=0);
     }
+#if FEATURE_CANNED_CYCLES
+    inline bool hasQ()
+    {
+        return ((params2 & 8)!=0);
+    }
+#endif
+#if FEATURE_BINARY_V3
+    /** V3 frame, text points to the payload length followed by the moves. */
+    inline bool isBatch()
+    {
+        return ((params & 16384)!=0);
+    }
+#endif
     inline bool hasL()
     {
         // Using 8192 to try to avoid collisions with whatever
@@ -145,49 +161,60 @@ public:
     static void readFromSerial();
     static void pushCommand();
     static void executeFString(FSTRINGPARAM(cmd));
+    static inline uint8_t queuedCommands() {return bufferLength;}
+#if FEATURE_SERIAL_ERRORS
+    static uint32_t commandsReceived; ///< Commands received over serial and queued since the last M408 S1
+    static uint16_t resendRequests; ///< Resends requested since the last M408 S1
+#endif
+#if FEATURE_OK_BUFFER_SPACE
+    static uint8_t freeQueueSlots();
+    static void printBufferSpace();
+    static bool reportBufferSpace; ///< Append free buffer space to ok, set with M407
+#endif
+#if FEATURE_BINARY_V3
+    static void executeBatch(GCode *com);
+#endif
     static uint8_t computeBinarySize(char *ptr);
 
     friend class SDCard;
     friend class UIDisplay;
+#if FEATURE_SUBPROGRAMS
+    friend class Subprograms;
+#endif
 private:
     void debugCommandBuffer();
     void checkAndPushCommand();
     static void requestResend();
+    static void printOk();
+#if FEATURE_SELECTIVE_RESEND
+    static void requestLineResend();
+    bool holdCommand();
+    static bool releaseHeldCommand();
+#endif
+    static char *parseDecimal(char *s,int32_t *value,uint8_t *decimals);
+    float parseFloatValue(char **s);
+    long parseLongValue(char **s);
+    uint8_t parseLaserPower(char **s);
     inline float parseFloatValue(char *s)
     {
-        char *endPtr;
-        float f = (strtod(s, &endPtr));
-        if(s == endPtr) setFormatError();
-        return f;
-    }
-    inline float parseFloatValue(char **s)
-    {
-        char *endPtr;
-        float f = (strtod(*s, &endPtr));
-        if(*s == endPtr) setFormatError();
-        *s = endPtr;
-        return f;
+        return parseFloatValue(&s);
     }
     inline long parseLongValue(char *s)
     {
-        char *endPtr;
-        long l = (strtol(s, &endPtr, 10));
-        if(s == endPtr) setFormatError();
-        return l;
-    }
-    inline long parseLongValue(char **s)
-    {
-        char *endPtr;
-        long l = (strtol(*s, &endPtr, 10));
-        if(*s == endPtr) setFormatError();
-        *s = endPtr;
-        return l;
+        return parseLongValue(&s);
     }
 
 
-    static GCode commandsBuffered[GCODE_BUFFER_SIZE]; ///< Buffer for received commands.
-    static uint8_t bufferReadIndex; ///< Read position in gcode_buffer.
-    static uint8_t bufferWriteIndex; ///< Write position in gcode_buffer.
+    uint8_t pack(uint8_t *p);
+    void unpack(uint8_t *p);
+    static bool hasQueueSpace();
+
+    static uint8_t commandQueue[GCODE_QUEUE_BYTES]; ///< Ring of packed commands, each starting with its size. Size 0 marks a wrap.
+    static GCode parsedCommand; ///< Command being parsed before it is packed into the queue.
+    static GCode currentCommand; ///< Unpacked first command of the queue.
+    static bool currentUnpacked; ///< currentCommand holds the command at bufferReadIndex.
+    static uint8_t bufferReadIndex; ///< Read position in commandQueue.
+    static uint8_t bufferWriteIndex; ///< Write position in commandQueue.
     static uint8_t commandReceiving[MAX_CMD_SIZE]; ///< Current received command.
     static uint8_t commandsReceivingWritePosition; ///< Writing position in gcode_transbuffer.
     static uint8_t sendAsBinary; ///< Flags the command as binary input.
@@ -201,6 +228,12 @@ private:
     static volatile uint8_t bufferLength; ///< Number of commands stored in gcode_buffer
     static millis_t timeOfLastDataPacket; ///< Time, when we got the last data packet. Used to detect missing uint8_ts.
     static uint8_t formatErrors; ///< Number of sequential format errors
+#if FEATURE_CANNED_CYCLES
+    static bool cannedCycleParsed; ///< A G81-G83 was parsed and not cancelled by G80, so X/Y only lines are valid
+#endif
+#if FEATURE_BINARY_V3
+    static int32_t batchPosition[4]; ///< Last V3 target in steps, base of the deltas
+#endif
 };
 
 
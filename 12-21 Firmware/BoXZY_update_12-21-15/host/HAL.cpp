@@ -0,0 +1,577 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Host implementation of the HAL. A timer thread runs the stepper interrupt
+  PrintLine::bresenhamStep() in real time and sets executePeriodical like the PWM
+  interrupt. For the checks the serial port is memory: hostReceive() runs the receive
+  interrupt code for a byte and everything the firmware sends is collected for
+  hostOutput(). boxzy-sim sets HostConfig::port, then a UART thread moves the bytes
+  between a pseudo terminal and the serial rings at the baud rate.
+*/
+
+#include "Repetier.h"
+#include "host.h"
+#include "pty.h"
+
+#include <atomic>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdio.h>
+
+using namespace std::chrono;
+typedef steady_clock hostClock;
+
+bool HostConfig::port = false;
+const char *HostConfig::link = NULL;
+long HostConfig::baud = 0;
+float HostConfig::noiseFlip = 0;
+float HostConfig::noiseFrame = 0;
+float HostConfig::noiseDrop = 0;
+uint32_t HostConfig::seed = 1;
+float HostConfig::speed = 1;
+bool HostConfig::overrun = false;
+
+uint8_t HAL::eeprom[4096];
+uint8_t hostPinLevel[256];
+uint32_t hostPinRises[256];
+
+static const hostClock::time_point startTime = hostClock::now();
+
+// The interrupt thread takes isrLock for a complete interrupt call. The main thread takes it
+// between forbidInterrupts() and allowInterrupts(). Pending interrupts go first like on the
+// AVR, where they run as soon as the I flag is set again.
+static std::mutex isrLock;
+static std::atomic<int> isrPending(0);
+static bool mainForbids = false;
+static __thread bool insideInterrupt = false;
+
+static void enterInterrupt()
+{
+    isrPending++;
+    isrLock.lock();
+    isrPending--;
+    insideInterrupt = true;
+}
+
+static void leaveInterrupt()
+{
+    insideInterrupt = false;
+    isrLock.unlock();
+}
+
+static HostStepperStats stepperStats;
+
+static inline uint64_t cycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return duration_cast<nanoseconds>(hostClock::now().time_since_epoch()).count();
+#endif
+}
+
+HostStepperStats hostStepperStats()
+{
+    HostStepperStats stats;
+    BEGIN_INTERRUPT_PROTECTED
+    stats = stepperStats;
+    memset(&stepperStats,0,sizeof(stepperStats));
+    END_INTERRUPT_PROTECTED
+    return stats;
+}
+
+HAL::HAL()
+{
+    //ctor
+}
+
+HAL::~HAL()
+{
+    //dtor
+}
+
+uint16_t HAL::integerSqrt(int32_t a)
+{
+    return (uint16_t)(sqrt((double)a) + 0.5);
+}
+
+int32_t HAL::CPUDivU2(unsigned int divisor)
+{
+    if(insideInterrupt) stepperStats.intervalLookups++;
+    if(divisor < 10) divisor = 10;
+    return F_CPU / divisor;
+}
+
+void HAL::delayMicroseconds(unsigned int delayUs)
+{
+    // Sleeping is far too coarse for step pulses, so short delays spin.
+    hostClock::time_point end = hostClock::now() + microseconds(delayUs);
+    if(delayUs >= 1000)
+        std::this_thread::sleep_until(end);
+    else
+        while(hostClock::now() < end) {}
+}
+
+void HAL::delayMilliseconds(unsigned int delayMs)
+{
+    std::this_thread::sleep_for(milliseconds(delayMs));
+}
+
+void HAL::allowInterrupts()
+{
+    if(insideInterrupt || !mainForbids) return;
+    mainForbids = false;
+    isrLock.unlock();
+}
+
+void HAL::forbidInterrupts()
+{
+    if(insideInterrupt || mainForbids) return;
+    while(isrPending) std::this_thread::yield();
+    isrLock.lock();
+    mainForbids = true;
+}
+
+bool HAL::interruptsAllowed()
+{
+    return !insideInterrupt && !mainForbids;
+}
+
+unsigned long HAL::timeInMilliseconds()
+{
+    return duration_cast<milliseconds>(hostClock::now() - startTime).count();
+}
+
+void HAL::showStartReason()
+{
+    Com::printInfoFLN(Com::tPowerUp);
+}
+
+int HAL::getFreeRam()
+{
+    return MAX_RAM; // the host has no stack limit worth reporting
+}
+
+void HAL::resetHardware()
+{
+    fprintf(stderr, "firmware reset requested, exiting\n");
+    exit(0);
+}
+
+void analogWrite(uint8_t pin,int value) {}
+
+// Serial port ----------------------------------------------------------------
+
+ring_buffer rx_buffer = { { 0 }, 0, 0};
+ring_buffer_tx tx_buffer = { { 0 }, 0, 0};
+#if FEATURE_REALTIME_COMMANDS
+volatile uint8_t rxLineState = RX_BETWEEN_LINES;
+#endif
+#if FEATURE_SERIAL_ERRORS
+serial_errors serialErrors = {0, 0, 0};
+#endif
+static std::mutex outputLock;
+static std::string output;
+static bool ptyOpened = false;
+static std::atomic<long> uartBaud(BAUDRATE);
+
+/** \brief Body of the firmware receive interrupt, called with isrLock held.
+@returns false if the receive buffer was full. */
+static bool receiveInterrupt(unsigned char c,bool frameError,bool overrun)
+{
+#if FEATURE_SERIAL_ERRORS
+    if(overrun && serialErrors.overrun != 65535) serialErrors.overrun++;
+    if(frameError && serialErrors.frame != 65535) serialErrors.frame++;
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    if(rxLineState == RX_BETWEEN_LINES)
+    {
+        if(Printer::isRealtimeCommand(c))
+        {
+            Printer::handleRealtimeCommand(c);
+            return true;
+        }
+        if(c & 128)
+            rxLineState = RX_BINARY;
+        else if(c != '\n' && c != '\r' && c != 0)
+            rxLineState = RX_IN_LINE;
+    }
+    else if(rxLineState == RX_IN_LINE && (c == '\n' || c == '\r' || c == 0))
+        rxLineState = RX_BETWEEN_LINES;
+#endif
+    uint8_t i = (rx_buffer.head + 1) & SERIAL_BUFFER_MASK;
+    if (i != rx_buffer.tail)
+    {
+        rx_buffer.buffer[rx_buffer.head] = c;
+        std::atomic_thread_fence(std::memory_order_release);
+        rx_buffer.head = i;
+        return true;
+    }
+#if FEATURE_SERIAL_ERRORS
+    if(serialErrors.dropped != 65535)
+        serialErrors.dropped++;
+#endif
+    return false;
+}
+
+bool hostReceive(uint8_t c)
+{
+    enterInterrupt();
+    bool stored = receiveInterrupt(c,false,false);
+    leaveInterrupt();
+    return stored;
+}
+
+std::string hostOutput()
+{
+    std::lock_guard<std::mutex> lock(outputLock);
+    std::string text;
+    text.swap(output);
+    return text;
+}
+
+/** \brief Small xorshift generator, the noise is the same for the same seed. */
+static float noiseRandom()
+{
+    static uint32_t x = 0;
+    if(x == 0) x = HostConfig::seed ? HostConfig::seed : 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return (x & 0xffffff) / 16777216.0f;
+}
+
+// Hardware receive buffer of the UART, filled by the UART thread.
+static uint8_t uartFifo[2];
+static bool uartFifoFrame[2];
+static uint8_t uartFifoLength = 0;
+static bool uartOverrun = false;
+
+/** \brief Runs the receive interrupt for the bytes in the hardware buffer. Without wait
+nothing happens while the main thread has the interrupts forbidden or an other interrupt runs. */
+static void uartDeliver(bool wait)
+{
+    if(!uartFifoLength) return;
+    if(wait)
+        isrLock.lock();
+    else if(!isrLock.try_lock())
+        return;
+    insideInterrupt = true;
+    for(uint8_t i = 0; i < uartFifoLength; i++)
+    {
+        receiveInterrupt(uartFifo[i],uartFifoFrame[i],uartOverrun);
+        uartOverrun = false;
+    }
+    leaveInterrupt();
+    uartFifoLength = 0;
+    isrPending--;
+}
+
+/** \brief Moves one byte per byte time in each direction between the pseudo terminal and the
+serial rings. Received bytes wait in a two byte hardware buffer while the main thread has the
+interrupts forbidden, with HostConfig::overrun a third byte is an overrun. */
+static void uartThread()
+{
+    uint8_t in[256],out[256];
+    int inLength = 0,inPos = 0,outLength = 0;
+    hostClock::time_point t = hostClock::now();
+    while(true)
+    {
+        nanoseconds byteTime(10000000000LL / uartBaud);
+        bool txPending = tx_buffer.head != tx_buffer.tail;
+        if(inPos == inLength)
+        {
+            if(outLength)
+            {
+                ptyWrite(out,outLength);
+                outLength = 0;
+            }
+            inPos = 0;
+            inLength = ptyRead(in,sizeof(in),(txPending || uartFifoLength) ? 0 : 1);
+        }
+        bool busy = false;
+        if(inPos < inLength)
+        {
+            unsigned char c = in[inPos++];
+            busy = true;
+            bool frame = false;
+            // A dropped byte lost its start bit and never reaches the UART.
+            if(HostConfig::noiseDrop <= 0 || noiseRandom() >= HostConfig::noiseDrop)
+            {
+                if(HostConfig::noiseFlip > 0 && noiseRandom() < HostConfig::noiseFlip)
+                    c ^= 1 << (int)(noiseRandom() * 8);
+                if(HostConfig::noiseFrame > 0 && noiseRandom() < HostConfig::noiseFrame)
+                {
+                    c = (unsigned char)(noiseRandom() * 256);
+                    frame = true;
+                }
+                // The scheduler of the pc stops threads for milliseconds, far longer than two
+                // byte times. Unless asked for, the UART waits for the interrupt instead of
+                // reporting overruns the firmware is not responsible for.
+                uartDeliver(uartFifoLength == 2 && !HostConfig::overrun);
+                if(uartFifoLength == 2)
+                    uartOverrun = true;
+                else
+                {
+                    if(uartFifoLength == 0) isrPending++; // the receive interrupt is pending now
+                    uartFifo[uartFifoLength] = c;
+                    uartFifoFrame[uartFifoLength++] = frame;
+                }
+            }
+        }
+        uartDeliver(false);
+        if(txPending)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            out[outLength++] = tx_buffer.buffer[tx_buffer.tail];
+            tx_buffer.tail = (tx_buffer.tail + 1) & SERIAL_TX_BUFFER_MASK;
+            busy = true;
+        }
+        if(outLength == sizeof(out))
+        {
+            ptyWrite(out,outLength);
+            outLength = 0;
+        }
+        hostClock::time_point now = hostClock::now();
+        if(!busy)
+        {
+            if(t < now) t = now;
+            if(uartFifoLength) std::this_thread::yield();
+            continue;
+        }
+        t += byteTime;
+        if(t > now + milliseconds(1))
+        {
+            if(outLength)
+            {
+                ptyWrite(out,outLength);
+                outLength = 0;
+            }
+            std::this_thread::sleep_until(t);
+        }
+    }
+}
+
+/** \brief With HostConfig::port the pseudo terminal is opened on the first call, the baud rate
+sets the byte time of the UART thread. The memory serial of the checks has no baud rate. */
+void HAL::serialSetBaudrate(long baud)
+{
+    if(!HostConfig::port) return;
+    if(HostConfig::baud) baud = HostConfig::baud;
+    uartBaud = baud;
+    if(ptyOpened) return;
+    ptyOpened = true;
+    const char *name = ptyOpen(HostConfig::link);
+    fprintf(stderr,"serial port %s%s%s at %ld baud\n",name,HostConfig::link ? " <- " : "",
+            HostConfig::link ? HostConfig::link : "",baud);
+    std::thread(uartThread).detach();
+}
+
+bool HAL::serialByteAvailable()
+{
+    return rx_buffer.head != rx_buffer.tail;
+}
+
+int HAL::serialRxFree()
+{
+    return SERIAL_BUFFER_SIZE - 1 - ((rx_buffer.head - rx_buffer.tail) & SERIAL_BUFFER_MASK);
+}
+
+int HAL::serialTxFree()
+{
+    if(!HostConfig::port) return SERIAL_TX_BUFFER_SIZE - 1; // output goes to memory at once
+    return SERIAL_TX_BUFFER_SIZE - 1 - ((tx_buffer.head - tx_buffer.tail) & SERIAL_TX_BUFFER_MASK);
+}
+
+uint8_t HAL::serialReadByte()
+{
+    if(rx_buffer.head == rx_buffer.tail) return 255;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    unsigned char c = rx_buffer.buffer[rx_buffer.tail];
+    rx_buffer.tail = (rx_buffer.tail + 1) & SERIAL_BUFFER_MASK;
+    return c;
+}
+
+void HAL::serialWriteByte(char b)
+{
+    if(!HostConfig::port)
+    {
+        std::lock_guard<std::mutex> lock(outputLock);
+        output += b;
+        return;
+    }
+    uint8_t i = (tx_buffer.head + 1) & SERIAL_TX_BUFFER_MASK;
+    while(i == tx_buffer.tail)
+        std::this_thread::yield();
+    tx_buffer.buffer[tx_buffer.head] = b;
+    std::atomic_thread_fence(std::memory_order_release);
+    tx_buffer.head = i;
+}
+
+void HAL::serialFlush()
+{
+    while(tx_buffer.head != tx_buffer.tail)
+        std::this_thread::yield();
+}
+
+#if FEATURE_REALTIME_COMMANDS
+void HAL::serialAsciiLineDone()
+{
+    BEGIN_INTERRUPT_PROTECTED
+    if(rxLineState == RX_BINARY && rx_buffer.head == rx_buffer.tail)
+        rxLineState = RX_BETWEEN_LINES;
+    END_INTERRUPT_PROTECTED
+}
+#endif
+
+#if FEATURE_SERIAL_ERRORS
+/** \brief Prints the baud rate, the receive error counters, the commands received over serial,
+resend requests and the dropped output lines. reset clears the counters afterwards. With a pseudo
+terminal the baud rate is the one of the UART thread, which --baud may have replaced. */
+void HAL::reportSerialErrors(bool reset)
+{
+    Com::printF(Com::tSerialErrors,(int32_t)(HostConfig::port ? uartBaud.load() : baudrate));
+    uint16_t overrun,frame,dropped;
+    BEGIN_INTERRUPT_PROTECTED
+    overrun = serialErrors.overrun;
+    frame = serialErrors.frame;
+    dropped = serialErrors.dropped;
+    if(reset)
+        serialErrors.overrun = serialErrors.frame = serialErrors.dropped = 0;
+    END_INTERRUPT_PROTECTED
+    Com::printF(Com::tSerialOverrun,(int32_t)overrun);
+    Com::printF(Com::tSerialFrame,(int32_t)frame);
+    Com::printF(Com::tSerialDropped,(int32_t)dropped);
+    Com::printF(Com::tSerialCommands,GCode::commandsReceived);
+    Com::printF(Com::tSerialResends,(int32_t)GCode::resendRequests);
+    if(reset)
+    {
+        GCode::commandsReceived = 0;
+        GCode::resendRequests = 0;
+    }
+#if FEATURE_OUTPUT_BUFFER
+    Com::printF(Com::tSerialLinesDropped,(int32_t)Com::droppedLines);
+    if(reset)
+        Com::droppedLines = 0;
+#endif
+    Com::println();
+}
+#endif
+
+/** \brief Sets the head thermistor input to a value the head detection reads as the
+wanted head. The firmware conversion is used, so the table of the configuration fits. */
+static void setHeadInput(BoXZY_head_t head)
+{
+    TemperatureController *c = tempController[BOXZY_HEAD_TYPE_TEMPERATURE_CONTROLLER_NUMBER];
+    float target = 25;
+    if(head == BoXZY_Laser_head) target = BOXZY_HEAD_TYPE_LASER_HEAD_MIN_TEMP_C + 20;
+    else if(head == BoXZY_CnC_head) target = BOXZY_HEAD_TYPE_MILLING_HEAD_MAX_TEMP_C - 20;
+    uint16_t best = 0;
+    float bestError = 1e9;
+    for(uint16_t raw = 0; raw < 4096; raw++)
+    {
+        osAnalogInputValues[c->sensorPin] = raw;
+        c->updateCurrentTemperature();
+        float error = fabs(c->currentTemperatureC - target);
+        if(error < bestError)
+        {
+            bestError = error;
+            best = raw;
+        }
+    }
+    osAnalogInputValues[c->sensorPin] = best;
+    c->updateCurrentTemperature();
+}
+
+bool hostSetup(BoXZY_head_t head)
+{
+    // Homing at startup never reaches an endstop, it runs without waiting.
+    float speed = HostConfig::speed;
+    HostConfig::speed = 0;
+    Printer::setup();
+    setHeadInput(head);
+    millis_t start = HAL::timeInMilliseconds();
+    while(Printer::BoXZY_head != head && HAL::timeInMilliseconds() - start < 3000)
+        Commands::checkForPeriodicalActions();
+    HostConfig::speed = speed;
+    return Printer::BoXZY_head == head;
+}
+
+// Timers ---------------------------------------------------------------------
+
+/** \brief Stepper interrupt as in the firmware timer 1 interrupt. The returned ticks are
+16 MHz timer ticks, they are slept off divided by HostConfig::speed. Speed 0 runs the
+moves as fast as the pc can. The 100 ms flag of the PWM interrupt is set here too. */
+static void timerThread()
+{
+    hostClock::time_point t = hostClock::now();
+    hostClock::time_point nextPeriodical = t + milliseconds(100);
+    while(true)
+    {
+        ticks_t wait;
+        // The receive interrupt has the higher priority, it runs between two stepper interrupts.
+        while(isrPending) std::this_thread::yield();
+        enterInterrupt();
+        if(PrintLine::hasLines())
+        {
+            uint64_t start = cycleCounter();
+            wait = PrintLine::bresenhamStep();
+            uint64_t cycles = cycleCounter() - start;
+            stepperStats.cycles[cycles < 1023 ? cycles : 1023]++;
+            stepperStats.calls++;
+        }
+        else if(FEATURE_BABYSTEPPING && Printer::zBabystepsMissing)
+        {
+            Printer::zBabystep();
+            wait = Printer::interval;
+        }
+        else
+            wait = 0;
+        hostClock::time_point now = hostClock::now();
+        if(now >= nextPeriodical)
+        {
+            executePeriodical = 1;
+            nextPeriodical += milliseconds(100);
+            if(nextPeriodical < now) nextPeriodical = now + milliseconds(100);
+        }
+        leaveInterrupt();
+        if(wait == 0) // idle, the firmware timer waits 65500 ticks
+        {
+            t = now;
+            std::this_thread::sleep_for(milliseconds(1));
+            continue;
+        }
+        if(HostConfig::speed <= 0)
+        {
+            t = now;
+            continue;
+        }
+        t += nanoseconds((int64_t)(wait * (1000000000.0 / F_CPU) / HostConfig::speed));
+        if(t < now - milliseconds(50)) t = now - milliseconds(50); // can not keep up, do not catch up forever
+        if(t > now + milliseconds(1))
+            std::this_thread::sleep_until(t);
+    }
+}
+
+void HAL::setupTimer()
+{
+    std::thread(timerThread).detach();
+}
@@ -0,0 +1,347 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Host replacement of HAL.h. The host Makefile copies it over the firmware HAL.h,
+  so all firmware sources except HAL.cpp compile unchanged for a linux pc, see HAL.cpp
+  in this folder. The serial port is memory for the checks or a pseudo terminal.
+*/
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) s
+#define pgm_read_byte_near(x) (*(const uint8_t*)(x))
+#define pgm_read_byte(x) (*(const uint8_t*)(x))
+// Flash tables hold pointers too, which are not 16 bit here, so words read the addressed type.
+#define pgm_read_word(x) (*(x))
+#define pgm_read_dword(x) (*(x))
+#define pgm_read_float(x) (*(x))
+
+#define PACK
+
+#define FSTRINGVALUE(var,value) const char var[] PROGMEM = value;
+#define FSTRINGVAR(var) static const char var[] PROGMEM;
+#define FSTRINGPARAM(var) PGM_P var
+
+#define TIMER0_PRESCALE 64
+
+#define _BV(b) (1 << (b))
+#define ANALOG_PRESCALER 0
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+typedef uint8_t byte;
+typedef bool boolean;
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+// Pins are only levels. An input reads the last written level, so an input with pull-up
+// reads high like an open switch. Unused pins are -1 and share the last entry.
+// Changes from low to high are counted, for a step pin these are the steps.
+extern uint8_t hostPinLevel[256];
+extern uint32_t hostPinRises[256];
+inline void hostWritePin(uint8_t pin,uint8_t level)
+{
+    if(level && !hostPinLevel[pin]) hostPinRises[pin]++;
+    hostPinLevel[pin] = level ? HIGH : LOW;
+}
+#define	READ(IO) hostPinLevel[(uint8_t)(IO)]
+#define	WRITE(IO, v) hostWritePin((uint8_t)(IO),(v))
+#define	SET_INPUT(IO) do {(void)(IO);} while(0)
+#define	SET_OUTPUT(IO) do {(void)(IO);} while(0)
+#define	TOGGLE(IO) hostWritePin((uint8_t)(IO),!READ(IO))
+#define	PULLUP(IO,v) WRITE(IO,v)
+inline void digitalWrite(uint8_t pin,uint8_t value)
+{
+    WRITE(pin,value);
+}
+inline int digitalRead(uint8_t pin)
+{
+    return READ(pin);
+}
+inline void pinMode(uint8_t,uint8_t) {}
+void analogWrite(uint8_t pin,int value);
+
+#define BEGIN_INTERRUPT_PROTECTED {bool sreg=HAL::interruptsAllowed();HAL::forbidInterrupts();
+#define END_INTERRUPT_PROTECTED if(sreg) HAL::allowInterrupts();}
+#define ESCAPE_INTERRUPT_PROTECTED if(sreg) HAL::allowInterrupts();
+
+#define EEPROM_OFFSET               0
+#define SECONDS_TO_TICKS(s) (unsigned long)(s*(float)F_CPU)
+#define ANALOG_REDUCE_BITS 0
+#define ANALOG_REDUCE_FACTOR 1
+
+#define MAX_RAM 32767
+
+#define bit_clear(x,y) x&= ~(1<<y)
+#define bit_set(x,y)   x|= (1<<y)
+
+#define I2C_READ    1
+#define I2C_WRITE   0
+
+#if NONLINEAR_SYSTEM
+#define LIMIT_INTERVAL ((F_CPU/30000)+1)
+#else
+#define LIMIT_INTERVAL ((F_CPU/40000)+1)
+#endif
+
+typedef uint16_t speed_t;
+typedef uint32_t ticks_t;
+typedef uint32_t millis_t;
+typedef uint8_t flag8_t;
+
+#define FAST_INTEGER_SQRT
+
+// Same buffer sizes as the firmware UART.
+#ifndef SERIAL_BUFFER_SIZE
+#define SERIAL_BUFFER_SIZE 128
+#endif
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 64
+#endif
+#if SERIAL_BUFFER_SIZE > 256 || SERIAL_TX_BUFFER_SIZE > 256
+#error Serial ring buffers are limited to 256 byte
+#endif
+#if (SERIAL_BUFFER_SIZE & (SERIAL_BUFFER_SIZE - 1)) || (SERIAL_TX_BUFFER_SIZE & (SERIAL_TX_BUFFER_SIZE - 1))
+#error Serial ring buffer sizes must be a power of 2
+#endif
+#define SERIAL_BUFFER_MASK (SERIAL_BUFFER_SIZE - 1)
+#define SERIAL_TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1)
+
+struct ring_buffer
+{
+    unsigned char buffer[SERIAL_BUFFER_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+};
+struct ring_buffer_tx
+{
+    unsigned char buffer[SERIAL_TX_BUFFER_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+};
+#define RX_BETWEEN_LINES 0 ///< Receive interrupt waits for the first byte of a line or packet
+#define RX_IN_LINE 1 ///< Receive interrupt is inside an ascii line
+#define RX_BINARY 2 ///< Host sends binary packets, real time bytes are not taken
+/** \brief Receive errors counted in the receive interrupt. Counters stop at 65535. */
+struct serial_errors
+{
+    volatile uint16_t overrun; ///< UART data overrun, only set by the pseudo terminal serial
+    volatile uint16_t frame; ///< Missing stop bit, only set by the pseudo terminal serial
+    volatile uint16_t dropped; ///< Bytes lost because the receive ring was full
+};
+#if FEATURE_SERIAL_ERRORS
+extern serial_errors serialErrors;
+#endif
+
+#define OUT_P_I(p,i) Com::printF(PSTR(p),(int)(i))
+#define OUT_P_I_LN(p,i) Com::printFLN(PSTR(p),(int)(i))
+#define OUT_P_L(p,i) Com::printF(PSTR(p),(long)(i))
+#define OUT_P_L_LN(p,i) Com::printFLN(PSTR(p),(long)(i))
+#define OUT_P_F(p,i) Com::printF(PSTR(p),(float)(i))
+#define OUT_P_F_LN(p,i) Com::printFLN(PSTR(p),(float)(i))
+#define OUT_P_FX(p,i,x) Com::printF(PSTR(p),(float)(i),x)
+#define OUT_P_FX_LN(p,i,x) Com::printFLN(PSTR(p),(float)(i),x)
+#define OUT_P(p) Com::printF(PSTR(p))
+#define OUT_P_LN(p) Com::printFLN(PSTR(p))
+#define OUT_ERROR_P(p) Com::printErrorF(PSTR(p))
+#define OUT_ERROR_P_LN(p) {Com::printErrorF(PSTR(p));Com::println();}
+#define OUT(v) Com::print(v)
+#define OUT_LN Com::println()
+
+/** \brief Settings of the simulated machine, boxzy-sim sets them from the command line in main.cpp. */
+struct HostConfig
+{
+    static bool port; ///< Serial port is a pseudo terminal instead of memory
+    static const char *link; ///< Symlink created to the pseudo terminal, NULL for none
+    static long baud; ///< Replaces the baud rate of the firmware if not 0
+    static float noiseFlip; ///< Probability of a received byte with one flipped bit
+    static float noiseFrame; ///< Probability of a received garbage byte with a frame error
+    static float noiseDrop; ///< Probability of a byte that never arrives
+    static uint32_t seed; ///< Seed of the noise generator
+    static float speed; ///< Stepper timer speed, 1 is real time, 0 as fast as possible
+    static bool overrun; ///< A full hardware receive buffer loses bytes instead of waiting
+};
+
+/** \brief Host HAL with the static interface of the firmware HAL.
+
+The math helpers are the portable versions of the assembler code. The "interrupts"
+are the stepper thread and with a pseudo terminal the UART thread of the host,
+forbidInterrupts() keeps them out until allowInterrupts() is called. */
+class HAL
+{
+public:
+    HAL();
+    virtual ~HAL();
+    static inline void hwSetup(void)
+    {}
+    static uint16_t integerSqrt(int32_t a);
+    static inline int32_t Div4U2U(uint32_t a,uint16_t b)
+    {
+        return a/b;
+    }
+    static inline unsigned long U16SquaredToU32(unsigned int val)
+    {
+        return (unsigned long)val*val;
+    }
+    static inline unsigned int ComputeV(long timer,long accel)
+    {
+        return ((timer>>8)*accel)>>10;
+    }
+    static inline uint32_t mulu16xu16to32(unsigned int a,unsigned int b)
+    {
+        return (uint32_t)a*b;
+    }
+    static inline unsigned int mulu6xu16shift16(unsigned int a,unsigned int b)
+    {
+        return ((uint32_t)a*b)>>16;
+    }
+    static inline void digitalWrite(uint8_t pin,uint8_t value)
+    {
+        ::digitalWrite(pin,value);
+    }
+    static inline uint8_t digitalRead(uint8_t pin)
+    {
+        return ::digitalRead(pin);
+    }
+    static inline void pinMode(uint8_t pin,uint8_t mode)
+    {
+        ::pinMode(pin,mode);
+    }
+    static int32_t CPUDivU2(unsigned int divisor);
+    static void delayMicroseconds(unsigned int delayUs);
+    static void delayMilliseconds(unsigned int delayMs);
+    static inline void tone(uint8_t pin,int duration) {}
+    static inline void noTone(uint8_t pin) {}
+    static inline void eprSetByte(unsigned int pos,uint8_t value)
+    {
+        eeprom[pos] = value;
+    }
+    static inline void eprSetInt16(unsigned int pos,int16_t value)
+    {
+        memcpy(&eeprom[pos],&value,2);
+    }
+    static inline void eprSetInt32(unsigned int pos,int32_t value)
+    {
+        memcpy(&eeprom[pos],&value,4);
+    }
+    static inline void eprSetFloat(unsigned int pos,float value)
+    {
+        memcpy(&eeprom[pos],&value,4);
+    }
+    static inline uint8_t eprGetByte(unsigned int pos)
+    {
+        return eeprom[pos];
+    }
+    static inline int16_t eprGetInt16(unsigned int pos)
+    {
+        int16_t v;
+        memcpy(&v,&eeprom[pos],2);
+        return v;
+    }
+    static inline int32_t eprGetInt32(unsigned int pos)
+    {
+        int32_t v;
+        memcpy(&v,&eeprom[pos],4);
+        return v;
+    }
+    static inline float eprGetFloat(unsigned int pos)
+    {
+        float v;
+        memcpy(&v,&eeprom[pos],4);
+        return v;
+    }
+    static void allowInterrupts();
+    static void forbidInterrupts();
+    static bool interruptsAllowed();
+    static unsigned long timeInMilliseconds();
+    static inline char readFlashByte(PGM_P ptr)
+    {
+        return *ptr;
+    }
+    static void serialSetBaudrate(long baud);
+    static bool serialByteAvailable();
+    static uint8_t serialReadByte();
+    static void serialWriteByte(char b);
+    static void serialFlush();
+    /** Free bytes in the serial receive buffer. */
+    static int serialRxFree();
+    /** Free bytes in the serial send buffer. */
+    static int serialTxFree();
+#if FEATURE_SERIAL_ERRORS
+    static void reportSerialErrors(bool reset);
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    static void serialAsciiLineDone();
+#endif
+    static void setupTimer();
+    static void showStartReason();
+    static int getFreeRam();
+    static void resetHardware();
+    static inline void spiBegin() {}
+    static inline void spiInit(uint8_t spiRate) {}
+    static inline uint8_t spiReceive(uint8_t send=0xff)
+    {
+        return 0xff;
+    }
+    static inline void spiReadBlock(uint8_t*buf,size_t nbyte)
+    {
+        memset(buf,0xff,nbyte);
+    }
+    static inline void spiSend(uint8_t b) {}
+    static inline void spiSend(const uint8_t* buf , size_t n) {}
+    static inline void spiSendBlock(uint8_t token, const uint8_t* buf) {}
+    static inline void i2cInit(unsigned long clockSpeedHz) {}
+    static inline unsigned char i2cStart(unsigned char address)
+    {
+        return 1;
+    }
+    static inline void i2cStartWait(unsigned char address) {}
+    static inline void i2cStop(void) {}
+    static inline unsigned char i2cWrite( unsigned char data )
+    {
+        return 1;
+    }
+    static inline unsigned char i2cReadAck(void)
+    {
+        return 0;
+    }
+    static inline unsigned char i2cReadNak(void)
+    {
+        return 0;
+    }
+    inline static void startWatchdog() {}
+    inline static void stopWatchdog() {}
+    inline static void pingWatchdog() {}
+    inline static float maxExtruderTimerFrequency()
+    {
+        return (float)F_CPU/TIMER0_PRESCALE;
+    }
+    static inline void analogStart() {}
+    static uint8_t eeprom[4096]; ///< EEPROM image, starts erased on every run
+};
+
+#endif // HAL_H
@@ -0,0 +1,349 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Streams gcode files to a serial port like a host program and reports the streaming rate.
+  Lines get line numbers and checksums. The host keeps sending while the unacknowledged
+  lines fit into the receive buffer of the firmware, answers resend requests and resends
+  after a timeout. At the end M405 and M408 report the queue stalls and the serial errors.
+*/
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+typedef steady_clock benchClock;
+
+struct SentLine
+{
+    long number;
+    size_t bytes;
+};
+
+static int port = -1;
+static bool verbose = false;
+static std::string received;
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: bench [options] PORT JOB...\n"
+            "  -b, --bytes N     unacknowledged bytes allowed in the firmware (default 127)\n"
+            "  -p, --ping-pong   wait for each ok before the next line\n"
+            "  -t, --timeout MS  resend the oldest line without an answer after MS (default 30000)\n"
+            "  -v, --verbose     print everything the firmware sends\n");
+    exit(1);
+}
+
+/** \brief Reads the next line from the port, returns false if none arrived within timeoutMs. */
+static bool readLine(std::string &line,int timeoutMs)
+{
+    benchClock::time_point end = benchClock::now() + milliseconds(timeoutMs);
+    while(true)
+    {
+        size_t eol = received.find_first_of("\r\n");
+        if(eol != std::string::npos)
+        {
+            line = received.substr(0,eol);
+            received.erase(0,eol + 1);
+            if(line.empty()) continue;
+            if(verbose) printf("< %s\n",line.c_str());
+            return true;
+        }
+        int left = duration_cast<milliseconds>(end - benchClock::now()).count();
+        if(left < 0) return false;
+        struct pollfd p = {port,POLLIN,0};
+        if(poll(&p,1,left) <= 0) continue;
+        char buf[512];
+        int n = read(port,buf,sizeof(buf));
+        if(n > 0) received.append(buf,n);
+    }
+}
+
+static void sendLine(long number,const std::string &cmd,std::string &out)
+{
+    char prefix[16];
+    snprintf(prefix,sizeof(prefix),"N%ld ",number);
+    out = prefix + cmd;
+    unsigned char checksum = 0;
+    for(size_t i = 0; i < out.size(); i++) checksum ^= out[i];
+    char suffix[8];
+    snprintf(suffix,sizeof(suffix),"*%d\n",checksum);
+    out += suffix;
+    if(verbose) printf("> %s",out.c_str());
+    const char *p = out.c_str();
+    size_t left = out.size();
+    while(left)
+    {
+        int n = write(port,p,left);
+        if(n < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            perror("write");
+            exit(1);
+        }
+        if(n > 0)
+        {
+            p += n;
+            left -= n;
+        }
+    }
+}
+
+/** \brief Removes comments and surrounding blanks, returns false for empty lines. */
+static bool cleanLine(std::string &line)
+{
+    size_t comment = line.find(';');
+    if(comment != std::string::npos) line.erase(comment);
+    size_t open;
+    while((open = line.find('(')) != std::string::npos)
+    {
+        size_t close = line.find(')',open);
+        line.erase(open,close == std::string::npos ? std::string::npos : close - open + 1);
+    }
+    size_t first = line.find_first_not_of(" \t\r\n");
+    if(first == std::string::npos) return false;
+    line = line.substr(first,line.find_last_not_of(" \t\r\n") - first + 1);
+    return true;
+}
+
+/** \brief The firmware runs lines starting with a G, M or T command. The milling jobs also
+contain questions for the user like "SET ZSHIFT = ?" and modal moves without G word, the
+host software handles them. */
+static bool isGCode(const std::string &line)
+{
+    return line.size() >= 2 && strchr("GMTgmt",line[0]) && isdigit(line[1]);
+}
+
+static long numberAfter(const std::string &line,const char *key)
+{
+    size_t pos = line.find(key);
+    if(pos == std::string::npos) return -1;
+    return strtol(line.c_str() + pos + strlen(key),NULL,10);
+}
+
+int main(int argc,char **argv)
+{
+    static const struct option options[] =
+    {
+        {"bytes",required_argument,0,'b'},
+        {"ping-pong",no_argument,0,'p'},
+        {"timeout",required_argument,0,'t'},
+        {"verbose",no_argument,0,'v'},
+        {0,0,0,0}
+    };
+    size_t maxBytes = 127;
+    bool pingPong = false;
+    int timeoutMs = 30000;
+    int opt;
+    while((opt = getopt_long(argc,argv,"b:pt:v",options,NULL)) != -1)
+    {
+        switch(opt)
+        {
+        case 'b':
+            maxBytes = atol(optarg);
+            break;
+        case 'p':
+            pingPong = true;
+            break;
+        case 't':
+            timeoutMs = atoi(optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage();
+        }
+    }
+    if(argc - optind < 2) usage();
+    port = open(argv[optind],O_RDWR | O_NOCTTY);
+    if(port < 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    struct termios tio;
+    tcgetattr(port,&tio);
+    cfmakeraw(&tio);
+    tcsetattr(port,TCSANOW,&tio);
+    tcflush(port,TCIOFLUSH);
+
+    std::vector<std::string> job;
+    long hostLines = 0;
+    for(int i = optind + 1; i < argc; i++)
+    {
+        FILE *f = fopen(argv[i],"r");
+        if(!f)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        char buf[1024];
+        while(fgets(buf,sizeof(buf),f))
+        {
+            std::string line(buf);
+            if(!cleanLine(line)) continue;
+            if(isGCode(line))
+                job.push_back(line);
+            else
+                hostLines++;
+        }
+        fclose(f);
+    }
+    size_t jobLines = job.size();
+    job.insert(job.begin(),"M408 S1");
+    job.insert(job.begin(),"M405 S1");
+    job.push_back("M400");
+    job.push_back("M405");
+    job.push_back("M408");
+
+    // Line numbers start again with M110, repeated until the firmware answers.
+    std::string line,out;
+    bool synced = false;
+    for(int tries = 0; tries < 30 && !synced; tries++)
+    {
+        sendLine(0,"M110",out);
+        benchClock::time_point end = benchClock::now() + milliseconds(1000);
+        while(!synced && benchClock::now() < end && readLine(line,100))
+            synced = line.compare(0,2,"ok") == 0;
+    }
+    if(!synced)
+    {
+        fprintf(stderr,"no answer from %s\n",argv[optind]);
+        return 1;
+    }
+    while(readLine(line,200)) {}
+
+    std::deque<SentLine> inFlight;
+    size_t bytesInFlight = 0;
+    size_t next = 0; // index into job, line number is index + 1
+    long resends = 0,skips = 0,timeouts = 0,errors = 0;
+    // M405 and M408 answer at the start and at the end of the job, the second answers count.
+    std::string stallReport,serialReport;
+    int stallReports = 0,serialReports = 0;
+    benchClock::time_point start = benchClock::now(),lastAnswer = start,end;
+    while(next < job.size() || !inFlight.empty())
+    {
+        // Send while the lines fit into the receive buffer of the firmware.
+        while(next < job.size())
+        {
+            size_t bytes = job[next].size() + 12; // N, checksum and newline
+            if(!inFlight.empty() && (pingPong || bytesInFlight + bytes > maxBytes)) break;
+            sendLine(next + 1,job[next],out);
+            SentLine s = {(long)next + 1,out.size()};
+            inFlight.push_back(s);
+            bytesInFlight += s.bytes;
+            next++;
+        }
+        if(!readLine(line,10))
+        {
+            if(!inFlight.empty() && benchClock::now() - lastAnswer > milliseconds(timeoutMs))
+            {
+                timeouts++;
+                next = inFlight.front().number - 1;
+                inFlight.clear();
+                bytesInFlight = 0;
+                lastAnswer = benchClock::now();
+            }
+            continue;
+        }
+        lastAnswer = benchClock::now();
+        long n;
+        if(line.compare(0,3,"ok ") == 0 && (n = strtol(line.c_str() + 3,NULL,10)) > 0)
+        {
+            for(std::deque<SentLine>::iterator it = inFlight.begin(); it != inFlight.end(); ++it)
+                if(it->number == n)
+                {
+                    bytesInFlight -= it->bytes;
+                    inFlight.erase(it);
+                    break;
+                }
+        }
+        else if((n = numberAfter(line,"Resend:")) > 0)
+        {
+            // Lines in front of n arrived. Lines behind it are sent again, the firmware
+            // skips the ones it already has.
+            resends++;
+            next = n - 1;
+            inFlight.clear();
+            bytesInFlight = 0;
+        }
+        else if(line.compare(0,5,"skip ") == 0)
+        {
+            skips++;
+            n = strtol(line.c_str() + 5,NULL,10);
+            for(std::deque<SentLine>::iterator it = inFlight.begin(); it != inFlight.end(); ++it)
+                if(it->number == n)
+                {
+                    bytesInFlight -= it->bytes;
+                    inFlight.erase(it);
+                    break;
+                }
+        }
+        else if(line.compare(0,6,"Error:") == 0)
+        {
+            errors++;
+            if(!verbose) fprintf(stderr,"%s\n",line.c_str());
+        }
+        else if(line.compare(0,7,"Stalls:") == 0)
+        {
+            stallReport = line;
+            stallReports++;
+        }
+        else if(line.compare(0,12,"Serial baud:") == 0)
+        {
+            serialReport = line;
+            if(++serialReports == 2) end = benchClock::now();
+        }
+    }
+    // Lines held for a missing line are acknowledged before they run, so the reports of the
+    // last lines can come after all acknowledgements. The job ends with the last report.
+    while((stallReports < 2 || serialReports < 2) && readLine(line,timeoutMs))
+    {
+        if(line.compare(0,7,"Stalls:") == 0)
+        {
+            stallReport = line;
+            stallReports++;
+        }
+        else if(line.compare(0,12,"Serial baud:") == 0)
+        {
+            serialReport = line;
+            if(++serialReports == 2) end = benchClock::now();
+        }
+    }
+    if(serialReports < 2)
+    {
+        fprintf(stderr,"the reports at the end of the job did not arrive\n");
+        return 1;
+    }
+    double seconds = duration_cast<microseconds>(end - start).count() / 1e6;
+    printf("lines: %lu time: %.2f s lines/s: %.1f\n",(unsigned long)jobLines,seconds,jobLines / seconds);
+    printf("host: resend requests: %ld skipped: %ld timeouts: %ld errors: %ld not sent: %ld\n",resends,skips,timeouts,errors,hostLines);
+    printf("queue: %s\n",stallReport.c_str());
+    printf("serial: %s\n",serialReport.c_str());
+    return 0;
+}
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Streams the recorded jobs through the host build of the firmware and prints the
+# streaming rate, resends and queue stalls of each job.
+#
+#   ./bench.sh [boxzy-sim options]      e.g. ./bench.sh --speed 0 --flip 0.001
+#
+# BENCH_OPTIONS passes options to the bench program, e.g. BENCH_OPTIONS=--ping-pong.
+cd "$(dirname "$0")" || exit 1
+status=0
+
+run() {
+    head=$1
+    job=$2
+    shift 2
+    rm -f build/port build/sim.log
+    build/default/boxzy-sim --link build/port --head "$head" "$@" 2> build/sim.log &
+    sim=$!
+    tries=0
+    until grep -q ready build/sim.log 2> /dev/null; do
+        tries=$((tries + 1))
+        if [ $tries -gt 100 ] || ! kill -0 $sim 2> /dev/null; then
+            echo "boxzy-sim did not start:" >&2
+            cat build/sim.log >&2
+            kill $sim 2> /dev/null
+            return 1
+        fi
+        sleep 0.1
+    done
+    echo "== $job ($head head)"
+    build/bench $BENCH_OPTIONS build/port "$job" || status=1
+    kill $sim
+    wait $sim 2> /dev/null
+    return 0
+}
+
+run laser jobs/laser_raster.gcode "$@" || status=1
+run mill ../../../Milling.Test.Gcode "$@" || status=1
+exit $status
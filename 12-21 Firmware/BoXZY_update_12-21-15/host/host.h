@@ -0,0 +1,46 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Functions of the host HAL that are not part of the firmware HAL.
+*/
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <string>
+
+/** \brief Runs Printer::setup() and waits until the head detection found the given head.
+@returns false if the head was not detected within 3 seconds. */
+bool hostSetup(BoXZY_head_t head);
+/** \brief Runs the receive interrupt for a byte from the host.
+@returns false if the receive buffer was full and the byte was not stored. */
+bool hostReceive(uint8_t c);
+/** \brief Everything the firmware sent since the last call. */
+std::string hostOutput();
+
+/** \brief Work of the stepper interrupt. */
+struct HostStepperStats
+{
+    uint64_t calls; ///< Calls of PrintLine::bresenhamStep()
+    uint64_t intervalLookups; ///< Calls of HAL::CPUDivU2() from the interrupt
+    /** Calls by cpu cycles spent in them, nanoseconds where the cpu has no cycle counter.
+    The last entry counts all longer calls, mostly calls the thread was preempted in. */
+    uint32_t cycles[1024];
+};
+/** \brief Stepper interrupt work since the last call. */
+HostStepperStats hostStepperStats();
+
+#endif // HOST_H
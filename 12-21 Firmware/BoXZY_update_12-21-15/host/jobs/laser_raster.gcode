@@ -0,0 +1,376 @@
+; Laser raster job for the host benchmark, as the BoXZY laser interface streams it:
+; a 16 x 8 mm ellipse with a radial gradient, 0.1 mm pixels, 0.2 mm line pitch,
+; bidirectional lines split into short G1 moves with run length coded L powers.
+G21
+G90
+G92 X0 Y0 Z0
+G0 X20.000 Y20.000 F3000
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^20
+G1 X26.000 L0^20
+G1 X28.000 L0^20
+G1 X30.000 L0^20
+G1 X32.000 L0^20
+G1 X34.000 L0^20
+G1 X36.000 L0^20
+G0 X36.000 Y20.200
+G1 X34.000 F1200 L0^20
+G1 X32.000 L0^20
+G1 X30.000 L0^15 L20^5
+G1 X28.000 L20^20
+G1 X26.000 L20^20
+G1 X24.000 L20^5 L0^15
+G1 X22.000 L0^20
+G1 X20.000 L0^20
+G0 X20.000 Y20.400
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^20
+G1 X26.000 L0^5 L20^15
+G1 X28.000 L20^3 L25^17
+G1 X30.000 L25^17 L20^3
+G1 X32.000 L20^15 L0^5
+G1 X34.000 L0^20
+G1 X36.000 L0^20
+G0 X36.000 Y20.600
+G1 X34.000 F1200 L0^20
+G1 X32.000 L0^18 L20^2
+G1 X30.000 L20^11 L25^9
+G1 X28.000 L25^20
+G1 X26.000 L25^20
+G1 X24.000 L25^9 L20^11
+G1 X22.000 L20^2 L0^18
+G1 X20.000 L0^20
+G0 X20.000 Y20.800
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^12 L20^8
+G1 X26.000 L20^3 L25^16 L30
+G1 X28.000 L30^20
+G1 X30.000 L30^20
+G1 X32.000 L30 L25^16 L20^3
+G1 X34.000 L20^8 L0^12
+G1 X36.000 L0^20
+G0 X36.000 Y21.000
+G1 X34.000 F1200 L0^20
+G1 X32.000 L0^7 L20^10 L25^3
+G1 X30.000 L25^9 L30^11
+G1 X28.000 L30^11 L35^9
+G1 X26.000 L35^9 L30^11
+G1 X24.000 L30^11 L25^9
+G1 X22.000 L25^3 L20^10 L0^7
+G1 X20.000 L0^20
+G0 X20.000 Y21.200
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^3 L20^9 L25^8
+G1 X26.000 L25^3 L30^14 L35^3
+G1 X28.000 L35^20
+G1 X30.000 L35^20
+G1 X32.000 L35^3 L30^14 L25^3
+G1 X34.000 L25^8 L20^9 L0^3
+G1 X36.000 L0^20
+G0 X36.000 Y21.400
+G1 X34.000 F1200 L0^19 L20
+G1 X32.000 L20^7 L25^10 L30^3
+G1 X30.000 L30^9 L35^11
+G1 X28.000 L35^5 L40^15
+G1 X26.000 L40^15 L35^5
+G1 X24.000 L35^11 L30^9
+G1 X22.000 L30^3 L25^10 L20^7
+G1 X20.000 L20 L0^19
+G0 X20.000 Y21.600
+G1 X22.000 F1200 L0^16 L20^4
+G1 X24.000 L20^4 L25^9 L30^7
+G1 X26.000 L30^3 L35^12 L40^5
+G1 X28.000 L40^20
+G1 X30.000 L40^20
+G1 X32.000 L40^5 L35^12 L30^3
+G1 X34.000 L30^7 L25^9 L20^4
+G1 X36.000 L20^4 L0^16
+G0 X36.000 Y21.800
+G1 X34.000 F1200 L0^13 L20^7
+G1 X32.000 L20 L25^8 L30^9 L35^2
+G1 X30.000 L35^9 L40^11
+G1 X28.000 L40^3 L45^17
+G1 X26.000 L45^17 L40^3
+G1 X24.000 L40^11 L35^9
+G1 X22.000 L35^2 L30^9 L25^8 L20
+G1 X20.000 L20^7 L0^13
+G0 X20.000 Y22.000
+G1 X22.000 F1200 L0^11 L20^7 L25^2
+G1 X24.000 L25^6 L30^8 L35^6
+G1 X26.000 L35^4 L40^11 L45^5
+G1 X28.000 L45^13 L50^7
+G1 X30.000 L50^7 L45^13
+G1 X32.000 L45^5 L40^11 L35^4
+G1 X34.000 L35^6 L30^8 L25^6
+G1 X36.000 L25^2 L20^7 L0^11
+G0 X36.000 Y22.200
+G1 X34.000 F1200 L0^9 L20^6 L25^5
+G1 X32.000 L25^3 L30^8 L35^9
+G1 X30.000 L40^9 L45^11
+G1 X28.000 L45 L50^19
+G1 X26.000 L50^19 L45
+G1 X24.000 L45^11 L40^9
+G1 X22.000 L35^9 L30^8 L25^3
+G1 X20.000 L25^5 L20^6 L0^9
+G0 X20.000 Y22.400
+G1 X22.000 F1200 L0^7 L20^6 L25^7
+G1 X24.000 L25 L30^7 L35^9 L40^3
+G1 X26.000 L40^5 L45^10 L50^5
+G1 X28.000 L50^9 L55^11
+G1 X30.000 L55^11 L50^9
+G1 X32.000 L50^5 L45^10 L40^5
+G1 X34.000 L40^3 L35^9 L30^7 L25
+G1 X36.000 L25^7 L20^6 L0^7
+G0 X36.000 Y22.600
+G1 X34.000 F1200 L0^5 L20^7 L25^7 L30
+G1 X32.000 L30^6 L35^8 L40^6
+G1 X30.000 L40^2 L45^9 L50^9
+G1 X28.000 L50 L55^19
+G1 X26.000 L55^19 L50
+G1 X24.000 L50^9 L45^9 L40^2
+G1 X22.000 L40^6 L35^8 L30^6
+G1 X20.000 L30 L25^7 L20^7 L0^5
+G0 X20.000 Y22.800
+G1 X22.000 F1200 L0^4 L20^6 L25^7 L30^3
+G1 X24.000 L30^4 L35^8 L40^7 L45
+G1 X26.000 L45^7 L50^9 L55^4
+G1 X28.000 L55^7 L60^13
+G1 X30.000 L60^13 L55^7
+G1 X32.000 L55^4 L50^9 L45^7
+G1 X34.000 L45 L40^7 L35^8 L30^4
+G1 X36.000 L30^3 L25^7 L20^6 L0^4
+G0 X36.000 Y23.000
+G1 X34.000 F1200 L0^3 L20^6 L25^7 L30^4
+G1 X32.000 L30^3 L35^7 L40^7 L45^3
+G1 X30.000 L45^5 L50^8 L55^7
+G1 X28.000 L55 L60^14 L65^5
+G1 X26.000 L65^5 L60^14 L55
+G1 X24.000 L55^7 L50^8 L45^5
+G1 X22.000 L45^3 L40^7 L35^7 L30^3
+G1 X20.000 L30^4 L25^7 L20^6 L0^3
+G0 X20.000 Y23.200
+G1 X22.000 F1200 L0^2 L20^6 L25^7 L30^5
+G1 X24.000 L30 L35^7 L40^7 L45^5
+G1 X26.000 L45^3 L50^7 L55^8 L60^2
+G1 X28.000 L60^7 L65^13
+G1 X30.000 L65^13 L60^7
+G1 X32.000 L60^2 L55^8 L50^7 L45^3
+G1 X34.000 L45^5 L40^7 L35^7 L30
+G1 X36.000 L30^5 L25^7 L20^6 L0^2
+G0 X36.000 Y23.400
+G1 X34.000 F1200 L0 L20^6 L25^7 L30^6
+G1 X32.000 L30 L35^6 L40^7 L45^6
+G1 X30.000 L45 L50^7 L55^7 L60^5
+G1 X28.000 L60^3 L65^10 L70^7
+G1 X26.000 L70^7 L65^10 L60^3
+G1 X24.000 L60^5 L55^7 L50^7 L45
+G1 X22.000 L45^6 L40^7 L35^6 L30
+G1 X20.000 L30^6 L25^7 L20^6 L0
+G0 X20.000 Y23.600
+G1 X22.000 F1200 L20^6 L25^7 L30^7
+G1 X24.000 L35^7 L40^6 L45^7
+G1 X26.000 L50^7 L55^7 L60^6
+G1 X28.000 L60 L65^8 L70^11
+G1 X30.000 L70^11 L65^8 L60
+G1 X32.000 L60^6 L55^7 L50^7
+G1 X34.000 L45^7 L40^6 L35^7
+G1 X36.000 L30^7 L25^7 L20^6
+G0 X36.000 Y23.800
+G1 X34.000 F1200 L20^6 L25^7 L30^6 L35
+G1 X32.000 L35^6 L40^7 L45^7
+G1 X30.000 L50^6 L55^7 L60^7
+G1 X28.000 L65^7 L70^7 L75^6
+G1 X26.000 L75^6 L70^7 L65^7
+G1 X24.000 L60^7 L55^7 L50^6
+G1 X22.000 L45^7 L40^7 L35^6
+G1 X20.000 L35 L30^6 L25^7 L20^6
+G0 X20.000 Y24.000
+G1 X22.000 F1200 L20^6 L25^7 L30^6 L35
+G1 X24.000 L35^6 L40^7 L45^6 L50
+G1 X26.000 L50^6 L55^7 L60^6 L65
+G1 X28.000 L65^6 L70^7 L75^6 L80
+G1 X30.000 L80 L75^6 L70^7 L65^6
+G1 X32.000 L65 L60^6 L55^7 L50^6
+G1 X34.000 L50 L45^6 L40^7 L35^6
+G1 X36.000 L35 L30^6 L25^7 L20^6
+G0 X36.000 Y24.200
+G1 X34.000 F1200 L20^6 L25^7 L30^6 L35
+G1 X32.000 L35^6 L40^7 L45^7
+G1 X30.000 L50^6 L55^7 L60^7
+G1 X28.000 L65^7 L70^7 L75^6
+G1 X26.000 L75^6 L70^7 L65^7
+G1 X24.000 L60^7 L55^7 L50^6
+G1 X22.000 L45^7 L40^7 L35^6
+G1 X20.000 L35 L30^6 L25^7 L20^6
+G0 X20.000 Y24.400
+G1 X22.000 F1200 L20^6 L25^7 L30^7
+G1 X24.000 L35^7 L40^6 L45^7
+G1 X26.000 L50^7 L55^7 L60^6
+G1 X28.000 L60 L65^8 L70^11
+G1 X30.000 L70^11 L65^8 L60
+G1 X32.000 L60^6 L55^7 L50^7
+G1 X34.000 L45^7 L40^6 L35^7
+G1 X36.000 L30^7 L25^7 L20^6
+G0 X36.000 Y24.600
+G1 X34.000 F1200 L0 L20^6 L25^7 L30^6
+G1 X32.000 L30 L35^6 L40^7 L45^6
+G1 X30.000 L45 L50^7 L55^7 L60^5
+G1 X28.000 L60^3 L65^10 L70^7
+G1 X26.000 L70^7 L65^10 L60^3
+G1 X24.000 L60^5 L55^7 L50^7 L45
+G1 X22.000 L45^6 L40^7 L35^6 L30
+G1 X20.000 L30^6 L25^7 L20^6 L0
+G0 X20.000 Y24.800
+G1 X22.000 F1200 L0^2 L20^6 L25^7 L30^5
+G1 X24.000 L30 L35^7 L40^7 L45^5
+G1 X26.000 L45^3 L50^7 L55^8 L60^2
+G1 X28.000 L60^7 L65^13
+G1 X30.000 L65^13 L60^7
+G1 X32.000 L60^2 L55^8 L50^7 L45^3
+G1 X34.000 L45^5 L40^7 L35^7 L30
+G1 X36.000 L30^5 L25^7 L20^6 L0^2
+G0 X36.000 Y25.000
+G1 X34.000 F1200 L0^3 L20^6 L25^7 L30^4
+G1 X32.000 L30^3 L35^7 L40^7 L45^3
+G1 X30.000 L45^5 L50^8 L55^7
+G1 X28.000 L55 L60^14 L65^5
+G1 X26.000 L65^5 L60^14 L55
+G1 X24.000 L55^7 L50^8 L45^5
+G1 X22.000 L45^3 L40^7 L35^7 L30^3
+G1 X20.000 L30^4 L25^7 L20^6 L0^3
+G0 X20.000 Y25.200
+G1 X22.000 F1200 L0^4 L20^6 L25^7 L30^3
+G1 X24.000 L30^4 L35^8 L40^7 L45
+G1 X26.000 L45^7 L50^9 L55^4
+G1 X28.000 L55^7 L60^13
+G1 X30.000 L60^13 L55^7
+G1 X32.000 L55^4 L50^9 L45^7
+G1 X34.000 L45 L40^7 L35^8 L30^4
+G1 X36.000 L30^3 L25^7 L20^6 L0^4
+G0 X36.000 Y25.400
+G1 X34.000 F1200 L0^5 L20^7 L25^7 L30
+G1 X32.000 L30^6 L35^8 L40^6
+G1 X30.000 L40^2 L45^9 L50^9
+G1 X28.000 L50 L55^19
+G1 X26.000 L55^19 L50
+G1 X24.000 L50^9 L45^9 L40^2
+G1 X22.000 L40^6 L35^8 L30^6
+G1 X20.000 L30 L25^7 L20^7 L0^5
+G0 X20.000 Y25.600
+G1 X22.000 F1200 L0^7 L20^6 L25^7
+G1 X24.000 L25 L30^7 L35^9 L40^3
+G1 X26.000 L40^5 L45^10 L50^5
+G1 X28.000 L50^9 L55^11
+G1 X30.000 L55^11 L50^9
+G1 X32.000 L50^5 L45^10 L40^5
+G1 X34.000 L40^3 L35^9 L30^7 L25
+G1 X36.000 L25^7 L20^6 L0^7
+G0 X36.000 Y25.800
+G1 X34.000 F1200 L0^9 L20^6 L25^5
+G1 X32.000 L25^3 L30^8 L35^9
+G1 X30.000 L40^9 L45^11
+G1 X28.000 L45 L50^19
+G1 X26.000 L50^19 L45
+G1 X24.000 L45^11 L40^9
+G1 X22.000 L35^9 L30^8 L25^3
+G1 X20.000 L25^5 L20^6 L0^9
+G0 X20.000 Y26.000
+G1 X22.000 F1200 L0^11 L20^7 L25^2
+G1 X24.000 L25^6 L30^8 L35^6
+G1 X26.000 L35^4 L40^11 L45^5
+G1 X28.000 L45^13 L50^7
+G1 X30.000 L50^7 L45^13
+G1 X32.000 L45^5 L40^11 L35^4
+G1 X34.000 L35^6 L30^8 L25^6
+G1 X36.000 L25^2 L20^7 L0^11
+G0 X36.000 Y26.200
+G1 X34.000 F1200 L0^13 L20^7
+G1 X32.000 L20 L25^8 L30^9 L35^2
+G1 X30.000 L35^9 L40^11
+G1 X28.000 L40^3 L45^17
+G1 X26.000 L45^17 L40^3
+G1 X24.000 L40^11 L35^9
+G1 X22.000 L35^2 L30^9 L25^8 L20
+G1 X20.000 L20^7 L0^13
+G0 X20.000 Y26.400
+G1 X22.000 F1200 L0^16 L20^4
+G1 X24.000 L20^4 L25^9 L30^7
+G1 X26.000 L30^3 L35^12 L40^5
+G1 X28.000 L40^20
+G1 X30.000 L40^20
+G1 X32.000 L40^5 L35^12 L30^3
+G1 X34.000 L30^7 L25^9 L20^4
+G1 X36.000 L20^4 L0^16
+G0 X36.000 Y26.600
+G1 X34.000 F1200 L0^19 L20
+G1 X32.000 L20^7 L25^10 L30^3
+G1 X30.000 L30^9 L35^11
+G1 X28.000 L35^5 L40^15
+G1 X26.000 L40^15 L35^5
+G1 X24.000 L35^11 L30^9
+G1 X22.000 L30^3 L25^10 L20^7
+G1 X20.000 L20 L0^19
+G0 X20.000 Y26.800
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^3 L20^9 L25^8
+G1 X26.000 L25^3 L30^14 L35^3
+G1 X28.000 L35^20
+G1 X30.000 L35^20
+G1 X32.000 L35^3 L30^14 L25^3
+G1 X34.000 L25^8 L20^9 L0^3
+G1 X36.000 L0^20
+G0 X36.000 Y27.000
+G1 X34.000 F1200 L0^20
+G1 X32.000 L0^7 L20^10 L25^3
+G1 X30.000 L25^9 L30^11
+G1 X28.000 L30^11 L35^9
+G1 X26.000 L35^9 L30^11
+G1 X24.000 L30^11 L25^9
+G1 X22.000 L25^3 L20^10 L0^7
+G1 X20.000 L0^20
+G0 X20.000 Y27.200
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^12 L20^8
+G1 X26.000 L20^3 L25^16 L30
+G1 X28.000 L30^20
+G1 X30.000 L30^20
+G1 X32.000 L30 L25^16 L20^3
+G1 X34.000 L20^8 L0^12
+G1 X36.000 L0^20
+G0 X36.000 Y27.400
+G1 X34.000 F1200 L0^20
+G1 X32.000 L0^18 L20^2
+G1 X30.000 L20^11 L25^9
+G1 X28.000 L25^20
+G1 X26.000 L25^20
+G1 X24.000 L25^9 L20^11
+G1 X22.000 L20^2 L0^18
+G1 X20.000 L0^20
+G0 X20.000 Y27.600
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^20
+G1 X26.000 L0^5 L20^15
+G1 X28.000 L20^3 L25^17
+G1 X30.000 L25^17 L20^3
+G1 X32.000 L20^15 L0^5
+G1 X34.000 L0^20
+G1 X36.000 L0^20
+G0 X36.000 Y27.800
+G1 X34.000 F1200 L0^20
+G1 X32.000 L0^20
+G1 X30.000 L0^15 L20^5
+G1 X28.000 L20^20
+G1 X26.000 L20^20
+G1 X24.000 L20^5 L0^15
+G1 X22.000 L0^20
+G1 X20.000 L0^20
+G0 X20.000 Y28.000
+G1 X22.000 F1200 L0^20
+G1 X24.000 L0^20
+G1 X26.000 L0^20
+G1 X28.000 L0^20
+G1 X30.000 L0^20
+G1 X32.000 L0^20
+G1 X34.000 L0^20
+G1 X36.000 L0^20
+G0 X0 Y0 F3000
@@ -0,0 +1,106 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Firmware running on a pc. Takes the place of the sketch file: setup() and loop()
+  are the same, the command line sets the simulated port, noise and head.
+*/
+
+#include "Repetier.h"
+#include "host.h"
+
+#include <getopt.h>
+#include <stdio.h>
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: boxzy-sim [options]\n"
+            "  -l, --link PATH    symlink to the pseudo terminal, e.g. /tmp/boxzy\n"
+            "  -b, --baud N       baud rate instead of the firmware setting\n"
+            "  -H, --head TYPE    laser, mill or printer (default laser)\n"
+            "  -s, --speed F      stepper speed, 1 real time (default), 0 no waiting\n"
+            "      --flip P       probability of a received byte with a flipped bit\n"
+            "      --frame P      probability of a received garbage byte with a frame error\n"
+            "      --drop P       probability of a received byte that is lost\n"
+            "      --seed N       seed for the noise\n"
+            "      --overrun      bytes received while the interrupts are forbidden for more than\n"
+            "                     two byte times are lost, needs a cpu core for each thread\n");
+    exit(1);
+}
+
+int main(int argc,char **argv)
+{
+    static const struct option options[] =
+    {
+        {"link",required_argument,0,'l'},
+        {"baud",required_argument,0,'b'},
+        {"head",required_argument,0,'H'},
+        {"speed",required_argument,0,'s'},
+        {"flip",required_argument,0,1},
+        {"frame",required_argument,0,2},
+        {"drop",required_argument,0,3},
+        {"seed",required_argument,0,4},
+        {"overrun",no_argument,0,5},
+        {0,0,0,0}
+    };
+    BoXZY_head_t head = BoXZY_Laser_head;
+    int opt;
+    while((opt = getopt_long(argc,argv,"l:b:H:s:",options,NULL)) != -1)
+    {
+        switch(opt)
+        {
+        case 'l':
+            HostConfig::link = optarg;
+            break;
+        case 'b':
+            HostConfig::baud = atol(optarg);
+            break;
+        case 'H':
+            if(!strcmp(optarg,"laser")) head = BoXZY_Laser_head;
+            else if(!strcmp(optarg,"mill")) head = BoXZY_CnC_head;
+            else if(!strcmp(optarg,"printer")) head = BoXZY_3D_Printer_head;
+            else usage();
+            break;
+        case 's':
+            HostConfig::speed = atof(optarg);
+            break;
+        case 1:
+            HostConfig::noiseFlip = atof(optarg);
+            break;
+        case 2:
+            HostConfig::noiseFrame = atof(optarg);
+            break;
+        case 3:
+            HostConfig::noiseDrop = atof(optarg);
+            break;
+        case 4:
+            HostConfig::seed = strtoul(optarg,NULL,0);
+            break;
+        case 5:
+            HostConfig::overrun = true;
+            break;
+        default:
+            usage();
+        }
+    }
+    if(optind != argc) usage();
+    HostConfig::port = true;
+    if(!hostSetup(head))
+        fprintf(stderr,"head detection failed, head is %d\n",(int)Printer::BoXZY_head);
+    fprintf(stderr,"ready\n");
+    for(;;)
+        Commands::commandLoop();
+}
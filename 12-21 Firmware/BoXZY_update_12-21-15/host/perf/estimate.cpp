@@ -0,0 +1,58 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Time estimation (M111 S64) against the real time of the same job. The job has short
+  and long moves, direction changes, dwells and a z step per layer. The real run uses
+  the stepper timer in real time, so it takes as long as the job would on the machine.
+*/
+
+#include "hosttest.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/** Largest accepted difference of estimated and real time in percent. */
+#define ESTIMATE_TOLERANCE 5
+
+static const char *layer =
+    "G1 X10 Y10 F3000\n"
+    "G1 X25 Y10\nG1 X25 Y12\nG1 X10 Y12\nG1 X10 Y14\nG1 X25 Y14\n"
+    "G1 X26 Y15 F1200\nG1 X27 Y15\nG1 X28 Y16\nG1 X29 Y16\nG1 X30 Y17\n"
+    "G1 X20 Y30 F6000\n"
+    "G4 P150\n"
+    "G91\nG1 Z0.5 F300\nG90\n";
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    hostRun("G90\nG1 X10 Y10 Z5 F6000\n");
+    hostRun("M111 S70\n");
+    for(int i = 0; i < 3; i++)
+        hostRun(layer);
+    float estimated = Printer::estimatedTime;
+    hostRun("M111 S6\n");
+    hostOutput();
+
+    HostConfig::speed = 1;
+    millis_t start = HAL::timeInMilliseconds();
+    for(int i = 0; i < 3; i++)
+        hostRun(layer);
+    float real = (HAL::timeInMilliseconds() - start) * 0.001f;
+    float difference = 100.0f * (estimated - real) / real;
+    hostExpect(fabs(difference) <= ESTIMATE_TOLERANCE,"estimated %.2f s, real %.2f s, %+.1f %%",
+               estimated,real,difference);
+    return hostResult();
+}
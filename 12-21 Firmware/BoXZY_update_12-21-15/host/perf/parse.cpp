@@ -0,0 +1,307 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Lines per second of GCode::parseAscii against the parser it replaced, which searched
+  the line with strchr once per parameter letter and converted values with strtod/strtol.
+  The old parser is copied below without the string and subprogram branches, the lines
+  measured have none. It fills a copy of the GCode fields, as those are private.
+  Both parsers must give the same parameters for every line.
+*/
+
+#include "hosttest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+static const char *lines[] =
+{
+    "G1 X12.345 Y67.890 F1800",
+    "G1 X12.845 Y67.990 E0.12345",
+    "G0 X100 Y100 Z5 F6000",
+    "G1 Z-0.25 F300",
+    "G2 X20.5 Y30.25 I5.125 J-2.5 F900",
+    "G1 X10.5 L10 L20 L30 L40 L50 L60 L70 L80",
+    "G1 X11.25 L0^12 L100^4 L55.5",
+    "M106 S255",
+    "M104 S210 T0",
+    "G4 P250",
+    "G28 X0 Y0",
+    "G92 E0",
+};
+#define LINES (sizeof(lines) / sizeof(lines[0]))
+
+/** Lines as a host sends them, with line number and checksum. */
+static char sent[LINES][96];
+
+/** The GCode fields the old parser sets. */
+struct OldCommand
+{
+    unsigned int params,params2;
+    uint16_t N,M,G;
+    float X,Y,Z,E,F,I,J,R,Q;
+    uint8_t T;
+    int32_t S,P;
+    void setFormatError()
+    {
+        params2 |= 32768;
+    }
+    bool hasFormatError()
+    {
+        return (params2 & 32768) != 0;
+    }
+};
+
+static uint32_t oldLineNumber;
+
+static float oldFloat(OldCommand &g,char *s)
+{
+    char *endPtr;
+    float f = strtod(s,&endPtr);
+    if(s == endPtr) g.setFormatError();
+    return f;
+}
+
+static float oldFloat(OldCommand &g,char **s)
+{
+    char *endPtr;
+    float f = strtod(*s,&endPtr);
+    if(*s == endPtr) g.setFormatError();
+    *s = endPtr;
+    return f;
+}
+
+static long oldLong(OldCommand &g,char *s)
+{
+    char *endPtr;
+    long l = strtol(s,&endPtr,10);
+    if(s == endPtr) g.setFormatError();
+    return l;
+}
+
+static long oldLong(OldCommand &g,char **s)
+{
+    char *endPtr;
+    long l = strtol(*s,&endPtr,10);
+    if(*s == endPtr) g.setFormatError();
+    *s = endPtr;
+    return l;
+}
+
+/** \brief GCode::parseAscii before the single pass parser. */
+static bool oldParseAscii(OldCommand &g,char *line)
+{
+    char *pos;
+    g.params = 0;
+    g.params2 = 0;
+
+    BoXZYLBuffer.write_index = BoXZYLBuffer.committed_index;
+
+    if((pos = strchr(line,'N'))!=0)
+    {
+        oldLineNumber = oldLong(g,++pos);
+        g.params |=1;
+        g.N = oldLineNumber & 0xffff;
+    }
+    if((pos = strchr(line,'M'))!=0)
+    {
+        g.M = oldLong(g,++pos) & 0xffff;
+        g.params |= 2;
+        if(g.M>255) g.params |= 4096;
+    }
+    if((pos = strchr(line,'G'))!=0)
+    {
+        g.G = oldLong(g,++pos) & 0xffff;
+        g.params |= 4;
+        if(g.G>255) g.params |= 4096;
+    }
+    if((pos = strchr(line,'X'))!=0)
+    {
+        g.X = oldFloat(g,++pos);
+        g.params |= 8;
+    }
+    if((pos = strchr(line,'Y'))!=0)
+    {
+        g.Y = oldFloat(g,++pos);
+        g.params |= 16;
+    }
+    if((pos = strchr(line,'Z'))!=0)
+    {
+        g.Z = oldFloat(g,++pos);
+        g.params |= 32;
+    }
+    if((pos = strchr(line,'E'))!=0)
+    {
+        g.E = oldFloat(g,++pos);
+        g.params |= 64;
+    }
+    if((pos = strchr(line,'F'))!=0)
+    {
+        g.F = oldFloat(g,++pos);
+        g.params |= 256;
+    }
+    if((pos = strchr(line,'T'))!=0)
+    {
+        g.T = oldLong(g,++pos) & 0xff;
+        g.params |= 512;
+    }
+    if((pos = strchr(line,'S'))!=0)
+    {
+        g.S = oldLong(g,++pos);
+        g.params |= 1024;
+    }
+    if((pos = strchr(line,'P'))!=0)
+    {
+        g.P = oldLong(g,++pos);
+        g.params |= 2048;
+    }
+    if((pos = strchr(line,'I'))!=0)
+    {
+        g.I = oldFloat(g,++pos);
+        g.params2 |= 1;
+        g.params |= 4096;
+    }
+    if((pos = strchr(line,'J'))!=0)
+    {
+        g.J = oldFloat(g,++pos);
+        g.params2 |= 2;
+        g.params |= 4096;
+    }
+    if((pos = strchr(line,'R'))!=0)
+    {
+        g.R = oldFloat(g,++pos);
+        g.params2 |= 4;
+        g.params |= 4096;
+    }
+#if FEATURE_CANNED_CYCLES
+    if((pos = strchr(line,'Q'))!=0)
+    {
+        g.Q = oldFloat(g,++pos);
+        g.params2 |= 8;
+        g.params |= 4096;
+    }
+#endif
+    if((pos = strchr(line,'L'))!=0 && Printer::BoXZY_head == BoXZY_Laser_head)
+    {
+        g.params2 |= 8192;
+        g.params |= 4096;
+        do
+        {
+            ++pos;
+            float pct = oldFloat(g,&pos);
+            long count = 1;
+            if(*pos == '^')
+            {
+                ++pos;
+                count = oldLong(g,&pos);
+            }
+            uint8_t power = laser_pct_to_power(pct);
+            while(count > 0)
+            {
+                BoXZYLBuffer.append_power(power);
+                --count;
+            }
+            if(!g.hasFormatError())
+                pos = strchr(pos,'L');
+        }
+        while(!g.hasFormatError() && (pos != 0));
+    }
+    if((pos = strchr(line,'*'))!=0)
+    {
+        uint8_t checksum_given = oldLong(g,pos+1);
+        uint8_t checksum = 0;
+        while(line!=pos) checksum ^= *line++;
+        if(checksum!=checksum_given)
+            return false;
+    }
+    return !g.hasFormatError() && ((g.params & 518) || (g.params2 & 8192));
+}
+
+static bool same(float a,float b)
+{
+    return fabs(a - b) <= 1e-5f * RMath::max(1.0f,fabsf(a));
+}
+
+/** \brief Compares the parameters both parsers found in a line. */
+static bool sameCommand(OldCommand &a,GCode &b)
+{
+    return (a.params & 1) == b.hasN() && ((a.params & 2) != 0) == b.hasM() && ((a.params & 4) != 0) == b.hasG()
+           && ((a.params & 8) != 0) == b.hasX() && ((a.params & 16) != 0) == b.hasY() && ((a.params & 32) != 0) == b.hasZ()
+           && ((a.params & 64) != 0) == b.hasE() && ((a.params & 256) != 0) == b.hasF() && ((a.params & 512) != 0) == b.hasT()
+           && ((a.params & 1024) != 0) == b.hasS() && ((a.params & 2048) != 0) == b.hasP()
+           && ((a.params2 & 1) != 0) == b.hasI() && ((a.params2 & 2) != 0) == b.hasJ() && ((a.params2 & 8192) != 0) == b.hasL()
+           && (!b.hasN() || a.N == b.N) && (!b.hasM() || a.M == b.M) && (!b.hasG() || a.G == b.G)
+           && (!b.hasX() || same(a.X,b.X)) && (!b.hasY() || same(a.Y,b.Y)) && (!b.hasZ() || same(a.Z,b.Z))
+           && (!b.hasE() || same(a.E,b.E)) && (!b.hasF() || same(a.F,b.F)) && (!b.hasT() || a.T == b.T)
+           && (!b.hasS() || a.S == b.S) && (!b.hasP() || a.P == b.P)
+           && (!b.hasI() || same(a.I,b.I)) && (!b.hasJ() || same(a.J,b.J));
+}
+
+/** \brief Parses all lines rounds times. @returns lines per second. */
+template<bool old> static double measure(int rounds)
+{
+    char line[96];
+    OldCommand o;
+    GCode g;
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; r++)
+        for(unsigned i = 0; i < LINES; i++)
+        {
+            strcpy(line,sent[i]); // both parsers may change the line
+            if(old)
+                oldParseAscii(o,line);
+            else
+                g.parseAscii(line,true);
+        }
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    return rounds * LINES / seconds.count();
+}
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    for(unsigned i = 0; i < LINES; i++)
+    {
+        int len = snprintf(sent[i],sizeof(sent[i]),"N%u %s",i + 1000,lines[i]);
+        uint8_t checksum = 0;
+        for(int c = 0; c < len; c++)
+            checksum ^= sent[i][c];
+        snprintf(sent[i] + len,sizeof(sent[i]) - len,"*%u",(unsigned)checksum);
+    }
+    for(unsigned i = 0; i < LINES; i++)
+    {
+        char oldLine[96],newLine[96];
+        OldCommand oldCode;
+        GCode newCode;
+        strcpy(oldLine,sent[i]);
+        strcpy(newLine,sent[i]);
+        bool oldOk = oldParseAscii(oldCode,oldLine);
+        bool newOk = newCode.parseAscii(newLine,true);
+        if(!oldOk || !newOk || !sameCommand(oldCode,newCode))
+            hostExpect(false,"%s parsed differently",sent[i]);
+    }
+    // Best of alternating runs, other processes only slow a run down
+    double oldRate = 0,newRate = 0;
+    for(int run = 0; run < 10; run++)
+    {
+        oldRate = std::max(oldRate,measure<true>(20000));
+        newRate = std::max(newRate,measure<false>(20000));
+    }
+    hostExpect(true,"old parser %.0f lines/s, new parser %.0f lines/s, %.2f times faster",
+               oldRate,newRate,newRate / oldRate);
+    return hostResult();
+}
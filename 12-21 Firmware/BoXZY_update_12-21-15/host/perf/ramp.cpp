@@ -0,0 +1,44 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Cost of the stepper interrupt for moves that mostly accelerate and decelerate.
+  The Makefile runs it with ramps computed in the interrupt, with and without reuse
+  of the ramp interval (RAMP_INTERVAL_SHIFT). The interval lookups are what costs on
+  the AVR, HAL::CPUDivU2 needs about 50 cycles there.
+*/
+
+#include "hosttest.h"
+
+#include <stdio.h>
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    hostRun("G91\n");
+    hostStepperStats();
+    for(int i = 0; i < 20; i++)
+        hostRun("G1 X10 Y2 F2400\nG1 X-10 Y-2\nG1 X3 F1200\nG1 X-3\nG1 Z1 F300\nG1 Z-1\n");
+    HostStepperStats stats = hostStepperStats();
+    // The mean would be dominated by the few calls the thread was preempted in.
+    uint64_t count = 0;
+    int median = 0;
+    while(median < 1023 && (count += stats.cycles[median]) < stats.calls / 2)
+        median++;
+    printf("%lu interrupts, %lu interval lookups (%.1f per 100 interrupts), median %d cycles per interrupt\n",
+           (unsigned long)stats.calls,(unsigned long)stats.intervalLookups,
+           100.0 * stats.intervalLookups / stats.calls,median);
+    return 0;
+}
@@ -0,0 +1 @@
+/* The firmware includes pins_arduino.h from the Arduino core, the host needs no pin table. */
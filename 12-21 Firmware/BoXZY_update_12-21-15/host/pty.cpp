@@ -0,0 +1,82 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pty.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+static int master = -1;
+static int slave = -1; ///< Kept open, so the port stays usable while no host is connected
+
+const char *ptyOpen(const char *link)
+{
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) || unlockpt(master))
+    {
+        perror("posix_openpt");
+        exit(1);
+    }
+    const char *name = ptsname(master);
+    slave = open(name,O_RDWR | O_NOCTTY);
+    if(slave < 0)
+    {
+        perror(name);
+        exit(1);
+    }
+    struct termios tio;
+    tcgetattr(slave,&tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave,TCSANOW,&tio);
+    if(link)
+    {
+        unlink(link);
+        if(symlink(name,link))
+        {
+            perror(link);
+            exit(1);
+        }
+    }
+    return name;
+}
+
+int ptyRead(unsigned char *buf,int size,int timeoutMs)
+{
+    struct pollfd p = {master,POLLIN,0};
+    if(poll(&p,1,timeoutMs) <= 0 || !(p.revents & POLLIN)) return 0;
+    int n = read(master,buf,size);
+    return n > 0 ? n : 0;
+}
+
+void ptyWrite(const unsigned char *buf,int length)
+{
+    while(length > 0)
+    {
+        int n = write(master,buf,length);
+        if(n < 0)
+        {
+            perror("pty write");
+            return;
+        }
+        buf += n;
+        length -= n;
+    }
+}
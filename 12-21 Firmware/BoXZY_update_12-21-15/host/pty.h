@@ -0,0 +1,32 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Pseudo terminal of the host build. Kept apart from HAL.cpp, because termios.h has its
+  own speed_t.
+*/
+
+#ifndef PTY_H
+#define PTY_H
+
+/** \brief Opens the pseudo terminal in raw mode and returns the name of the port the host
+program opens. link is an optional symlink to it. Exits on errors. */
+const char *ptyOpen(const char *link);
+/** \brief Reads up to size received bytes, waits at most timeoutMs for the first one. */
+int ptyRead(unsigned char *buf,int size,int timeoutMs);
+/** \brief Sends the bytes, blocks while the pseudo terminal is full. */
+void ptyWrite(const unsigned char *buf,int length);
+
+#endif // PTY_H
@@ -0,0 +1,142 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Binary protocol V3 frames, see the Repetier-protocol page in gcode.cpp. Frames longer
+  than the receive buffer must be rejected from their header, and moves running past the
+  end of the payload must not be executed.
+*/
+
+#include "hosttest.h"
+
+#include <string>
+
+/** \brief V3 frame under construction. */
+struct Frame
+{
+    uint8_t data[300];
+    int length;
+    Frame()
+    {
+        data[0] = 128;        // bitfield 16384 | 128 without line number
+        data[1] = 16384 >> 8;
+        data[2] = data[3] = 0;
+        data[4] = 0;          // payload length
+        length = 5;
+    }
+    void byte(uint8_t b)
+    {
+        data[length++] = b;
+        data[4]++;
+    }
+    void varint(uint32_t v)
+    {
+        do
+        {
+            byte((v & 127) | (v > 127 ? 128 : 0));
+            v >>= 7;
+        }
+        while(v);
+    }
+    void delta(int32_t v)
+    {
+        varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+    }
+    /** \brief Appends the fletcher-16 checksum and sends the frame. */
+    void send()
+    {
+        unsigned int sum1 = 0,sum2 = 0;
+        for(int i = 0; i < length; i++)
+        {
+            sum1 = (sum1 + data[i]) % 255;
+            sum2 = (sum2 + sum1) % 255;
+        }
+        data[length++] = sum1;
+        data[length++] = sum2;
+        hostRunBytes(data,length);
+    }
+};
+
+/** \brief Sends the zeros a host sends after a resend request in binary mode. */
+static void resync()
+{
+    uint8_t zeros[32] = {0};
+    hostRunBytes(zeros,sizeof(zeros));
+}
+
+static void expectSteps(const char *what,long x,long y)
+{
+    long stepsX = hostTakeSteps(X_AXIS),stepsY = hostTakeSteps(Y_AXIS);
+    hostExpect(stepsX == x && stepsY == y,"%-36s X %ld/%ld Y %ld/%ld",what,stepsX,x,stepsY,y);
+}
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    hostRun("G90\nG1 X20 Y20 Z10 F6000\n");
+    hostTakeSteps(X_AXIS);
+    hostTakeSteps(Y_AXIS);
+    hostOutput();
+    int32_t x = lroundf(20 * Printer::axisStepsPerMM[X_AXIS]),y = lroundf(20 * Printer::axisStepsPerMM[Y_AXIS]);
+
+    Frame moves;
+    moves.byte(1 | 2 | 16 | 32 | 128); // absolute X Y with F
+    moves.delta(x + 160);
+    moves.delta(y);
+    moves.varint(1200);
+    moves.byte(1 | 2 | 32);            // relative X Y
+    moves.delta(160);
+    moves.delta(-320);
+    moves.send();
+    std::string out = hostOutput();
+    expectSteps("two moves",320,320);
+    hostExpect(out.find("Resend") == std::string::npos,"%-36s no resend","two moves");
+
+    Frame tooLong;
+    tooLong.data[4] = 250; // 7 + 250 wraps in a uint8_t
+    hostRunBytes(tooLong.data,5);
+    out = hostOutput();
+    hostExpect(out.find("Resend") != std::string::npos,"%-36s resend after the header","payload of 250 byte");
+    resync();
+
+    Frame cut;
+    cut.byte(1 | 32);                  // complete relative X move
+    cut.delta(160);
+    cut.byte(1 | 2 | 32);              // Y varint continues behind the payload
+    cut.delta(160);
+    cut.byte(0x81);
+    cut.send();
+    out = hostOutput();
+    expectSteps("varint running past the payload",160,0);
+    hostExpect(out.find("Format error") != std::string::npos,"%-36s format error","varint running past the payload");
+
+    Frame laser;
+    laser.byte(1 | 32 | 64);           // X move with more powers than sent
+    laser.delta(160);
+    laser.byte(40);
+    for(int i = 0; i < 10; i++)
+        laser.byte(100);
+    laser.send();
+    out = hostOutput();
+    expectSteps("laser powers past the payload",0,0);
+    hostExpect(out.find("Format error") != std::string::npos,"%-36s format error","laser powers past the payload");
+
+    Frame after;
+    after.byte(1 | 32);
+    after.delta(-320);
+    after.send();
+    expectSteps("frame after the errors",320,0);
+    return hostResult();
+}
@@ -0,0 +1,106 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hosttest.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+void hostStart(BoXZY_head_t head)
+{
+    HostConfig::speed = 0;
+    if(!hostSetup(head))
+    {
+        printf("FAIL head %d not detected\n%s",(int)head,hostOutput().c_str());
+        exit(1);
+    }
+    hostOutput();
+    for(uint8_t axis = 0; axis < 3; axis++)
+        hostTakeSteps(axis);
+}
+
+/** \brief Body of Commands::commandLoop(). */
+static void loopOnce()
+{
+    GCode::readFromSerial();
+    GCode *code = GCode::peekCurrentCommand();
+    if(code)
+    {
+#if FEATURE_SUBPROGRAMS
+        if(Subprograms::isRecording())
+            Subprograms::record(code);
+        else
+#endif
+            Commands::executeGCode(code);
+        code->popCurrentCommand();
+    }
+    Printer::defaultLoopActions();
+}
+
+void hostRun(const char *lines)
+{
+    hostRunBytes((const uint8_t *)lines,strlen(lines));
+}
+
+void hostRunBytes(const uint8_t *data,size_t length)
+{
+    const uint8_t *end = data + length;
+    while(data < end)
+    {
+        if(hostReceive(*data))
+            data++;
+        else
+            loopOnce();
+    }
+    while(HAL::serialByteAvailable())
+        loopOnce();
+    Commands::waitUntilEndOfAllBuffers();
+}
+
+long hostTakeSteps(uint8_t axis)
+{
+    static const uint8_t stepPins[3] = {X_STEP_PIN,Y_STEP_PIN,Z_STEP_PIN};
+    long steps;
+    BEGIN_INTERRUPT_PROTECTED
+    steps = hostPinRises[stepPins[axis]];
+    hostPinRises[stepPins[axis]] = 0;
+    END_INTERRUPT_PROTECTED
+    return steps;
+}
+
+void hostExpect(bool ok,const char *format,...)
+{
+    va_list args;
+    va_start(args,format);
+    printf(ok ? "ok   " : "FAIL ");
+    vprintf(format,args);
+    printf("\n");
+    va_end(args);
+    if(!ok) failures++;
+}
+
+int hostResult()
+{
+    if(failures)
+    {
+        printf("%d failed\n",failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Helpers of the host checks. Each check is a program that exits with 0 if all
+  expectations hold, see the Makefile for the firmware variants it runs against.
+*/
+
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include "Repetier.h"
+#include "host.h"
+
+/** \brief Sets up the firmware with the given head, the stepper runs without waiting.
+Exits the check if the head is not detected. */
+void hostStart(BoXZY_head_t head);
+/** \brief Sends the lines through the serial port and runs the main loop until all
+commands are executed and all moves are finished. Each line must end with a newline. */
+void hostRun(const char *lines);
+/** \brief Like hostRun for binary data. */
+void hostRunBytes(const uint8_t *data,size_t length);
+/** \brief Steps of an axis since the last call, counted on the step pin. */
+long hostTakeSteps(uint8_t axis);
+/** \brief Prints the expectation with ok or FAIL and counts failures. */
+void hostExpect(bool ok,const char *format,...) __attribute__((format(printf,2,3)));
+/** \brief Prints the number of failures. @returns the exit code of the check. */
+int hostResult();
+
+#endif // HOSTTEST_H
@@ -0,0 +1,96 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Fixed point height map interpolation against a float bilinear interpolation of the
+  same map. Positions cover the whole grid and the border cells meshCell extends beyond
+  it. Moves with the map active must end at the corrected height.
+*/
+
+#include "hosttest.h"
+
+#include <math.h>
+
+/** Largest allowed difference of the fixed point interpolation in um, without z step rounding. */
+#define MESH_TOLERANCE_UM 7.0f
+
+/** \brief Float bilinear interpolation of the height map in um at x,y in mm. */
+static float referenceUm(float x,float y)
+{
+    float cx = (x - MESH_MIN_X) * (MESH_GRID_X - 1) / (float)(MESH_MAX_X - MESH_MIN_X);
+    float cy = (y - MESH_MIN_Y) * (MESH_GRID_Y - 1) / (float)(MESH_MAX_Y - MESH_MIN_Y);
+    cx = RMath::max(0.0f,RMath::min(cx,(float)(MESH_GRID_X - 1)));
+    cy = RMath::max(0.0f,RMath::min(cy,(float)(MESH_GRID_Y - 1)));
+    int ix = RMath::min((int)cx,MESH_GRID_X - 2);
+    int iy = RMath::min((int)cy,MESH_GRID_Y - 2);
+    float fx = cx - ix,fy = cy - iy;
+    float h0 = Printer::meshHeight[iy][ix] * (1 - fx) + Printer::meshHeight[iy][ix + 1] * fx;
+    float h1 = Printer::meshHeight[iy + 1][ix] * (1 - fx) + Printer::meshHeight[iy + 1][ix + 1] * fx;
+    return h0 * (1 - fy) + h1 * fy;
+}
+
+/** \brief Moves to x,y at z 2 mm, the z position in steps must include the interpolated height. */
+static void meshMove(float x,float y)
+{
+    char line[40];
+    snprintf(line,sizeof(line),"G1 X%.2f Y%.2f Z2 F6000\n",x,y);
+    hostRun(line);
+    float expected = 2 * Printer::axisStepsPerMM[Z_AXIS] + referenceUm(x,y) * 0.001f * Printer::axisStepsPerMM[Z_AXIS];
+    long z = Printer::currentPositionSteps[Z_AXIS];
+    hostExpect(fabs(z - expected) <= 1.0f + MESH_TOLERANCE_UM * 0.001f * Printer::axisStepsPerMM[Z_AXIS],
+               "%-30.*s Z %ld/%.1f steps",(int)strcspn(line,"\n"),line,z,expected);
+}
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    // Uneven map of +/-0.5 mm
+    char line[40];
+    for(int y = 0; y < MESH_GRID_Y; y++)
+        for(int x = 0; x < MESH_GRID_X; x++)
+        {
+            snprintf(line,sizeof(line),"M421 I%d J%d Z%.3f\n",x,y,((x * 7 + y * 13) % 11 - 5) * 0.1f);
+            hostRun(line);
+        }
+
+    // 0.37 mm raster from 10 mm before the first to 10 mm behind the last grid line
+    float stepUm = 1000.0f * Printer::invAxisStepsPerMM[Z_AXIS];
+    float maxError = 0;
+    int32_t failed = 0,points = 0;
+    for(float y = MESH_MIN_Y - 10; y <= MESH_MAX_Y + 10; y += 0.37f)
+        for(float x = MESH_MIN_X - 10; x <= MESH_MAX_X + 10; x += 0.37f)
+        {
+            int32_t sx = lroundf(x * Printer::axisStepsPerMM[X_AXIS]);
+            int32_t sy = lroundf(y * Printer::axisStepsPerMM[Y_AXIS]);
+            float um = Printer::meshCorrectionSteps(sx,sy) * stepUm;
+            float error = fabs(um - referenceUm(sx * Printer::invAxisStepsPerMM[X_AXIS],sy * Printer::invAxisStepsPerMM[Y_AXIS]));
+            maxError = RMath::max(maxError,error);
+            if(error > MESH_TOLERANCE_UM + stepUm * 0.5f)
+                failed++;
+            points++;
+        }
+    hostExpect(failed == 0,"meshCorrectionSteps %d points, %d off, max error %.2f um (%.2f um per z step)",
+               (int)points,(int)failed,maxError,stepUm);
+
+    hostRun("G90\nG1 X20 Y20 Z2 F6000\nM420 S1\n");
+    meshMove(20,20);
+    meshMove(150,140);           // crosses three grid lines in x and y
+    meshMove(0,165);             // corners of the map
+    meshMove(165,0);
+    meshMove(82.5,82.5);         // grid point
+    meshMove(41.25,123.75);
+    hostRun("M420 S0\nG1 X20 Y20 Z10\n");
+    return hostResult();
+}
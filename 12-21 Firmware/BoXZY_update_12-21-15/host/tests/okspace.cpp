@@ -0,0 +1,102 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Free space reported in ok after M407 S1. A host may send as many commands as B says
+  without waiting, so the command queue must take at least that many of any size. The
+  queue is walked through many fill states with short and long commands, also with the
+  free space split between the end and the start of the ring.
+*/
+
+#include "hosttest.h"
+
+#include <string>
+
+static const char *shortLine = "G4\n";
+static const char *longLine = "G1 X1.5 Y2.5 Z3.5 E4.5 F500 T0 S6 P7 I8.5 J9.5 R1.5\n";
+
+/** \brief Receives a line without executing anything. @returns true if the queue took it. */
+static bool receive(const char *line)
+{
+    while(*line)
+        if(!hostReceive(*line++)) return false;
+    GCode::readFromSerial();
+    std::string out = hostOutput();
+    return out.find("ok") != std::string::npos;
+}
+
+/** \brief Removes the oldest queued command without executing it. @returns false if the queue is empty. */
+static bool drop()
+{
+    GCode *code = GCode::peekCurrentCommand();
+    if(!code) return false;
+    code->popCurrentCommand();
+    return true;
+}
+
+/** \brief Drops commands until the queue took the line it refused before. */
+static void dropUntilTaken()
+{
+    do
+    {
+        drop();
+        GCode::readFromSerial();
+    }
+    while(hostOutput().find("ok") == std::string::npos);
+}
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    hostRun("M407 S1\n");
+    hostOutput();
+    hostRun("G4 P0\n");
+    std::string out = hostOutput();
+    size_t b = out.find(" B");
+    int reported = (b == std::string::npos ? -1 : atoi(out.c_str() + b + 2));
+    hostExpect(out.find(" P") != std::string::npos && out.find(" R") != std::string::npos && out.find(" L") != std::string::npos
+               && reported == GCode::freeQueueSlots(),"ok reports P, B, R and L: %s",out.substr(0,out.find('\n')).c_str());
+
+    unsigned seed = 1;
+    int states = 0,unsafe = 0;
+    for(int step = 0; step < 2000; step++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint8_t action = (seed >> 16) % 4;
+        if(action == 0)
+        {
+            // The host sends as many long lines as reported, all must be taken
+            int slots = GCode::freeQueueSlots();
+            int taken = 0;
+            while(taken < slots && receive(longLine))
+                taken++;
+            if(taken < slots)
+            {
+                unsafe++;
+                dropUntilTaken(); // get the refused line out of the receive buffer
+            }
+            states++;
+        }
+        else if(action == 1)
+            drop();
+        else if(!receive((seed >> 20) & 1 ? longLine : shortLine))
+            dropUntilTaken();
+    }
+    hostExpect(unsafe == 0,"%d fill states, queue took fewer long lines than reported in %d",states,unsafe);
+    while(drop()) {}
+    hostExpect(GCode::freeQueueSlots() > 0,"empty queue reports %d slots",(int)GCode::freeQueueSlots());
+    hostRun("M407 S0\n");
+    return hostResult();
+}
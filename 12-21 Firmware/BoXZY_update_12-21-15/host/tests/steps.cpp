@@ -0,0 +1,71 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Steps put out for relative moves. The Makefile runs this check with the step segments
+  and without them, so the segment replay must give the same steps as the ramp code of
+  the stepper interrupt. Slow moves are half stepped, fast ones use the step doubler.
+  The moves run in real time, otherwise the stepper starts each move before the segment
+  compiler had a look at it. A held endstop must stop its axis in every Bresenham loop.
+*/
+
+#include "hosttest.h"
+
+static void move(const char *gcode,float x,float y,float z)
+{
+    hostRun(gcode);
+    long expected[3] = {lroundf(x * Printer::axisStepsPerMM[X_AXIS]),
+                        lroundf(y * Printer::axisStepsPerMM[Y_AXIS]),
+                        lroundf(z * Printer::axisStepsPerMM[Z_AXIS])
+                       };
+    long steps[3];
+    for(uint8_t axis = 0; axis < 3; axis++)
+        steps[axis] = hostTakeSteps(axis);
+    hostExpect(steps[0] == expected[0] && steps[1] == expected[1] && steps[2] == expected[2],
+               "%-24.*s X %ld/%ld Y %ld/%ld Z %ld/%ld",(int)strcspn(gcode,"\n"),gcode,
+               steps[0],expected[0],steps[1],expected[1],steps[2],expected[2]);
+}
+
+/** \brief Runs a move toward the held x min endstop, x must not step while y moves on. */
+static void stoppedMove(const char *gcode,float y)
+{
+    hostRun(gcode);
+    long expectedY = lroundf(y * Printer::axisStepsPerMM[Y_AXIS]);
+    long stepsX = hostTakeSteps(X_AXIS),stepsY = hostTakeSteps(Y_AXIS);
+    hostTakeSteps(Z_AXIS);
+    hostExpect(stepsX <= 1 && stepsY == expectedY,"%-24.*s X-min held, X %ld/0 Y %ld/%ld",
+               (int)strcspn(gcode,"\n"),gcode,stepsX,stepsY,expectedY);
+}
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    hostRun("G90\nG1 X20 Y20 Z10 F6000\nG91\n");
+    HostConfig::speed = 1;
+    for(uint8_t axis = 0; axis < 3; axis++)
+        hostTakeSteps(axis);
+    move("G1 X5 F600\n",5,0,0);
+    move("G1 Z1 F100\n",0,0,1);
+    move("G1 X-5 Y3 F600\n",5,3,0);
+    move("G1 X30 Y10 F6000\n",30,10,0);
+    move("G1 X-30 Y-10 Z-1 F12000\n",30,10,1);
+    move("G1 X1 F3000\nG1 X1 Y1\nG1 Y-1\nG1 X-2 F600\n",4,2,0);
+    hostPinLevel[X_MIN_PIN] = (ENDSTOP_X_MIN_INVERTING ? LOW : HIGH);
+    stoppedMove("G1 X-5 Y5 F600\n",5);
+    stoppedMove("G1 X-5 Y-5 F2400\n",5);
+    stoppedMove("G1 X-1 Y1 Z0.5 F1200\n",1);
+    hostPinLevel[X_MIN_PIN] = (ENDSTOP_X_MIN_INVERTING ? HIGH : LOW);
+    return hostResult();
+}
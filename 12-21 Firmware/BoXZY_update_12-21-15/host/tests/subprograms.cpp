@@ -0,0 +1,53 @@
+/*
+    This file is part of Repetier-Firmware.
+
+    Repetier-Firmware is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Repetier-Firmware is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Repetier-Firmware.  If not, see <http://www.gnu.org/licenses/>.
+
+  Subprograms recorded with M97 and called with M98. Laser scan lines are not stored,
+  their power values must leave the laser ring while recording.
+*/
+
+#include "hosttest.h"
+
+/** \brief Expects the laser power ring to be empty after lines. */
+static void laserRingEmpty(const char *what)
+{
+    uint16_t used = (BoXZYLBuffer.write_index + COUNTOF(BoXZYLBuffer.elts) - BoXZYLBuffer.oldest_index) % COUNTOF(BoXZYLBuffer.elts);
+    hostExpect(used == 0,"%-40s %u power values left",what,(unsigned)used);
+}
+
+int main()
+{
+    hostStart(BoXZY_Laser_head);
+    hostRun("G90\nG1 X20 Y20 Z10 F6000\nG91\nM96 S1\n");
+    for(uint8_t axis = 0; axis < 3; axis++)
+        hostTakeSteps(axis);
+
+    hostRun("M97 Pscan\nG1 X1 F600\nG1 X1 L10 L20 L30 L40\nG1 Y1 L50 L60\nM99\n");
+    laserRingEmpty("recording scan lines");
+    long steps = hostTakeSteps(X_AXIS) + hostTakeSteps(Y_AXIS);
+    hostExpect(steps == 0,"%-40s %ld steps","recording does not move",steps);
+
+    hostRun("G1 X1 L10 L20 L30 L40\n");
+    laserRingEmpty("scan line after recording");
+    steps = hostTakeSteps(X_AXIS);
+    hostExpect(steps == lroundf(Printer::axisStepsPerMM[X_AXIS]),"%-40s X %ld steps","scan line after recording",steps);
+
+    hostRun("M98 Pscan\n");
+    long stepsX = hostTakeSteps(X_AXIS),stepsY = hostTakeSteps(Y_AXIS);
+    hostExpect(stepsX == lroundf(2 * Printer::axisStepsPerMM[X_AXIS]) && stepsY == lroundf(Printer::axisStepsPerMM[Y_AXIS]),
+               "%-40s X %ld Y %ld steps","M98 Pscan",stepsX,stepsY);
+    laserRingEmpty("M98 Pscan");
+    return hostResult();
+}
@@ -83,12 +83,38 @@ volatile int waitRelax = 0; // Delay filament relax at the end of print, could b
 
 PrintLine PrintLine::lines[MOVE_CACHE_SIZE]; ///< Cache for print moves.
 PrintLine *PrintLine::cur = 0;               ///< Current printing line
+StepParameter PrintLine::plannedParameter[MOVE_CACHE_SIZE]; ///< Step parameter computed, but not published by the planner
+uint16_t PrintLine::plannerRetries = 0;      ///< Plans dropped because the move was started meanwhile
+uint16_t PrintLine::blockedStalls = 0;       ///< Stepper interrupt calls that found the next move blocked
+#if FEATURE_QUEUE_CONTROL
+millis_t PrintLine::lastArrival = 0;         ///< Time the last move was queued
+uint16_t PrintLine::arrivalInterval = 65535; ///< Averaged time between queued moves in 1/16 ms
+uint16_t PrintLine::queueUnderruns = 0;      ///< Queue ran empty while moves were streamed
+uint16_t PrintLine::throttledMoves = 0;      ///< Moves slowed down to keep the queue filled
+#endif
+#if !NONLINEAR_SYSTEM
+void (*PrintLine::bresenhamLoopFunc)(uint8_t) = &PrintLine::bresenhamLoop<BRESENHAM_ANY>; ///< Step loop for the current line
+#endif
 #if CPU_ARCH==ARCH_ARM
 volatile bool PrintLine::nlFlag = false;
 #endif
 uint8_t PrintLine::linesWritePos = 0;            ///< Position where we write the next cached line move.
 volatile uint8_t PrintLine::linesCount = 0;      ///< Number of lines cached 0 = nothing to do.
 uint8_t PrintLine::linesPos = 0;                 ///< Position for executing line movement.
+#if FEATURE_STEP_SEGMENTS
+StepSegment PrintLine::segments[STEP_SEGMENT_CACHE_SIZE]; ///< Compiled step segments.
+volatile uint8_t PrintLine::segmentReadPos = 0;  ///< Next segment for the stepper interrupt.
+volatile uint8_t PrintLine::segmentWritePos = 0; ///< Next free segment for the compiler.
+uint16_t PrintLine::segmentStepsLeft = 0;        ///< Steps left in replayed segment.
+uint8_t PrintLine::segmentCompilePos = 0;        ///< Move the compiler works on.
+uint32_t PrintLine::segmentCompileStep = 0;      ///< First step of next segment to compile.
+#endif
+#if FEATURE_LIVE_OVERRIDES
+volatile speed_t PrintLine::overrideVMax = 0;    ///< Pending vMax for the printing move.
+speed_t PrintLine::overrideVEnd = 0;             ///< Pending end speed for the printing move.
+uint8_t PrintLine::overrideLinePos = 0;          ///< Move the pending override belongs to.
+speed_t PrintLine::overrideRampStart = 0;        ///< Start speed of running override ramp.
+#endif
 
 /**
 Move printer the given number of steps. Puts the move into the queue. Used by e.g. homing commands.
@@ -192,41 +218,10 @@ void PrintLine::queueCartesianMove(uint8_t check_endstops,uint8_t pathOptimize)
     Printer::filamentPrinted += axis_diff[E_AXIS];
     float xydist2;
 #if ENABLE_BACKLASH_COMPENSATION
-    if((p->isXYZMove()) && ((p->dir & 7)^(Printer::backlashDir & 7)) & (Printer::backlashDir >> 3))   // We need to compensate backlash, add a move
-    {
-        waitForXFreeLines(2);
-        uint8_t wpos2 = linesWritePos+1;
-        if(wpos2>=MOVE_CACHE_SIZE) wpos2 = 0;
-        PrintLine *p2 = &lines[wpos2];
-        memcpy(p2,p,sizeof(PrintLine)); // Move current data to p2
-        uint8_t changed = (p->dir & 7)^(Printer::backlashDir & 7);
-        float back_diff[4]; // Axis movement in mm
-        back_diff[E_AXIS] = 0;
-        back_diff[X_AXIS] = (changed & 1 ? (p->isXPositiveMove() ? Printer::backlashX : -Printer::backlashX) : 0);
-        back_diff[Y_AXIS] = (changed & 2 ? (p->isYPositiveMove() ? Printer::backlashY : -Printer::backlashY) : 0);
-        back_diff[Z_AXIS] = (changed & 4 ? (p->isZPositiveMove() ? Printer::backlashZ : -Printer::backlashZ) : 0);
-        p->dir &=7; // x,y and z are already correct
-        for(uint8_t i=0; i < 4; i++)
-        {
-            float f = back_diff[i]*Printer::axisStepsPerMM[i];
-            p->delta[i] = abs((long)f);
-            if(p->delta[i]) p->dir |= 16<<i;
-        }
-        //Define variables that are needed for the Bresenham algorithm. Please note that  Z is not currently included in the Bresenham algorithm.
-        if(p->delta[Y_AXIS] > p->delta[X_AXIS] && p->delta[Y_AXIS] > p->delta[Z_AXIS]) p->primaryAxis = Y_AXIS;
-        else if (p->delta[X_AXIS] > p->delta[Z_AXIS] ) p->primaryAxis = X_AXIS;
-        else p->primaryAxis = Z_AXIS;
-        p->stepsRemaining = p->delta[p->primaryAxis];
-        //Feedrate calc based on XYZ travel distance
-        xydist2 = back_diff[X_AXIS] * back_diff[X_AXIS] + back_diff[Y_AXIS] * back_diff[Y_AXIS];
-        if(p->isZMove())
-            p->distance = sqrt(xydist2 + back_diff[Z_AXIS] * back_diff[Z_AXIS]);
-        else
-            p->distance = sqrt(xydist2);
-        Printer::backlashDir = (Printer::backlashDir & 56) | (p2->dir & 7);
-        p->calculateMove(back_diff,pathOptimize);
-        p = p2; // use saved instance for the real move
-    }
+    // Axes reversing their direction take up the backlash with extra steps while this move runs
+    uint8_t movingAxes = (p->dir >> 4) & 7;
+    p->backlashAxes = (p->dir ^ Printer::backlashDir) & movingAxes & (Printer::backlashDir >> 3);
+    Printer::backlashDir = (Printer::backlashDir & ~movingAxes) | (p->dir & movingAxes);
 #endif
 
     //Define variables that are needed for the Bresenham algorithm. Please note that  Z is not currently included in the Bresenham algorithm.
@@ -248,6 +243,57 @@ void PrintLine::queueCartesianMove(uint8_t check_endstops,uint8_t pathOptimize)
         p->distance = fabs(axis_diff[E_AXIS]);
     p->calculateMove(axis_diff,pathOptimize);
 }
+
+#if FEATURE_MESH_LEVELING
+/**
+  Queues a move to the destination coordinates with the bed height map applied.
+  Printer::destinationSteps hold the target without height correction. The move is split
+  where it crosses grid lines, so between the pieces z follows the interpolated height exactly.
+  Moves with laser power data are only corrected at the end, their power values belong to one move.
+*/
+void PrintLine::queueMeshMove(uint8_t check_endstops,uint8_t pathOptimize)
+{
+    int32_t start[4],target[4];
+    for(uint8_t i = 0; i < 4; i++)
+    {
+        start[i] = Printer::currentPositionSteps[i];
+        target[i] = Printer::destinationSteps[i];
+    }
+    start[Z_AXIS] -= Printer::meshCorrectionSteps(start[X_AXIS],start[Y_AXIS]);
+    if(!Printer::has_L)
+    {
+        uint16_t fraction;
+        int32_t dx = target[X_AXIS] - start[X_AXIS];
+        int32_t dy = target[Y_AXIS] - start[Y_AXIS];
+        uint8_t cellX = Printer::meshCell(start[X_AXIS] - Printer::meshMinSteps[X_AXIS],X_AXIS,fraction);
+        uint8_t cellY = Printer::meshCell(start[Y_AXIS] - Printer::meshMinSteps[Y_AXIS],Y_AXIS,fraction);
+        uint8_t endX = Printer::meshCell(target[X_AXIS] - Printer::meshMinSteps[X_AXIS],X_AXIS,fraction);
+        uint8_t endY = Printer::meshCell(target[Y_AXIS] - Printer::meshMinSteps[Y_AXIS],Y_AXIS,fraction);
+        while(cellX != endX || cellY != endY)
+        {
+            // Part of the move until the next x and y grid line
+            float tx = 2.0f,ty = 2.0f;
+            if(cellX != endX)
+                tx = (float)(Printer::meshMinSteps[X_AXIS] + (int32_t)(cellX + (endX > cellX)) * Printer::meshSpacingSteps[X_AXIS] - start[X_AXIS]) / dx;
+            if(cellY != endY)
+                ty = (float)(Printer::meshMinSteps[Y_AXIS] + (int32_t)(cellY + (endY > cellY)) * Printer::meshSpacingSteps[Y_AXIS] - start[Y_AXIS]) / dy;
+            float t = RMath::min(tx,ty);
+            if(tx <= t)
+                cellX = (endX > cellX ? cellX + 1 : cellX - 1);
+            if(ty <= t)
+                cellY = (endY > cellY ? cellY + 1 : cellY - 1);
+            for(uint8_t i = 0; i < 4; i++)
+                Printer::destinationSteps[i] = start[i] + (int32_t)floor((float)(target[i] - start[i]) * t + 0.5f);
+            Printer::destinationSteps[Z_AXIS] += Printer::meshCorrectionSteps(Printer::destinationSteps[X_AXIS],Printer::destinationSteps[Y_AXIS]);
+            queueCartesianMove(check_endstops,pathOptimize);
+        }
+    }
+    for(uint8_t i = 0; i < 4; i++)
+        Printer::destinationSteps[i] = target[i];
+    Printer::destinationSteps[Z_AXIS] += Printer::meshCorrectionSteps(target[X_AXIS],target[Y_AXIS]);
+    queueCartesianMove(check_endstops,pathOptimize);
+}
+#endif // FEATURE_MESH_LEVELING
 #endif
 void PrintLine::calculateMove(float axis_diff[],uint8_t pathOptimize)
 {
@@ -258,6 +304,21 @@ void PrintLine::calculateMove(float axis_diff[],uint8_t pathOptimize)
 #endif
     float timeForMove = (float)(F_CPU)*distance / (isXOrYMove() ? RMath::max(Printer::minimumSpeed,Printer::feedrate): Printer::feedrate); // time is in ticks
     bool critical = Printer::isZProbingActive();
+#if FEATURE_QUEUE_CONTROL
+    updateArrivalRate();
+    if(linesCount < MOVE_CACHE_LOW && timeForMove < LOW_TICKS_PER_MOVE)
+    {
+        // Slow down only as much as needed to bridge the time until the next move arrives
+        float arrival = (float)arrivalInterval * (F_CPU / 16000.0);
+        float buffered = queuedTicks() + timeForMove;
+        if(buffered < arrival)
+        {
+            timeForMove = RMath::min(timeForMove + arrival - buffered,(float)LOW_TICKS_PER_MOVE);
+            throttledMoves++;
+            critical = true;
+        }
+    }
+#else
     if(linesCount < MOVE_CACHE_LOW && timeForMove < LOW_TICKS_PER_MOVE)   // Limit speed to keep cache full.
     {
         //OUT_P_I("L:",lines_count);
@@ -265,6 +326,7 @@ void PrintLine::calculateMove(float axis_diff[],uint8_t pathOptimize)
         //OUT_P_F_LN("Slow ",time_for_move);
         critical=true;
     }
+#endif
     timeInTicks = timeForMove;
     UI_MEDIUM; // do check encoder
     // Compute the solwest allowed interval (ticks/step), so maximum feedrate is not violated
@@ -470,84 +532,112 @@ The method is called before lines_count is increased!
 */
 void PrintLine::updateTrapezoids()
 {
-    uint8_t first = linesWritePos;
-    PrintLine *firstLine;
     PrintLine *act = &lines[linesWritePos];
-    BEGIN_INTERRUPT_PROTECTED;
-    uint8_t maxfirst = linesPos; // first non fixed segment
-    if(maxfirst != linesWritePos)
-        nextPlannerIndex(maxfirst); // don't touch the line printing
-    // Now ignore enough segments to gain enough time for path planning
-    uint32_t timeleft = 0;
-    // Skip as many stored moves as needed to gain enough time for computation
-    millis_t minTime = 4500L * RMath::min(MOVE_CACHE_SIZE,10);
-    while(timeleft < minTime && maxfirst != linesWritePos)
-    {
-        timeleft += lines[maxfirst].timeInTicks;
-        nextPlannerIndex(maxfirst);
-    }
-    // Search last fixed element
-    while(first != maxfirst && !lines[first].isEndSpeedFixed())
-        previousPlannerIndex(first);
-    if(first != linesWritePos && lines[first].isEndSpeedFixed())
-        nextPlannerIndex(first);
-    if(first == linesWritePos)   // Nothing to plan
+    while(true)
     {
-        act->block();
-        ESCAPE_INTERRUPT_PROTECTED
-        act->setStartSpeedFixed(true);
-        act->updateStepsParameter();
-        act->unblock();
-        return;
-    }
-    // now we have at least one additional move for optimization
-    // that is not a wait move
-    // First is now the new element or the first element with non fixed end speed.
-    // anyhow, the start speed of first is fixed
-    firstLine = &lines[first];
-    firstLine->block(); // don't let printer touch this or following segments during update
-    END_INTERRUPT_PROTECTED;
-    uint8_t previousIndex = linesWritePos;
-    previousPlannerIndex(previousIndex);
-    PrintLine *previous = &lines[previousIndex];
+        uint8_t first = linesWritePos;
+        BEGIN_INTERRUPT_PROTECTED;
+        uint8_t maxfirst = linesPos; // first non fixed segment
+        if(maxfirst != linesWritePos)
+            nextPlannerIndex(maxfirst); // don't touch the line printing
+        // Now ignore enough segments to gain enough time for path planning
+        uint32_t timeleft = 0;
+        // Skip as many stored moves as needed to gain enough time for computation
+        millis_t minTime = 4500L * RMath::min(MOVE_CACHE_SIZE,10);
+        while(timeleft < minTime && maxfirst != linesWritePos)
+        {
+            timeleft += lines[maxfirst].timeInTicks;
+            nextPlannerIndex(maxfirst);
+        }
+        // Search last fixed element
+        while(first != maxfirst && !lines[first].isEndSpeedFixed())
+            previousPlannerIndex(first);
+        if(first != linesWritePos && lines[first].isEndSpeedFixed())
+            nextPlannerIndex(first);
+        if(first == linesWritePos)   // Nothing to plan
+        {
+            ESCAPE_INTERRUPT_PROTECTED
+            act->setStartSpeedFixed(true);
+            act->updateStepsParameter();
+            return;
+        }
+        END_INTERRUPT_PROTECTED;
+        // now we have at least one additional move for optimization
+        // that is not a wait move
+        // First is now the new element or the first element with non fixed end speed.
+        // anyhow, the start speed of first is fixed.
+        // The stepper interrupt may start moves while we compute. It only reads the published
+        // step parameter and never touches speeds or joinFlags, new ones are computed into
+        // plannedParameter and published at the end.
+        uint8_t previousIndex = linesWritePos;
+        previousPlannerIndex(previousIndex);
+        PrintLine *previous = &lines[previousIndex];
 #if DRIVE_SYSTEM != 3
-    // filters z-move<->not z-move
-    if((previous->primaryAxis == Z_AXIS && act->primaryAxis != Z_AXIS) || (previous->primaryAxis != Z_AXIS && act->primaryAxis == Z_AXIS))
-    {
-        previous->setEndSpeedFixed(true);
-        act->setStartSpeedFixed(true);
-        act->updateStepsParameter();
-        firstLine->unblock();
-        return;
-    }
+        // filters z-move<->not z-move
+        if((previous->primaryAxis == Z_AXIS && act->primaryAxis != Z_AXIS) || (previous->primaryAxis != Z_AXIS && act->primaryAxis == Z_AXIS))
+        {
+            previous->setEndSpeedFixed(true);
+            act->setStartSpeedFixed(true);
+            act->updateStepsParameter();
+            return;
+        }
 #endif // DRIVE_SYSTEM
 
-    computeMaxJunctionSpeed(previous,act); // Set maximum junction speed if we have a real move before
-    if(previous->isEOnlyMove() != act->isEOnlyMove())
-    {
-        previous->setEndSpeedFixed(true);
-        act->setStartSpeedFixed(true);
+        if(previous->isEOnlyMove() != act->isEOnlyMove())
+        {
+            previous->setEndSpeedFixed(true);
+            act->setStartSpeedFixed(true);
+            act->updateStepsParameter();
+            return;
+        }
+        // Save the planner flags, so a dropped plan can be undone
+        uint8_t p = first;
+        while(p != linesWritePos)
+        {
+            plannedParameter[p].joinFlags = lines[p].joinFlags;
+            nextPlannerIndex(p);
+        }
+        computeMaxJunctionSpeed(previous,act); // Set maximum junction speed if we have a real move before
+        backwardPlanner(linesWritePos,first);
+        // Reduce speed to reachable speeds
+        forwardPlanner(first);
+
+        // Compute new step parameter without touching the published ones
+        p = first;
+        do
+        {
+            if(!lines[p].areParameterUpToDate() && !lines[p].isWarmUp())
+                lines[p].computeStepsParameter(plannedParameter[p]);
+            nextPlannerIndex(p);
+        }
+        while(p != linesWritePos);
         act->updateStepsParameter();
-        firstLine->unblock();
-        return;
-    }
-    backwardPlanner(linesWritePos,first);
-    // Reduce speed to reachable speeds
-    forwardPlanner(first);
-
-    // Update precomputed data
-    do
-    {
-        lines[first].updateStepsParameter();
-        BEGIN_INTERRUPT_PROTECTED;
-        lines[first].unblock();  // Flying block to release next used segment as early as possible
-        nextPlannerIndex(first);
-        lines[first].block();
-        END_INTERRUPT_PROTECTED;
+        // Publish all of them at once, unless the stepper interrupt started a move we changed
+        BEGIN_INTERRUPT_PROTECTED
+        uint8_t ahead = linesAhead(first);
+        if(ahead < linesCount && (ahead > 0 || cur == NULL))
+        {
+            p = first;
+            do
+            {
+                if(!lines[p].areParameterUpToDate() && !lines[p].isWarmUp())
+                    lines[p].publishStepsParameter(plannedParameter[p]);
+                nextPlannerIndex(p);
+            }
+            while(p != linesWritePos);
+            ESCAPE_INTERRUPT_PROTECTED
+            return;
+        }
+        END_INTERRUPT_PROTECTED
+        // Plan is void. Restore the planner state of the published moves and plan again without the started move.
+        plannerRetries++;
+        p = first;
+        while(p != linesWritePos)
+        {
+            lines[p].restorePlan(plannedParameter[p]);
+            nextPlannerIndex(p);
+        }
     }
-    while(first!=linesWritePos);
-    act->updateStepsParameter();
-    act->unblock();
 }
 
 inline void PrintLine::computeMaxJunctionSpeed(PrintLine *previous,PrintLine *current)
@@ -609,6 +699,40 @@ inline void PrintLine::computeMaxJunctionSpeed(PrintLine *previous,PrintLine *cu
 #endif // DEBUG_QUEUE_MOVE
 }
 
+#if FEATURE_TIME_ESTIMATION
+/** Adds the time the stepper interrupt would need for this move to the time estimation.
+
+The move is integrated from the same vStart, vEnd, vMax, accelSteps and decelSteps the stepper
+interrupt uses, so the result matches the real move except for timer rounding. A positive z move
+finishes the current layer.
+*/
+inline void PrintLine::addEstimatedTime()
+{
+    uint32_t steps = delta[primaryAxis];
+    float t;
+    if(accelerationPrim == 0)
+        t = (float)steps / (float)vMax;
+    else
+    {
+        float a = accelerationPrim;
+        float vAccel = RMath::min((float)vMax,sqrt((float)vStart * (float)vStart + 2.0f * a * (float)accelSteps));
+        float vDecel = RMath::min((float)vMax,sqrt((float)vEnd * (float)vEnd + 2.0f * a * (float)decelSteps));
+        t = (vAccel - (float)vStart + vDecel - (float)vEnd) / a;
+        if(steps > accelSteps + decelSteps)
+            t += (float)(steps - accelSteps - decelSteps) / (float)vMax;
+    }
+    if(isZMove() && isZPositiveMove() && Printer::estimatedLayerTime > 0)
+    {
+        Printer::estimatedLastLayerTime = Printer::estimatedLayerTime;
+        Printer::estimatedLayerTime = 0;
+        Printer::estimatedLayers++;
+        Printer::estimateLayerDone = 1;
+    }
+    Printer::estimatedTime += t;
+    Printer::estimatedLayerTime += t;
+}
+#endif
+
 /** Update parameter used by updateTrapezoids
 
 Computes the acceleration/decelleration steps and advanced parameter associated.
@@ -616,41 +740,48 @@ Computes the acceleration/decelleration steps and advanced parameter associated.
 void PrintLine::updateStepsParameter()
 {
     if(areParameterUpToDate() || isWarmUp()) return;
+    StepParameter p;
+    computeStepsParameter(p);
+    publishStepsParameter(p);
+}
+
+/** Computes the step parameter for the current start and end speed into p. */
+inline void PrintLine::computeStepsParameter(StepParameter &p)
+{
     float startFactor = startSpeed * invFullSpeed;
     float endFactor   = endSpeed   * invFullSpeed;
-    vStart = vMax * startFactor; //starting speed
-    vEnd   = vMax * endFactor;
+    p.vStart = vMax * startFactor; //starting speed
+    p.vEnd   = vMax * endFactor;
 #if CPU_ARCH == ARCH_AVR
     uint32_t vmax2 = HAL::U16SquaredToU32(vMax);
-    accelSteps = ((vmax2 - HAL::U16SquaredToU32(vStart)) / (accelerationPrim<<1)) + 1; // Always add 1 for missing precision
-    decelSteps = ((vmax2 - HAL::U16SquaredToU32(vEnd))  /(accelerationPrim<<1)) + 1;
+    p.accelSteps = ((vmax2 - HAL::U16SquaredToU32(p.vStart)) / (accelerationPrim<<1)) + 1; // Always add 1 for missing precision
+    p.decelSteps = ((vmax2 - HAL::U16SquaredToU32(p.vEnd))  /(accelerationPrim<<1)) + 1;
 #else
     uint64_t vmax2 = static_cast<uint64_t>(vMax) * static_cast<uint64_t>(vMax);
-    accelSteps = ((vmax2 - static_cast<uint64_t>(vStart) * static_cast<uint64_t>(vStart)) / (accelerationPrim<<1)) + 1; // Always add 1 for missing precision
-    decelSteps = ((vmax2 - static_cast<uint64_t>(vEnd) * static_cast<uint64_t>(vEnd))  /(accelerationPrim<<1)) + 1;
+    p.accelSteps = ((vmax2 - static_cast<uint64_t>(p.vStart) * static_cast<uint64_t>(p.vStart)) / (accelerationPrim<<1)) + 1; // Always add 1 for missing precision
+    p.decelSteps = ((vmax2 - static_cast<uint64_t>(p.vEnd) * static_cast<uint64_t>(p.vEnd))  /(accelerationPrim<<1)) + 1;
 #endif
 
 #ifdef USE_ADVANCE
 #ifdef ENABLE_QUADRATIC_ADVANCE
-    advanceStart = (float)advanceFull*startFactor * startFactor;
-    advanceEnd   = (float)advanceFull*endFactor   * endFactor;
+    p.advanceStart = (float)advanceFull*startFactor * startFactor;
+    p.advanceEnd   = (float)advanceFull*endFactor   * endFactor;
 #endif
 #endif
-    if(accelSteps+decelSteps >= stepsRemaining)   // can't reach limit speed
+    if(p.accelSteps+p.decelSteps >= stepsRemaining)   // can't reach limit speed
     {
-        uint16_t red = (accelSteps+decelSteps + 2 - stepsRemaining) >> 1;
-        accelSteps = accelSteps-RMath::min(accelSteps,red);
-        decelSteps = decelSteps-RMath::min(decelSteps,red);
+        uint16_t red = (p.accelSteps+p.decelSteps + 2 - stepsRemaining) >> 1;
+        p.accelSteps = p.accelSteps-RMath::min(p.accelSteps,red);
+        p.decelSteps = p.decelSteps-RMath::min(p.decelSteps,red);
     }
-    setParameterUpToDate();
 #ifdef DEBUG_QUEUE_MOVE
     if(Printer::debugEcho())
     {
         Com::printFLN(Com::tDBGId,(int)this);
-        Com::printF(Com::tDBGVStartEnd,(long)vStart);
-        Com::printFLN(Com::tSlash,(long)vEnd);
-        Com::printF(Com::tDBAccelSteps,(long)accelSteps);
-        Com::printF(Com::tSlash,(long)decelSteps);
+        Com::printF(Com::tDBGVStartEnd,(long)p.vStart);
+        Com::printFLN(Com::tSlash,(long)p.vEnd);
+        Com::printF(Com::tDBAccelSteps,(long)p.accelSteps);
+        Com::printF(Com::tSlash,(long)p.decelSteps);
         Com::printFLN(Com::tSlash,(long)stepsRemaining);
         Com::printF(Com::tDBGStartEndSpeed,startSpeed,1);
         Com::printFLN(Com::tSlash,endSpeed,1);
@@ -660,6 +791,33 @@ void PrintLine::updateStepsParameter()
 #endif
 }
 
+/** Makes step parameter computed with computeStepsParameter the ones used by the stepper interrupt. */
+inline void PrintLine::publishStepsParameter(StepParameter &p)
+{
+    vStart = p.vStart;
+    vEnd = p.vEnd;
+    accelSteps = p.accelSteps;
+    decelSteps = p.decelSteps;
+#ifdef USE_ADVANCE
+#ifdef ENABLE_QUADRATIC_ADVANCE
+    advanceStart = p.advanceStart;
+    advanceEnd = p.advanceEnd;
+#endif
+#endif
+    setParameterUpToDate();
+}
+
+/** Sets start and end speed back to the published step parameter and the planner flags to
+the ones saved in p after a plan was dropped. */
+inline void PrintLine::restorePlan(StepParameter &p)
+{
+    joinFlags = p.joinFlags;
+    if(isWarmUp()) return;
+    float factor = fullSpeed / vMax;
+    startSpeed = vStart * factor;
+    endSpeed = vEnd * factor;
+}
+
 /**
 Compute the maximum speed from the last entered move.
 The backwards planner traverses the moves from last to first looking at deceleration. The RHS of the accelerate/decelerate ramp.
@@ -825,12 +983,22 @@ processing.
 */
 uint8_t PrintLine::insertWaitMovesIfNeeded(uint8_t pathOptimize, uint8_t waitExtraLines)
 {
+#if FEATURE_QUEUE_CONTROL
+    if(linesCount == 0 && (millis_t)(HAL::timeInMilliseconds() - lastArrival) < QUEUE_UNDERRUN_TIME)
+        queueUnderruns++;
+#endif
     if(linesCount==0 && waitRelax==0 && pathOptimize)   // First line after some time - warmup needed
     {
 #if NONLINEAR_SYSTEM
         uint8_t w = 3;
+        long waitTicks = 50000;
 #else
         uint8_t w = 4;
+        long waitTicks = 25000;
+#endif // NONLINEAR_SYSTEM
+#if FEATURE_QUEUE_CONTROL
+        // Moves of a running stream arrive faster than the fixed wait, don't hold them back longer than needed
+        waitTicks = RMath::max(RMath::min((long)((float)arrivalInterval * (F_CPU / 16000.0)),waitTicks),(long)4000);
 #endif
         while(w--)
         {
@@ -840,17 +1008,41 @@ uint8_t PrintLine::insertWaitMovesIfNeeded(uint8_t pathOptimize, uint8_t waitExt
             p->joinFlags = FLAG_JOIN_STEPPARAMS_COMPUTED | FLAG_JOIN_END_FIXED | FLAG_JOIN_START_FIXED;
             p->dir = 0;
             p->setWaitForXLinesFilled(w + waitExtraLines);
-#if NONLINEAR_SYSTEM
-            p->setWaitTicks(50000);
-#else
-            p->setWaitTicks(25000);
-#endif // NONLINEAR_SYSTEM
+            p->setWaitTicks(waitTicks);
             pushLine();
         }
         return 1;
     }
     return 0;
 }
+#if FEATURE_QUEUE_CONTROL
+/** Updates the averaged time between two queued moves. Pauses longer than 4 s count as 4 s. */
+void PrintLine::updateArrivalRate()
+{
+    millis_t now = HAL::timeInMilliseconds();
+    uint32_t dt = now - lastArrival;
+    if(dt > 4000) dt = 4000;
+    lastArrival = now;
+    arrivalInterval = ((uint32_t)arrivalInterval * 7 + (dt << 4)) >> 3;
+}
+
+/** Returns the ticks the stepper interrupt needs for the queued moves, the printing one counts completely. */
+float PrintLine::queuedTicks()
+{
+    uint8_t pos,count;
+    BEGIN_INTERRUPT_PROTECTED
+    pos = linesPos;
+    count = linesCount;
+    END_INTERRUPT_PROTECTED
+    float ticks = 0;
+    while(count--)
+    {
+        ticks += lines[pos].timeInTicks;
+        nextPlannerIndex(pos);
+    }
+    return ticks;
+}
+#endif
 void PrintLine::logLine()
 {
 #ifdef DEBUG_QUEUE_MOVE
@@ -1263,6 +1455,9 @@ inline void PrintLine::queueEMove(long extrudeDiff,uint8_t check_endstops,uint8_
     uint8_t newPath = insertWaitMovesIfNeeded(pathOptimize, 1);
     PrintLine *p = getNextWriteLine();
     p->has_L = false;
+#if ENABLE_BACKLASH_COMPENSATION
+    p->backlashAxes = 0;
+#endif
     float axisDiff[5]; // Axis movement in mm
     if(check_endstops) p->flags = FLAG_CHECK_ENDSTOPS;
     else p->flags = 0;
@@ -1496,16 +1691,11 @@ void PrintLine::arc(float *position, float *target, float *offset, float radius,
     //   plan_set_acceleration_manager_enabled(false); // disable acceleration management for the duration of the arc
     float center_axis0 = position[0] + offset[0];
     float center_axis1 = position[1] + offset[1];
-    float linear_travel = 0; //target[axis_linear] - position[axis_linear];
     float extruder_travel = (Printer::destinationSteps[E_AXIS]-Printer::currentPositionSteps[E_AXIS])*Printer::invAxisStepsPerMM[E_AXIS];
     float r_axis0 = -offset[0];  // Radius vector from center to current location
     float r_axis1 = -offset[1];
     float rt_axis0 = target[0] - center_axis0;
     float rt_axis1 = target[1] - center_axis1;
-    long xtarget = Printer::destinationSteps[X_AXIS];
-    long ytarget = Printer::destinationSteps[Y_AXIS];
-    long ztarget = Printer::destinationSteps[Z_AXIS];
-    long etarget = Printer::destinationSteps[E_AXIS];
 
     // CCW angle between position and target from circle center. Only one atan2() trig computation required.
     float angular_travel = atan2(r_axis0*rt_axis1-r_axis1*rt_axis0, r_axis0*rt_axis0+r_axis1*rt_axis1);
@@ -1534,7 +1724,6 @@ void PrintLine::arc(float *position, float *target, float *offset, float radius,
       if (invert_feed_rate) { feed_rate *= segments; }
     */
     float theta_per_segment = angular_travel/segments;
-    float linear_per_segment = linear_travel/segments;
     float extruder_per_segment = extruder_travel/segments;
 
     /* Vector rotation by transformation matrix: r is the original vector, r_T is the rotated vector,
@@ -1650,6 +1839,7 @@ long PrintLine::bresenhamStep() // Version for delta printer
         setCurrentLine();
         if(cur->isBlocked())   // This step is in computation - shouldn't happen
         {
+            blockedStalls++;
             if(lastblk != (int)cur)
             {
                 HAL::allowInterrupts();
@@ -1700,7 +1890,6 @@ long PrintLine::bresenhamStep() // Version for delta printer
 #endif
 
         if(cur->isEMove()) Extruder::enable();
-        cur->fixStartAndEndSpeed();
         // Set up delta segments
         if (cur->numDeltaSegments)
         {
@@ -1732,11 +1921,6 @@ long PrintLine::bresenhamStep() // Version for delta printer
         }
         else curd = NULL;
         cur_errupd = (cur->isFullstepping() ? cur->stepsRemaining : cur->stepsRemaining << 1);
-
-        if(!cur->areParameterUpToDate())  // should never happen, but with bad timings???
-        {
-            cur->updateStepsParameter();
-        }
         Printer::vMaxReached = cur->vStart;
         Printer::stepNumber = 0;
         Printer::timer = 0;
@@ -1947,7 +2131,7 @@ long PrintLine::bresenhamStep() // Version for delta printer
                 Printer::vMaxReached = HAL::ComputeV(Printer::timer,cur->fAcceleration) + cur->vStart;
                 if(Printer::vMaxReached>cur->vMax) Printer::vMaxReached = cur->vMax;
                 speed_t v = Printer::updateStepsPerTimerCall(Printer::vMaxReached);
-                Printer::interval = HAL::CPUDivU2(v);
+                Printer::interval = Printer::rampInterval(v);
                 Printer::timer += Printer::interval;
                 cur->updateAdvanceSteps(Printer::vMaxReached,maxLoops,true);
             }
@@ -1963,7 +2147,7 @@ long PrintLine::bresenhamStep() // Version for delta printer
                 }
                 cur->updateAdvanceSteps(v,maxLoops,false);
                 v = Printer::updateStepsPerTimerCall(v);
-                Printer::interval = HAL::CPUDivU2(v);
+                Printer::interval = Printer::rampInterval(v);
                 Printer::timer += Printer::interval;
             }
             else
@@ -2047,14 +2231,673 @@ long PrintLine::bresenhamStep() // Version for delta printer
     return interval;
 }
 #else
+int lastblk=-1;
+long cur_errupd;
+
+#if FEATURE_STEP_SEGMENTS
+/**
+  Speed in steps/s the ramp of this move has at the given primary axis step.
+  Uses the same acceleration/deceleration boundaries as the stepper interrupt.
+*/
+inline float PrintLine::segmentSpeed(uint32_t step)
+{
+    uint32_t left = delta[primaryAxis] - step;
+    float v;
+    if(step <= accelSteps)
+        v = sqrt((float)vStart * (float)vStart + 2.0 * (float)accelerationPrim * (float)step);
+    else if(left <= decelSteps)
+        v = sqrt((float)vEnd * (float)vEnd + 2.0 * (float)accelerationPrim * (float)left);
+    else
+        v = vMax;
+    if(v > vMax) v = vMax;
+    if(v < 1) v = 1;
+    return v;
+}
+
+/**
+  Segment compiler. Called from the main loop, it splits the next moves into segments of
+  1/STEP_SEGMENTS_PER_SECOND seconds during acceleration/deceleration and one segment for the
+  plateau. A move is frozen (start and end speed fixed) before the first segment is computed,
+  so the path planner will not change it afterwards.
+*/
+void PrintLine::compileSegments()
+{
+    for(uint8_t n = 0; n < 4; n++) // Limit work per call
+    {
+        if(((segmentWritePos + 1) & (STEP_SEGMENT_CACHE_SIZE - 1)) == segmentReadPos) return; // Cache full
+        uint8_t count,ahead;
+        bool started;
+        BEGIN_INTERRUPT_PROTECTED
+        count = linesCount;
+        ahead = linesAhead(segmentCompilePos);
+        if(ahead >= count) // Move was already executed, continue with the printing move
+        {
+            segmentCompilePos = linesPos;
+            segmentCompileStep = 0;
+            ahead = 0;
+        }
+        started = (cur == &lines[segmentCompilePos]);
+        END_INTERRUPT_PROTECTED
+        if(count == 0) return;
+        PrintLine *p = &lines[segmentCompilePos];
+        if(segmentCompileStep == 0)
+        {
+            if(started || p->isWarmUp() || p->isNoMove() || p->delta[p->primaryAxis] == 0)
+            {
+                // Stepper interrupt already runs it or there is nothing to compile
+                if(ahead + 1 >= count) return;
+                nextPlannerIndex(segmentCompilePos);
+                continue;
+            }
+            if(ahead >= STEP_SEGMENT_LINES_AHEAD || p->isBlocked() || !p->areParameterUpToDate())
+                return;
+            p->fixStartAndEndSpeed(); // Planner must not change this move any more
+        }
+        uint32_t total = p->delta[p->primaryAxis];
+        uint32_t step = segmentCompileStep;
+        uint32_t left = total - step;
+        uint32_t decelStart = (total > p->decelSteps ? total - p->decelSteps : 0);
+        float v = p->segmentSpeed(step);
+        uint32_t events;
+        if(step > p->accelSteps && step < decelStart) // Plateau in one segment
+            events = decelStart - step;
+        else
+        {
+            events = (uint32_t)(v * (1.0 / STEP_SEGMENTS_PER_SECOND)) + 1;
+            if(step <= p->accelSteps && step + events > (uint32_t)p->accelSteps + 1)
+                events = p->accelSteps + 1 - step;
+        }
+        if(events > 60000) events = 60000;
+        float vSeg = p->segmentSpeed(step + (events >> 1));
+        uint8_t stepsPerCall = 1;
+        if(vSeg > STEP_DOUBLER_FREQUENCY && p->isFullstepping()) // Half stepping makes one step per two calls
+        {
+#if ALLOW_QUADSTEPPING
+            stepsPerCall = (vSeg > STEP_DOUBLER_FREQUENCY * 2 ? 4 : 2);
+#else
+            stepsPerCall = 2;
+#endif
+            events = (events + stepsPerCall - 1) & ~(uint32_t)(stepsPerCall - 1);
+        }
+        if(events > left) events = left;
+        StepSegment &seg = segments[segmentWritePos];
+        seg.linePos = segmentCompilePos;
+        seg.stepsPerCall = stepsPerCall;
+        seg.stepEvents = events;
+        seg.firstStep = step;
+        seg.interval = (ticks_t)((float)F_CPU * stepsPerCall / vSeg);
+        float vEndSeg = p->segmentSpeed(step + events);
+        seg.decelerating = (step + events > decelStart);
+        if(seg.decelerating)
+        {
+            seg.vRamp = p->segmentSpeed(decelStart);
+            seg.rampTimer = (ticks_t)(((float)seg.vRamp - vEndSeg) * F_CPU / p->accelerationPrim);
+        }
+        else
+        {
+            seg.vRamp = vEndSeg;
+            seg.rampTimer = (ticks_t)((vEndSeg - (float)p->vStart) * F_CPU / p->accelerationPrim);
+        }
+        BEGIN_INTERRUPT_PROTECTED
+        if(linesAhead(segmentCompilePos) < linesCount) // Publish only if move is still queued
+            segmentWritePos = (segmentWritePos + 1) & (STEP_SEGMENT_CACHE_SIZE - 1);
+        END_INTERRUPT_PROTECTED
+        segmentCompileStep += events;
+        if(segmentCompileStep >= total)
+        {
+            nextPlannerIndex(segmentCompilePos);
+            segmentCompileStep = 0;
+        }
+    }
+}
+
+/**
+  Stepper interrupt side of the segment cache. Drops outdated segments and loads the next
+  segment of the printing move if it continues exactly at the current step.
+  @returns true if a segment is loaded.
+*/
+inline bool PrintLine::nextSegment()
+{
+    while(segmentReadPos != segmentWritePos)
+    {
+        StepSegment &seg = segments[segmentReadPos];
+        uint8_t ahead = linesAhead(seg.linePos);
+        if(ahead > 0 && ahead < linesCount) return false; // Belongs to a following move
+        if(ahead == 0 && seg.firstStep == Printer::stepNumber
+#if FEATURE_REALTIME_COMMANDS
+                && Printer::feedHoldState == FEED_HOLD_NONE // Held moves use their own ramp
+#endif
+#if FEATURE_FAST_HOMING
+                && Printer::homingState != HOMING_STOPPING
+#endif
+#if FEATURE_LIVE_OVERRIDES
+                && !overrideRampStart && !overrideVMax
+#endif
+          )
+        {
+            segmentStepsLeft = seg.stepEvents;
+            Printer::stepsPerTimerCall = seg.stepsPerCall;
+            Printer::interval = seg.interval;
+            // Keep ramp state in sync in case we run out of segments
+            Printer::vMaxReached = seg.vRamp;
+            Printer::timer = seg.rampTimer;
+            if(seg.decelerating) cur->flags |= FLAG_DECELERATING;
+            segmentReadPos = (segmentReadPos + 1) & (STEP_SEGMENT_CACHE_SIZE - 1);
+            return true;
+        }
+        segmentReadPos = (segmentReadPos + 1) & (STEP_SEGMENT_CACHE_SIZE - 1); // Outdated
+    }
+    return false;
+}
+#endif // FEATURE_STEP_SEGMENTS
+
+#if FEATURE_REALTIME_COMMANDS
+/** Speed in steps/s this move can stop from or start with without violating jerk limits. */
+inline speed_t PrintLine::feedHoldSpeed()
+{
+    float v = (float)vMax * minSpeed * invFullSpeed;
+    if(v > vMax) v = vMax;
+    return (v < 10 ? 10 : (speed_t)v);
+}
+
+/**
+  Converts the rest of the current move into a deceleration ramp down to feedHoldSpeed.
+  Called from the stepper interrupt when a feed hold was requested.
+*/
+inline void PrintLine::startFeedHold()
+{
+#if FEATURE_STEP_SEGMENTS
+    segmentStepsLeft = 0; // Precomputed segments don't know about the hold
+#endif
+    speed_t v = (speed_t)RMath::min((long)vMax,(long)((F_CPU * Printer::stepsPerTimerCall) / Printer::interval));
+    Printer::feedHoldVEnd = vEnd;
+    vEnd = RMath::min((unsigned int)feedHoldSpeed(),(unsigned int)v);
+    Printer::vMaxReached = v;
+    accelSteps = 0;
+    flags &= ~FLAG_DECELERATING; // Restart deceleration timing from current speed
+    Printer::feedHoldState = FEED_HOLD_DECELERATING;
+}
+
+/** Hold speed is reached, stop stepping but keep the move. */
+inline void PrintLine::stopFeedHold()
+{
+    Printer::feedHoldState = FEED_HOLD_STOPPED;
+    if(Printer::BoXZY_head == BoXZY_Laser_head)
+    {
+        Printer::feedHoldLaserPower = get_laser();
+        set_laser(0);
+    }
+}
+
+/**
+  Restarts the current move after a feed hold from feedHoldSpeed. The remaining steps
+  get a new acceleration ramp, the planned deceleration at the end is kept.
+*/
+inline void PrintLine::resumeFeedHold()
+{
+    if(Printer::feedHoldVEnd)
+    {
+        vEnd = Printer::feedHoldVEnd;
+        Printer::feedHoldVEnd = 0;
+    }
+    vStart = RMath::min((unsigned int)vStart,(unsigned int)feedHoldSpeed());
+    long room = stepsRemaining - decelSteps;
+    uint32_t accel = (HAL::U16SquaredToU32(vMax) - HAL::U16SquaredToU32(vStart)) / (accelerationPrim << 1) + 1;
+    accelSteps = (room <= 0 ? 0 : RMath::min((long)accel,room));
+    Printer::stepNumber = 0;
+    Printer::timer = 0;
+    Printer::vMaxReached = vStart;
+    flags &= ~FLAG_DECELERATING;
+    Printer::interval = HAL::CPUDivU2(Printer::updateStepsPerTimerCall(vStart));
+    if(Printer::BoXZY_head == BoXZY_Laser_head && Printer::feedHoldLaserPower)
+    {
+        set_laser(Printer::feedHoldLaserPower);
+        Printer::feedHoldLaserPower = 0;
+    }
+    Printer::feedHoldState = FEED_HOLD_RESUMED;
+}
+#endif // FEATURE_REALTIME_COMMANDS
+
+#if FEATURE_FAST_HOMING
+/**
+  Endstop test for homing moves. A seek move decelerates when the first endstop triggers, a touch
+  move stops at once. Printer::homingStepsLeft gets the steps of the primary axis that are not done.
+*/
+void PrintLine::checkHomingEndstops()
+{
+    if(Printer::homingState == HOMING_STOPPING) return; // Ramp down through the switch
+    if(!((isXNegativeMove() && Printer::isXMinEndstopHit()) || (isXPositiveMove() && Printer::isXMaxEndstopHit())
+            || (isYNegativeMove() && Printer::isYMinEndstopHit()) || (isYPositiveMove() && Printer::isYMaxEndstopHit())
+            || (isZNegativeMove() && Printer::isZMinEndstopHit()) || (isZPositiveMove() && Printer::isZMaxEndstopHit())))
+        return;
+    if(Printer::homingState == HOMING_TOUCH)
+    {
+        Printer::homingStepsLeft = stepsRemaining;
+        dir &= ~112; // Stop all axes
+        Printer::homingState = HOMING_NONE;
+    }
+    else
+        startHomingStop();
+}
+
+/**
+  Shortens the seek move to the steps needed to stop from the current speed and decelerates over them.
+*/
+inline void PrintLine::startHomingStop()
+{
+#if FEATURE_STEP_SEGMENTS
+    segmentStepsLeft = 0; // Precomputed segments don't know about the stop
+#endif
+    speed_t v = (speed_t)RMath::min((long)vMax,(long)((F_CPU * Printer::stepsPerTimerCall) / Printer::interval));
+    long stop = HAL::U16SquaredToU32(v) / (accelerationPrim << 1) + 1;
+    if(stop < stepsRemaining)
+    {
+        Printer::homingStepsLeft = stepsRemaining - stop;
+        stepsRemaining = stop;
+    }
+    vEnd = RMath::min((unsigned int)vStart,(unsigned int)v);
+    decelSteps = RMath::min((long)stepsRemaining,65535L);
+    accelSteps = 0;
+    Printer::vMaxReached = v;
+    flags &= ~FLAG_DECELERATING; // Restart deceleration timing from current speed
+    Printer::homingState = HOMING_STOPPING;
+}
+#endif // FEATURE_FAST_HOMING
+
+#if FEATURE_LIVE_OVERRIDES
+/**
+  Rescales the moves in the cache after the feedrate multiplier changed by ratio. The printing move
+  gets a new target speed that the stepper interrupt ramps to, the waiting moves are replanned.
+*/
+void PrintLine::changeSpeedOverride(float ratio)
+{
+    if(ratio == 1.0) return;
+    PrintLine *act;
+    PrintLine *first = NULL;
+    uint8_t actPos,p,n;
+    BEGIN_INTERRUPT_PROTECTED
+#if FEATURE_STEP_SEGMENTS
+    resetSegments(); // Compiled with old speeds
+#endif
+    act = cur;
+    actPos = p = linesPos;
+    n = linesCount;
+    if(act != NULL && n)
+    {
+        nextPlannerIndex(p);
+        n--;
+    }
+    if(n)
+    {
+        first = &lines[p];
+        first->block(); // Stepper interrupt must not start a move we are rescaling
+    }
+    END_INTERRUPT_PROTECTED
+    if(act != NULL && !act->isWarmUp()
+#if FEATURE_REALTIME_COMMANDS
+            && !Printer::isFeedHold()
+#endif
+      )
+    {
+        float r = act->limitSpeedRatio(ratio);
+        float vt = RMath::min((float)act->vMax * r,(float)(F_CPU / LIMIT_INTERVAL));
+        speed_t vEnd = (r < 1.0 ? (speed_t)(act->vEnd * r) : act->vEnd);
+        BEGIN_INTERRUPT_PROTECTED
+        if(cur == act)
+        {
+            overrideLinePos = actPos;
+            overrideVEnd = vEnd;
+            overrideVMax = RMath::max(vt,10.0f);
+        }
+        END_INTERRUPT_PROTECTED
+    }
+    while(n--)
+    {
+        lines[p].scaleSpeed(ratio);
+        nextPlannerIndex(p);
+    }
+    if(first != NULL)
+        first->unblock();
+}
+
+/** Reduces ratio so the scaled move does not exceed the maximum feedrate of an axis. */
+inline float PrintLine::limitSpeedRatio(float ratio)
+{
+    if(ratio <= 1.0) return ratio;
+    if(isXMove()) ratio = RMath::min(ratio,(float)(Printer::maxFeedrate[X_AXIS] / fabs(speedX)));
+    if(isYMove()) ratio = RMath::min(ratio,(float)(Printer::maxFeedrate[Y_AXIS] / fabs(speedY)));
+    if(isZMove()) ratio = RMath::min(ratio,(float)(Printer::maxFeedrate[Z_AXIS] / fabs(speedZ)));
+    if(isEMove()) ratio = RMath::min(ratio,(float)(Printer::maxFeedrate[E_AXIS] / fabs(speedE)));
+    return RMath::max(ratio,1.0f);
+}
+
+/**
+  Scales the cruise speed of a waiting move. When slowing down start, end and junction speeds are
+  scaled too, which keeps all ramps and jerk limits valid. When speeding up they are kept, as higher
+  junction speeds would need a new path planning.
+*/
+inline void PrintLine::scaleSpeed(float ratio)
+{
+    if(isWarmUp()) return;
+    ratio = limitSpeedRatio(ratio);
+    if(ratio == 1.0) return;
+    fullSpeed *= ratio;
+    invFullSpeed = 1.0 / fullSpeed;
+    speedX *= ratio;
+    speedY *= ratio;
+    speedZ *= ratio;
+    speedE *= ratio;
+    timeInTicks /= ratio;
+    ticks_t interval = fullInterval / ratio;
+    fullInterval = (interval > LIMIT_INTERVAL ? interval : LIMIT_INTERVAL);
+    vMax = F_CPU / fullInterval;
+    minSpeed = RMath::min(minSpeed,fullSpeed);
+    if(ratio < 1.0)
+    {
+        startSpeed *= ratio;
+        endSpeed *= ratio;
+        maxJunctionSpeed *= ratio;
+    }
+    else if(startSpeed * startSpeed + accelerationDistance2 < fullSpeed * fullSpeed)
+        flags &= ~FLAG_NOMINAL;
+    if(fullInterval < MAX_HALFSTEP_INTERVAL && !isFullstepping())
+    {
+        halfStep = 4;
+        error[X_AXIS] = error[Y_AXIS] = error[Z_AXIS] = error[E_AXIS] = delta[primaryAxis] >> 1;
+    }
+#if defined(USE_ADVANCE) && defined(ENABLE_QUADRATIC_ADVANCE)
+    advanceFull *= ratio * ratio;
+#endif
+    invalidateParameter();
+    updateStepsParameter();
+}
+
+/**
+  Takes the override computed by changeSpeedOverride for the printing move. Called from the stepper
+  interrupt. The new speed is reached with the normal acceleration, see bresenhamStep.
+*/
+inline void PrintLine::applySpeedOverride()
+{
+    speed_t vt = overrideVMax;
+    if(this != &lines[overrideLinePos])
+    {
+        overrideVMax = 0; // Move is already finished
+        return;
+    }
+    if(Printer::stepNumber == 0) return; // Wait for first step so we know the speed
+    overrideVMax = 0;
+    if((flags & FLAG_DECELERATING) || stepsRemaining <= decelSteps)
+    {
+        if(overrideVEnd < vEnd) vEnd = overrideVEnd; // Already braking, just brake a bit more
+        return;
+    }
+    speed_t v0 = Printer::vMaxReached;
+    uint32_t twoA = accelerationPrim << 1;
+    uint32_t steps;
+    if(vt > v0)
+    {
+        uint32_t vt2 = HAL::U16SquaredToU32(vt);
+        steps = (vt2 - HAL::U16SquaredToU32(vEnd)) / twoA + 1;
+        if((vt2 - HAL::U16SquaredToU32(v0)) / twoA + steps >= (uint32_t)stepsRemaining)
+            return; // Too short to get faster and still brake in time
+    }
+    else
+    {
+        if(overrideVEnd < vEnd) vEnd = overrideVEnd;
+        steps = (HAL::U16SquaredToU32(v0) - HAL::U16SquaredToU32(vEnd)) / twoA + 1;
+        if(steps < decelSteps) steps = decelSteps;
+        if(steps > (uint32_t)stepsRemaining) steps = stepsRemaining;
+    }
+    decelSteps = steps;
+    vMax = vt;
+    fullInterval = F_CPU / vt;
+    accelSteps = 0;
+    if(vt != v0)
+    {
+        overrideRampStart = v0;
+        Printer::timer = 0;
+    }
+}
+#endif // FEATURE_LIVE_OVERRIDES
+
+#if FEATURE_BABYSTEPPING
+/**
+  Executes a pending Z babystep in a move with Z steps. Babysteps along the move add a step,
+  babysteps against it drop one, so the Z direction never changes inside a move.
+  Only called in loop iterations without a regular Z step.
+*/
+inline void PrintLine::zBabystepWithZMove()
+{
+    if((Printer::zBabystepsMissing > 0) == isZPositiveMove())
+        startZStep();
+    else
+        error[Z_AXIS] += cur_errupd;
+    if(Printer::zBabystepsMissing > 0)
+        Printer::zBabystepsMissing--;
+    else
+        Printer::zBabystepsMissing++;
+}
+
+/**
+  Executes a pending Z babystep in a move without Z steps. If the Z direction pin is wrong,
+  it is only changed and the step follows with the next timer call.
+*/
+inline void PrintLine::zBabystepWithoutZMove()
+{
+    bool up = Printer::zBabystepsMissing > 0;
+    if(Printer::getZDirection() != up)
+    {
+        Printer::setZDirection(up);
+        return;
+    }
+    Printer::enableZStepper();
+    startZStep();
+    if(up)
+        Printer::zBabystepsMissing--;
+    else
+        Printer::zBabystepsMissing++;
+}
+#endif
+
+/** Tests if an axis of the axes mask moves. The mask is constant for the specialized loops, so the
+compiler drops all code of axes not moving. The runtime test stays, a triggered endstop ends the
+move of a single axis. */
+#define BRESENHAM_MOVES(flag,test) ((axes & BRESENHAM_ANY) ? (test) : ((axes & (flag)) && (test)))
+
+/**
+  Executes max_loops Bresenham steps of the current move. axes is a mask of BRESENHAM_X..BRESENHAM_L
+  with the axes moving, or BRESENHAM_ANY to test them for every step.
+*/
+template<uint8_t axes> void PrintLine::bresenhamLoop(uint8_t max_loops)
+{
+    for(uint8_t loop=0; loop<max_loops; loop++)
+    {
+        ANALYZER_ON(ANALYZER_CH1);
+#if STEPPER_HIGH_DELAY+DOUBLE_STEP_DELAY > 0
+        if(loop>0)
+            HAL::delayMicroseconds(STEPPER_HIGH_DELAY+DOUBLE_STEP_DELAY);
+#endif
+        if(BRESENHAM_MOVES(BRESENHAM_E,cur->isEMove()))
+        {
+            if((cur->error[E_AXIS] -= cur->delta[E_AXIS]) < 0)
+            {
+#if defined(USE_ADVANCE)
+                if(Printer::isAdvanceActivated())   // Use interrupt for movement
+                {
+                    if(cur->isEPositiveMove())
+                        Printer::extruderStepsNeeded++;
+                    else
+                        Printer::extruderStepsNeeded--;
+                }
+                else
+#endif
+                    Extruder::step();
+                cur->error[E_AXIS] += cur_errupd;
+            }
+        }
+        if(BRESENHAM_MOVES(BRESENHAM_X,cur->isXMove()))
+        {
+            if((cur->error[X_AXIS] -= cur->delta[X_AXIS]) < 0)
+            {
+                cur->startXStep();
+                cur->error[X_AXIS] += cur_errupd;
+            }
+        }
+        if(BRESENHAM_MOVES(BRESENHAM_Y,cur->isYMove()))
+        {
+            if((cur->error[Y_AXIS] -= cur->delta[Y_AXIS]) < 0)
+            {
+                cur->startYStep();
+                cur->error[Y_AXIS] += cur_errupd;
+            }
+        }
+#if defined(XY_GANTRY)
+        if(BRESENHAM_MOVES(BRESENHAM_X | BRESENHAM_Y,true))
+            Printer::executeXYGantrySteps();
+#endif
+
+        if(BRESENHAM_MOVES(BRESENHAM_Z,cur->isZMove()))
+        {
+            if((cur->error[Z_AXIS] -= cur->delta[Z_AXIS]) < 0)
+            {
+                cur->startZStep();
+                cur->error[Z_AXIS] += cur_errupd;
+#ifdef DEBUG_STEPCOUNT
+                cur->totalStepsRemaining--;
+#endif
+            }
+#if FEATURE_BABYSTEPPING
+            else if(loop == 0 && Printer::zBabystepsMissing)
+                cur->zBabystepWithZMove();
+#endif
+        }
+#if FEATURE_BABYSTEPPING
+        else if(loop == 0 && Printer::zBabystepsMissing)
+            cur->zBabystepWithoutZMove();
+#endif
+
+        if (BRESENHAM_MOVES(BRESENHAM_L,true) && cur->has_L) // has_L turns off when laser data is used up
+        {
+            if((cur->error[L_AXIS] -= cur->delta[L_AXIS]) < 0)
+            {
+                uint8_t power = BoXZYLBuffer.pop();
+                set_laser(power);
+                cur->has_L = (BoXZYLBuffer.oldest_index != cur->L_end_index);
+                cur->error[L_AXIS] += cur_errupd;
+            }
+        }
+
+        Printer::insertStepperHighDelay();
+        if(BRESENHAM_MOVES(BRESENHAM_E,true))
+        {
+#if defined(USE_ADVANCE)
+            if(!Printer::isAdvanceActivated()) // Use interrupt for movement
+#endif
+                Extruder::unstep();
+        }
+        Printer::endXYZSteps();
+    } // for loop
+}
+#undef BRESENHAM_MOVES
+
+/**
+  Chooses the Bresenham loop for the current move. Common axis combinations get their own
+  loop without any axis tests, all others use the generic one.
+*/
+inline void PrintLine::selectBresenhamLoop()
+{
+    uint8_t axes = ((cur->dir >> 4) & 15) | (cur->has_L ? BRESENHAM_L : 0);
+    switch(axes)
+    {
+    case BRESENHAM_X:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_X>;
+        break;
+    case BRESENHAM_Y:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_Y>;
+        break;
+    case BRESENHAM_X | BRESENHAM_Y:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_X | BRESENHAM_Y>;
+        break;
+    case BRESENHAM_X | BRESENHAM_L: // Raster lines
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_X | BRESENHAM_L>;
+        break;
+    case BRESENHAM_Y | BRESENHAM_L:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_Y | BRESENHAM_L>;
+        break;
+    case BRESENHAM_X | BRESENHAM_Y | BRESENHAM_L: // Vector cuts
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_X | BRESENHAM_Y | BRESENHAM_L>;
+        break;
+    case BRESENHAM_Z:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_Z>;
+        break;
+    case BRESENHAM_X | BRESENHAM_Y | BRESENHAM_Z: // Milling
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_X | BRESENHAM_Y | BRESENHAM_Z>;
+        break;
+    case BRESENHAM_X | BRESENHAM_Y | BRESENHAM_E: // Printing
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_X | BRESENHAM_Y | BRESENHAM_E>;
+        break;
+    case BRESENHAM_E:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_E>;
+        break;
+    default:
+        bresenhamLoopFunc = &bresenhamLoop<BRESENHAM_ANY>;
+    }
+}
+
+/** Releases laser data and removes the finished current move from the cache. */
+inline void PrintLine::finishCurrentLine()
+{
+#ifdef DEBUG_STEPCOUNT
+    if(cur->totalStepsRemaining)
+    {
+        Com::printF(Com::tDBGMissedSteps,cur->totalStepsRemaining);
+        Com::printFLN(Com::tComma,cur->stepsRemaining);
+    }
+#endif
+    if (Printer::BoXZY_head == BoXZY_Laser_head)
+    {
+        if (cur->has_L)
+        {
+            while (BoXZYLBuffer.oldest_index != cur->L_end_index
+                    && BoXZYLBuffer.oldest_index != BoXZYLBuffer.unclaimed_index)
+            {
+                BoXZYLBuffer.pop();
+            }
+            cur->has_L = false;
+        }
+
+        if (!Printer::is_L_in_focus_mode)
+        {
+            set_laser(0);
+        }
+    }
+
+#if FEATURE_STEP_SEGMENTS
+    segmentStepsLeft = 0;
+#endif
+#if FEATURE_LIVE_OVERRIDES
+    overrideRampStart = 0;
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    if(Printer::feedHoldState == FEED_HOLD_RESUMED)
+        Printer::feedHoldState = FEED_HOLD_NONE;
+    else if(Printer::feedHoldState == FEED_HOLD_DECELERATING) // Move ended before hold speed was reached
+    {
+        Printer::feedHoldVEnd = 0;
+        Printer::feedHoldState = FEED_HOLD_STOPPED;
+    }
+#endif
+    removeCurrentLineForbidInterrupt();
+    Printer::disableAllowedStepper();
+    if(linesCount == 0) UI_STATUS(UI_TEXT_IDLE);
+}
+
 /**
   Moves the stepper motors one step. If the last step is reached, the next movement is started.
   The function must be called from a timer loop. It returns the time for the next call.
 
   Normal non delta algorithm
 */
-int lastblk=-1;
-long cur_errupd;
 long PrintLine::bresenhamStep() // version for cartesian printer
 {
 #if CPU_ARCH==ARCH_ARM
@@ -2063,10 +2906,18 @@ long PrintLine::bresenhamStep() // version for cartesian printer
     if(cur == NULL)
 #endif
     {
+#if FEATURE_REALTIME_COMMANDS
+        if(Printer::isFeedHold() && Printer::feedHoldState != FEED_HOLD_RESUME)
+        {
+            Printer::feedHoldState = FEED_HOLD_STOPPED; // Hold between two moves
+            return 2000;
+        }
+#endif
         ANALYZER_ON(ANALYZER_CH0);
         setCurrentLine();
         if(cur->isBlocked())   // This step is in computation - shouldn't happen
         {
+            blockedStalls++;
             /*if(lastblk!=(int)cur) // can cause output errors!
             {
                 HAL::allowInterrupts();
@@ -2107,6 +2958,16 @@ long PrintLine::bresenhamStep() // version for cartesian printer
             removeCurrentLineForbidInterrupt();
             return(wait); // waste some time for path optimization to fill up
         } // End if WARMUP
+#if FEATURE_TIME_ESTIMATION
+        if(Printer::debugEstimateTime())   // plan the move like a real one, but only add up its time
+        {
+            cur->addEstimatedTime();
+            if(cur->has_L) // Drop the laser data of the move
+                while(BoXZYLBuffer.oldest_index != cur->L_end_index) BoXZYLBuffer.pop();
+            removeCurrentLineForbidInterrupt();
+            return 1000;
+        }
+#endif
         //Only enable axis that are moving. If the axis doesn't need to move then it can stay disabled depending on configuration.
 #ifdef XY_GANTRY
         if(cur->isXOrYMove())
@@ -2123,31 +2984,18 @@ long PrintLine::bresenhamStep() // version for cartesian printer
             Printer::enableZStepper();
         }
         if(cur->isEMove()) Extruder::enable();
-        cur->fixStartAndEndSpeed();
         HAL::allowInterrupts();
         cur_errupd = (cur->isFullstepping() ? cur->delta[cur->primaryAxis] : cur->delta[cur->primaryAxis]<<1);;
-        if(!cur->areParameterUpToDate())  // should never happen, but with bad timings???
-        {
-            cur->updateStepsParameter();
-        }
+        selectBresenhamLoop();
         Printer::vMaxReached = cur->vStart;
         Printer::stepNumber=0;
         Printer::timer = 0;
+#if ENABLE_BACKLASH_COMPENSATION
+        Printer::startBacklashTakeup(cur->backlashAxes);
+#endif
         HAL::forbidInterrupts();
         //Determine direction of movement,check if endstop was hit
-#if !defined(XY_GANTRY)
-        Printer::setXDirection(cur->isXPositiveMove());
-        Printer::setYDirection(cur->isYPositiveMove());
-#else
-        long gdx = (cur->dir & 1 ? cur->delta[0] : -cur->delta[0]); // Compute signed difference in steps
-        long gdy = (cur->dir & 2 ? cur->delta[1] : -cur->delta[1]);
-        Printer::setXDirection(gdx+gdy>=0);
-#if DRIVE_SYSTEM==1
-        Printer::setYDirection(gdx>gdy);
-#elif DRIVE_SYSTEM==2
-        Printer::setYDirection(gdx<=gdy);
-#endif
-#endif
+        cur->setXYDirection();
         Printer::setZDirection(cur->isZPositiveMove());
 #if defined(USE_ADVANCE)
         if(!Printer::isAdvanceActivated()) // Set direction if no advance/OPS enabled
@@ -2172,6 +3020,55 @@ long PrintLine::bresenhamStep() // version for cartesian printer
             return Printer::interval; // Wait an other 50% from last step to make the 100% full
     } // End cur=0
     HAL::allowInterrupts();
+#if ENABLE_BACKLASH_COMPENSATION
+    if(Printer::isBacklashTakeupRunning()) // take up backlash before the move steps
+        return cur->backlashTakeupStep();
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    if(Printer::isFeedHold())
+    {
+        if(Printer::feedHoldState == FEED_HOLD_STOPPED)
+            return 2000; // Keep the move until resumed
+        if(Printer::feedHoldState == FEED_HOLD_REQUESTED)
+            cur->startFeedHold();
+        else if(Printer::feedHoldState == FEED_HOLD_RESUME)
+            cur->resumeFeedHold();
+    }
+#endif
+#if FEATURE_LIVE_OVERRIDES
+    if(overrideVMax)
+        cur->applySpeedOverride();
+#endif
+#if FEATURE_STEP_SEGMENTS
+    if(segmentStepsLeft || nextSegment())
+    {
+        // Replay precomputed segment, no ramp computation needed. Half stepped moves keep the
+        // even and odd calls of the ramp code below, only even calls count the steps.
+        uint8_t doEven = cur->halfStep & 6;
+        if(cur->halfStep != 4) cur->halfStep = 3 - (cur->halfStep);
+        HAL::forbidInterrupts();
+        if(doEven) cur->checkEndstops();
+        uint8_t max_loops = RMath::min(RMath::min((int32_t)Printer::stepsPerTimerCall,(int32_t)segmentStepsLeft),cur->stepsRemaining);
+        if(cur->stepsRemaining>0)
+        {
+            bresenhamLoopFunc(max_loops);
+            if(doEven)
+            {
+                segmentStepsLeft -= max_loops;
+                Printer::stepNumber += max_loops;
+                cur->stepsRemaining -= max_loops;
+            }
+        }
+        long interval = (cur->isFullstepping() ? Printer::interval : Printer::interval >> 1);
+        if(doEven && (cur->stepsRemaining <= 0 || cur->isNoMove()))
+        {
+            finishCurrentLine();
+            interval = Printer::interval = interval >> 1; // 50% of time to next call to do cur=0
+            DEBUG_MEMORY;
+        }
+        return interval;
+    }
+#endif
     /* For halfstepping, we divide the actions into even and odd actions to split
        time used per loop. */
     uint8_t doEven = cur->halfStep & 6;
@@ -2179,84 +3076,10 @@ long PrintLine::bresenhamStep() // version for cartesian printer
     if(cur->halfStep!=4) cur->halfStep = 3-(cur->halfStep);
     HAL::forbidInterrupts();
     if(doEven) cur->checkEndstops();
-    uint8_t max_loops = RMath::min((long)Printer::stepsPerTimerCall,cur->stepsRemaining);
+    uint8_t max_loops = RMath::min((int32_t)Printer::stepsPerTimerCall,cur->stepsRemaining);
     if(cur->stepsRemaining>0)
     {
-        for(uint8_t loop=0; loop<max_loops; loop++)
-        {
-            ANALYZER_ON(ANALYZER_CH1);
-#if STEPPER_HIGH_DELAY+DOUBLE_STEP_DELAY > 0
-            if(loop>0)
-                HAL::delayMicroseconds(STEPPER_HIGH_DELAY+DOUBLE_STEP_DELAY);
-#endif
-            if(cur->isEMove())
-            {
-                if((cur->error[E_AXIS] -= cur->delta[E_AXIS]) < 0)
-                {
-#if defined(USE_ADVANCE)
-                    if(Printer::isAdvanceActivated())   // Use interrupt for movement
-                    {
-                        if(cur->isEPositiveMove())
-                            Printer::extruderStepsNeeded++;
-                        else
-                            Printer::extruderStepsNeeded--;
-                    }
-                    else
-#endif
-                        Extruder::step();
-                    cur->error[E_AXIS] += cur_errupd;
-                }
-            }
-            if(cur->isXMove())
-            {
-                if((cur->error[X_AXIS] -= cur->delta[X_AXIS]) < 0)
-                {
-                    cur->startXStep();
-                    cur->error[X_AXIS] += cur_errupd;
-                }
-            }
-            if(cur->isYMove())
-            {
-                if((cur->error[Y_AXIS] -= cur->delta[Y_AXIS]) < 0)
-                {
-                    cur->startYStep();
-                    cur->error[Y_AXIS] += cur_errupd;
-                }
-            }
-#if defined(XY_GANTRY)
-            Printer::executeXYGantrySteps();
-#endif
-
-            if(cur->isZMove())
-            {
-                if((cur->error[Z_AXIS] -= cur->delta[Z_AXIS]) < 0)
-                {
-                    cur->startZStep();
-                    cur->error[Z_AXIS] += cur_errupd;
-#ifdef DEBUG_STEPCOUNT
-                    cur->totalStepsRemaining--;
-#endif
-                }
-            }
-
-            if (cur->has_L)
-            {
-                if((cur->error[L_AXIS] -= cur->delta[L_AXIS]) < 0)
-                {
-                    uint8_t power = BoXZYLBuffer.pop();
-                    set_laser(power);
-                    cur->has_L = (BoXZYLBuffer.oldest_index != cur->L_end_index);
-                    cur->error[L_AXIS] += cur_errupd;
-                }
-            }
-
-            Printer::insertStepperHighDelay();
-#if defined(USE_ADVANCE)
-            if(!Printer::isAdvanceActivated()) // Use interrupt for movement
-#endif
-                Extruder::unstep();
-            Printer::endXYZSteps();
-        } // for loop
+        bresenhamLoopFunc(max_loops);
         if(doOdd)  // Update timings
         {
             HAL::allowInterrupts(); // Allow interrupts for other types, timer1 is still disabled
@@ -2267,7 +3090,7 @@ long PrintLine::bresenhamStep() // version for cartesian printer
                 Printer::vMaxReached = HAL::ComputeV(Printer::timer,cur->fAcceleration)+cur->vStart;
                 if(Printer::vMaxReached>cur->vMax) Printer::vMaxReached = cur->vMax;
                 unsigned int v = Printer::updateStepsPerTimerCall(Printer::vMaxReached);
-                Printer::interval = HAL::CPUDivU2(v);
+                Printer::interval = Printer::rampInterval(v);
                 Printer::timer+=Printer::interval;
                 cur->updateAdvanceSteps(Printer::vMaxReached,max_loops,true);
             }
@@ -2281,11 +3104,32 @@ long PrintLine::bresenhamStep() // version for cartesian printer
                     v=Printer::vMaxReached - v;
                     if (v<cur->vEnd) v = cur->vEnd; // extra steps at the end of desceleration due to rounding erros
                 }
+#if FEATURE_REALTIME_COMMANDS
+                if(Printer::feedHoldState == FEED_HOLD_DECELERATING && v <= cur->vEnd)
+                    cur->stopFeedHold();
+#endif
                 cur->updateAdvanceSteps(v,max_loops,false); // needs original v
                 v = Printer::updateStepsPerTimerCall(v);
-                Printer::interval = HAL::CPUDivU2(v);
+                Printer::interval = Printer::rampInterval(v);
                 Printer::timer += Printer::interval;
             }
+#if FEATURE_LIVE_OVERRIDES
+            else if (overrideRampStart)    // changing to new override speed
+            {
+                bool faster = overrideRampStart < cur->vMax;
+                unsigned int v = HAL::ComputeV(Printer::timer,cur->fAcceleration);
+                if(faster)
+                    v = (v >= (unsigned int)(cur->vMax - overrideRampStart) ? cur->vMax : overrideRampStart + v);
+                else
+                    v = (v >= (unsigned int)(overrideRampStart - cur->vMax) ? cur->vMax : overrideRampStart - v);
+                if(v == cur->vMax) overrideRampStart = 0;
+                Printer::vMaxReached = v;
+                cur->updateAdvanceSteps(v,max_loops,faster);
+                v = Printer::updateStepsPerTimerCall(v);
+                Printer::interval = Printer::rampInterval(v);
+                Printer::timer += Printer::interval;
+            }
+#endif
             else // full speed reached
             {
                 cur->updateAdvanceSteps((!cur->accelSteps ? cur->vMax : Printer::vMaxReached),0,true);
@@ -2331,41 +3175,10 @@ long PrintLine::bresenhamStep() // version for cartesian printer
     else interval = Printer::interval;
     if(doEven && (cur->stepsRemaining <= 0 || cur->isNoMove()))   // line finished
     {
-#ifdef DEBUG_STEPCOUNT
-        if(cur->totalStepsRemaining)
-        {
-            Com::printF(Com::tDBGMissedSteps,cur->totalStepsRemaining);
-            Com::printFLN(Com::tComma,cur->stepsRemaining);
-        }
-#endif
-        if (Printer::BoXZY_head == BoXZY_Laser_head)
-        {
-            if (cur->has_L)
-            {
-                while (BoXZYLBuffer.oldest_index != cur->L_end_index
-                        && BoXZYLBuffer.oldest_index != BoXZYLBuffer.unclaimed_index)
-                {
-                    BoXZYLBuffer.pop();
-                }
-                cur->has_L = false;
-            }
-
-            if (!Printer::is_L_in_focus_mode)
-            {
-                set_laser(0);
-            }
-        }
-
-        removeCurrentLineForbidInterrupt();
-        Printer::disableAllowedStepper();
-        if(linesCount == 0) UI_STATUS(UI_TEXT_IDLE);
+        finishCurrentLine();
         interval = Printer::interval = interval >> 1; // 50% of time to next call to do cur=0
         DEBUG_MEMORY;
     } // Do even
-    if(FEATURE_BABYSTEPPING && Printer::zBabystepsMissing)
-    {
-        Printer::zBabystep();
-    }
     return interval;
 }
 #endif
@@ -50,6 +50,13 @@
 #define FLAG_JOIN_WAIT_EXTRUDER_UP 64
 /** Wait for the extruder to finish it's down movement */
 #define FLAG_JOIN_WAIT_EXTRUDER_DOWN 128
+/** Axis masks selecting the Bresenham loop of a move, see PrintLine::selectBresenhamLoop */
+#define BRESENHAM_X 1
+#define BRESENHAM_Y 2
+#define BRESENHAM_Z 4
+#define BRESENHAM_E 8
+#define BRESENHAM_L 16
+#define BRESENHAM_ANY 32 // Check moving axes at runtime
 // Printing related data
 #if NONLINEAR_SYSTEM
 // Allow the delta cache to store segments for every line in line cache. Beware this gets big ... fast.
@@ -157,6 +164,37 @@ typedef struct
 } DeltaSegment;
 extern uint8_t lastMoveID;
 #endif
+#if FEATURE_STEP_SEGMENTS
+/** Part of a move with constant step rate. Segments are computed in the main loop by
+PrintLine::compileSegments and replayed by the stepper interrupt. */
+typedef struct
+{
+    uint8_t linePos;                ///< Index of the move in PrintLine::lines
+    uint8_t stepsPerCall;           ///< Steps executed per timer call (1, 2 or 4)
+    bool decelerating;              ///< Segment is part of the deceleration ramp
+    uint16_t stepEvents;            ///< Primary axis steps in this segment
+    uint32_t firstStep;             ///< Printer::stepNumber at segment start
+    ticks_t interval;               ///< Ticks between two timer calls
+    speed_t vRamp;                  ///< Printer::vMaxReached at segment end
+    ticks_t rampTimer;              ///< Printer::timer at segment end
+} StepSegment;
+#endif
+/** Step parameter of a move. The planner computes them here first and copies them into
+the move in one interrupt protected step, so the stepper interrupt never sees half of a plan.
+startSpeed, endSpeed and joinFlags of a queued move belong to the planner only, the stepper
+interrupt uses nothing but the published vStart, vEnd, accelSteps and decelSteps. */
+typedef struct
+{
+    speed_t vStart;                 ///< Starting speed in steps/s
+    speed_t vEnd;                   ///< End speed in steps/s
+    uint16_t accelSteps;            ///< Number of steps for acceleration
+    uint16_t decelSteps;            ///< Number of steps for deceleration
+#if defined(USE_ADVANCE) && defined(ENABLE_QUADRATIC_ADVANCE)
+    int32_t advanceStart;
+    int32_t advanceEnd;
+#endif
+    uint8_t joinFlags;              ///< Planner flags before the plan, restored if the plan is dropped
+} StepParameter;
 class UIDisplay;
 class PrintLine   // RAM usage: 24*4+15 = 113 Byte
 {
@@ -175,6 +213,9 @@ private:
     int32_t timeInTicks;
     flag8_t halfStep;                  ///< 4 = disabled, 1 = halfstep, 2 = fulstep
     flag8_t dir;                       ///< Direction of movement. 1 = X+, 2 = Y+, 4= Z+, values can be combined.
+#if ENABLE_BACKLASH_COMPENSATION
+    uint8_t backlashAxes;              ///< Axes reversing direction with this move. 1 = X, 2 = Y, 4 = Z
+#endif
     int32_t delta[5];                  ///< Steps we want to move.
     int32_t error[5];                  ///< Error calculation for Bresenham algorithm
     float speedX;                   ///< Speed in x direction at fullInterval in mm/s
@@ -224,6 +265,29 @@ public:
 
     static PrintLine *cur;
     static volatile uint8_t linesCount; // Number of lines cached 0 = nothing to do
+    static StepParameter plannedParameter[MOVE_CACHE_SIZE]; ///< Planned, not yet published step parameter
+    static uint16_t plannerRetries;           ///< Plans dropped because their first move was started meanwhile
+    static uint16_t blockedStalls;            ///< Stepper interrupt calls that found the next move blocked
+#if FEATURE_QUEUE_CONTROL
+    static millis_t lastArrival;              ///< Time the last move was queued
+    static uint16_t arrivalInterval;          ///< Averaged time between queued moves in 1/16 ms
+    static uint16_t queueUnderruns;           ///< Queue ran empty while moves were streamed
+    static uint16_t throttledMoves;           ///< Moves slowed down to keep the queue filled
+#endif
+#if FEATURE_STEP_SEGMENTS
+    static StepSegment segments[STEP_SEGMENT_CACHE_SIZE];
+    static volatile uint8_t segmentReadPos;   ///< Next segment for the stepper interrupt
+    static volatile uint8_t segmentWritePos;  ///< Next free segment for the compiler
+    static uint16_t segmentStepsLeft;         ///< Steps left in the segment currently replayed
+    static uint8_t segmentCompilePos;         ///< Move the compiler is working on
+    static uint32_t segmentCompileStep;       ///< First step of the next segment to compile
+#endif
+#if FEATURE_LIVE_OVERRIDES
+    static volatile speed_t overrideVMax;     ///< New vMax for the printing move, 0 = nothing pending
+    static speed_t overrideVEnd;              ///< New end speed for the printing move
+    static uint8_t overrideLinePos;           ///< Move the pending override was computed for
+    static speed_t overrideRampStart;         ///< Speed the override ramp started with, 0 = no ramp
+#endif
     inline bool areParameterUpToDate()
     {
         return joinFlags & FLAG_JOIN_STEPPARAMS_COMPUTED;
@@ -300,6 +364,13 @@ public:
     {
         if(isCheckEndstops())
         {
+#if FEATURE_FAST_HOMING
+            if(Printer::homingState != HOMING_NONE)
+            {
+                checkHomingEndstops();
+                return;
+            }
+#endif
             if(isXNegativeMove() && Printer::isXMinEndstopHit())
                 setXMoveFinished();
             if(isYNegativeMove() && Printer::isYMinEndstopHit())
@@ -434,6 +505,9 @@ public:
     {
         linesCount = 0;
         linesPos = linesWritePos;
+#if FEATURE_STEP_SEGMENTS
+        resetSegments();
+#endif
     }
     inline void updateAdvanceSteps(speed_t v,uint8_t max_loops,bool accelerate)
     {
@@ -479,7 +553,11 @@ public:
     }
     inline bool moveDecelerating()
     {
-        if(stepsRemaining <= decelSteps)
+        if(stepsRemaining <= decelSteps
+#if FEATURE_REALTIME_COMMANDS
+                || Printer::feedHoldState == FEED_HOLD_DECELERATING
+#endif
+          )
         {
             if (!(flags & FLAG_DECELERATING))
             {
@@ -584,7 +662,96 @@ public:
         WRITE(Z2_STEP_PIN,HIGH);
 #endif
     }
+    /** Sets the x and y motor directions for this move. */
+    inline void setXYDirection()
+    {
+#if !defined(XY_GANTRY)
+        Printer::setXDirection(isXPositiveMove());
+        Printer::setYDirection(isYPositiveMove());
+#else
+        long gdx = (dir & 1 ? delta[0] : -delta[0]); // Compute signed difference in steps
+        long gdy = (dir & 2 ? delta[1] : -delta[1]);
+        Printer::setXDirection(gdx+gdy>=0);
+#if DRIVE_SYSTEM==1
+        Printer::setYDirection(gdx>gdy);
+#elif DRIVE_SYSTEM==2
+        Printer::setYDirection(gdx<=gdy);
+#endif
+#endif
+    }
+#if ENABLE_BACKLASH_COMPENSATION
+    /** Does one backlash takeup step for the axes still missing some and returns the ticks until
+    the next one. The move itself does not step before the takeup is finished. Directions are the
+    ones of the move, with a gantry x and y are taken up one after the other with the motor
+    directions of a pure x or y move. Positions are not changed. */
+    inline ticks_t backlashTakeupStep()
+    {
+        ticks_t wait = 0;
+        HAL::forbidInterrupts();
+#if defined(XY_GANTRY)
+        uint8_t axis = (Printer::backlashMissing[X_AXIS] ? X_AXIS : Y_AXIS);
+        if(Printer::backlashMissing[axis])
+        {
+            bool positive = (axis == X_AXIS ? isXPositiveMove() : isYPositiveMove());
+            Printer::setXDirection(positive);
+#if DRIVE_SYSTEM==1
+            Printer::setYDirection(axis == X_AXIS ? positive : !positive);
+#elif DRIVE_SYSTEM==2
+            Printer::setYDirection(axis == X_AXIS ? !positive : positive);
+#endif
+            if(axis == X_AXIS)
+                startXStep();
+            else
+                startYStep();
+            Printer::executeXYGantrySteps();
+            Printer::backlashMissing[axis]--;
+            wait = Printer::backlashInterval[axis];
+        }
+#else
+        if(Printer::backlashMissing[X_AXIS])
+        {
+            WRITE(X_STEP_PIN,HIGH);
+#if FEATURE_TWO_XSTEPPER
+            WRITE(X2_STEP_PIN,HIGH);
+#endif
+            Printer::backlashMissing[X_AXIS]--;
+            wait = Printer::backlashInterval[X_AXIS];
+        }
+        if(Printer::backlashMissing[Y_AXIS])
+        {
+            WRITE(Y_STEP_PIN,HIGH);
+#if FEATURE_TWO_YSTEPPER
+            WRITE(Y2_STEP_PIN,HIGH);
+#endif
+            Printer::backlashMissing[Y_AXIS]--;
+            if(Printer::backlashInterval[Y_AXIS] > wait)
+                wait = Printer::backlashInterval[Y_AXIS];
+        }
+#endif
+        if(Printer::backlashMissing[Z_AXIS])
+        {
+            startZStep();
+            Printer::backlashMissing[Z_AXIS]--;
+            if(Printer::backlashInterval[Z_AXIS] > wait)
+                wait = Printer::backlashInterval[Z_AXIS];
+        }
+        Printer::insertStepperHighDelay();
+        Printer::endXYZSteps();
+#if defined(XY_GANTRY)
+        if(!Printer::backlashMissing[X_AXIS] && !Printer::backlashMissing[Y_AXIS])
+            setXYDirection(); // back to the motor directions of the move
+#endif
+        HAL::allowInterrupts();
+        return wait;
+    }
+#endif
     void updateStepsParameter();
+#if FEATURE_TIME_ESTIMATION
+    inline void addEstimatedTime();
+#endif
+    inline void computeStepsParameter(StepParameter &p);
+    inline void publishStepsParameter(StepParameter &p);
+    inline void restorePlan(StepParameter &p);
     inline float safeSpeed();
     void calculateMove(float axis_diff[],uint8_t pathOptimize);
     void logLine();
@@ -636,12 +803,39 @@ public:
     }
     static inline void computeMaxJunctionSpeed(PrintLine *previous,PrintLine *current);
     static long bresenhamStep();
+#if !NONLINEAR_SYSTEM
+    template<uint8_t axes> static void bresenhamLoop(uint8_t max_loops);
+#if FEATURE_BABYSTEPPING
+    inline void zBabystepWithZMove();
+    inline void zBabystepWithoutZMove();
+#endif
+    static void (*bresenhamLoopFunc)(uint8_t max_loops);
+    static inline void selectBresenhamLoop();
+#endif
+    static inline void finishCurrentLine();
+#if FEATURE_FAST_HOMING
+    void checkHomingEndstops();
+    inline void startHomingStop();
+#endif
+#if FEATURE_REALTIME_COMMANDS
+    inline speed_t feedHoldSpeed();
+    inline void startFeedHold();
+    inline void stopFeedHold();
+    inline void resumeFeedHold();
+#endif
     static void waitForXFreeLines(uint8_t b=1);
     static inline void forwardPlanner(uint8_t p);
     static inline void backwardPlanner(uint8_t p,uint8_t last);
     static void updateTrapezoids();
     static uint8_t insertWaitMovesIfNeeded(uint8_t pathOptimize, uint8_t waitExtraLines);
+#if FEATURE_QUEUE_CONTROL
+    static void updateArrivalRate();
+    static float queuedTicks();
+#endif
     static void queueCartesianMove(uint8_t check_endstops,uint8_t pathOptimize);
+#if FEATURE_MESH_LEVELING
+    static void queueMeshMove(uint8_t check_endstops,uint8_t pathOptimize);
+#endif
     static void moveRelativeDistanceInSteps(long x,long y,long z,long e,float feedrate,bool waitEnd,bool check_endstop);
     static void moveRelativeDistanceInStepsReal(long x,long y,long z,long e,float feedrate,bool waitEnd);
 #if ARC_SUPPORT
@@ -655,6 +849,30 @@ public:
     {
         p = (p == MOVE_CACHE_SIZE - 1 ? 0 : p + 1);
     }
+    /** Number of moves between the printing move and move p. Values >= linesCount mean
+    the move at p is not queued any more. */
+    static inline uint8_t linesAhead(uint8_t p)
+    {
+        return (p >= linesPos ? p - linesPos : p + MOVE_CACHE_SIZE - linesPos);
+    }
+#if FEATURE_STEP_SEGMENTS
+    static void compileSegments();
+    static inline void resetSegments()
+    {
+        segmentReadPos = segmentWritePos;
+        segmentStepsLeft = 0;
+        segmentCompilePos = linesPos;
+        segmentCompileStep = 0;
+    }
+    static inline bool nextSegment();
+    inline float segmentSpeed(uint32_t step);
+#endif
+#if FEATURE_LIVE_OVERRIDES
+    static void changeSpeedOverride(float ratio);
+    inline float limitSpeedRatio(float ratio);
+    inline void scaleSpeed(float ratio);
+    inline void applySpeedOverride();
+#endif
 #if NONLINEAR_SYSTEM
     static void queueDeltaMove(uint8_t check_endstops,uint8_t pathOptimize, uint8_t softEndstop);
     static inline void queueEMove(long e_diff,uint8_t check_endstops,uint8_t pathOptimize);
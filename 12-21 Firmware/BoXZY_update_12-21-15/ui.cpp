@@ -1163,6 +1163,13 @@ void UIDisplay::parse(char *txt,bool ram)
                 addInt(Printer::feedrateMultiply,3);
                 break;
             }
+#if FEATURE_LIVE_OVERRIDES
+            if(c2=='l')
+            {
+                addInt(get_laser_multiply(),3);
+                break;
+            }
+#endif
             // Extruder output level
             if(c2>='0' && c2<='9') ivalue=pwm_pos[c2-'0'];
 #if HAVE_HEATED_BED
@@ -2280,6 +2287,15 @@ void UIDisplay::nextPreviousAction(int8_t next)
         Com::printFLN(Com::tFlowMultiply,(int)Printer::extrudeMultiply);
     }
     break;
+#if FEATURE_LIVE_OVERRIDES
+    case UI_ACTION_LASER_MULTIPLY:
+    {
+        int lm = get_laser_multiply();
+        INCREMENT_MIN_MAX(lm,1,10,200);
+        Commands::changeLaserMultiply(lm);
+    }
+    break;
+#endif
     case UI_ACTION_STEPPER_INACTIVE:
         stepperInactiveTime -= stepperInactiveTime % 1000;
         INCREMENT_MIN_MAX(stepperInactiveTime,60000UL,0,10080000UL);
@@ -158,6 +158,7 @@
 #define UI_ACTION_ZPOSITION_FAST_NOTEST 1110
 #define UI_ACTION_Z_BABYSTEPS           1111
 #define UI_ACTION_MAX_INACTIVE          1112
+#define UI_ACTION_LASER_MULTIPLY        1113
 
 #define UI_ACTION_MENU_XPOS             4000
 #define UI_ACTION_MENU_YPOS             4001
@@ -191,7 +192,7 @@
 // Load basic language definition to make sure all values are defined
 #include "uilang.h"
 
-typedef struct {
+typedef struct UIMenuEntry_s {
   const char *text; // Menu text
   uint8_t menuType; // 0 = Info, 1 = Headline, 2 = submenu ref, 3 = direct action command, 4 = modify action command
   unsigned int action; // must be int so it gets 32 bit on arm!
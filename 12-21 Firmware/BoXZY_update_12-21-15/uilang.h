@@ -230,6 +230,7 @@
 #define UI_TEXT_PAGE_BED          " B:%eb/%Eb\002C\176%ob"
 #define UI_TEXT_SPEED_MULTIPLY    "Speed Mul.:%om%%%"
 #define UI_TEXT_FLOW_MULTIPLY     "Flow Mul. :%of%%%"
+#define UI_TEXT_LASER_MULTIPLY    "Laser Mul.:%ol%%%"
 #define UI_TEXT_SHOW_MEASUREMENT  "Show meas."
 #define UI_TEXT_RESET_MEASUREMENT "Reset meas."
 #define UI_TEXT_SET_MEASURED_ORIGIN "Set Z=0"
@@ -1708,3 +1709,8 @@
 #define UI_TEXT_STOP_PRINT "Stop Print"
 
 #endif
+
+// Texts not translated yet
+#ifndef UI_TEXT_LASER_MULTIPLY
+#define UI_TEXT_LASER_MULTIPLY    "Laser Mul.:%ol%%%"
+#endif